@@ -0,0 +1,240 @@
+#include "frame_capture.hpp"
+#include "profiler.hpp"
+
+#include <cstdio>
+#ifndef _WIN32
+#include <csignal>
+#endif
+
+// RGBA8 (sRGB̂܂) -> BT.601 ~ebhW Y, Cb, CrBW65536{̌Œ菬_
+static uint8_t rgbToY(int r, int g, int b)
+{
+	return static_cast<uint8_t>((16829 * r + 33039 * g + 6416 * b + (16 << 16) + 32768) >> 16);
+}
+
+static uint8_t rgbToCb(int r, int g, int b)
+{
+	return static_cast<uint8_t>((-9714 * r - 19070 * g + 28784 * b + (128 << 16) + 32768) >> 16);
+}
+
+static uint8_t rgbToCr(int r, int g, int b)
+{
+	return static_cast<uint8_t>((28784 * r - 24103 * g - 4681 * b + (128 << 16) + 32768) >> 16);
+}
+
+// Yʂ̌2x2f𕽋ςCbʂCrʂׂB̒[͓fJԂ
+static void convertRgbaToI420(const uint8_t* pRgba, uint32_t width, uint32_t height, vector<uint8_t>* pYuv)
+{
+	size_t chromaWidth = (width + 1) / 2;
+	size_t chromaHeight = (height + 1) / 2;
+	size_t lumaSize = static_cast<size_t>(width) * height;
+	size_t chromaSize = chromaWidth * chromaHeight;
+	pYuv->resize(lumaSize + chromaSize * 2);
+	uint8_t* pY = pYuv->data();
+	uint8_t* pCb = pY + lumaSize;
+	uint8_t* pCr = pCb + chromaSize;
+
+	for (size_t i = 0; i < lumaSize; i++)
+	{
+		const uint8_t* p = pRgba + i * 4;
+		pY[i] = rgbToY(p[0], p[1], p[2]);
+	}
+	for (size_t y = 0; y < chromaHeight; y++)
+	{
+		const uint8_t* pRow0 = pRgba + y * 2 * width * 4;
+		const uint8_t* pRow1 = y * 2 + 1 < height ? pRow0 + static_cast<size_t>(width) * 4 : pRow0;
+		for (size_t x = 0; x < chromaWidth; x++)
+		{
+			size_t x0 = x * 2 * 4;
+			size_t x1 = x * 2 + 1 < width ? x0 + 4 : x0;
+			int rgb[3];
+			for (int c = 0; c < 3; c++)
+			{
+				rgb[c] = (pRow0[x0 + c] + pRow0[x1 + c] + pRow1[x0 + c] + pRow1[x1 + c] + 2) / 4;
+			}
+			pCb[y * chromaWidth + x] = rgbToCb(rgb[0], rgb[1], rgb[2]);
+			pCr[y * chromaWidth + x] = rgbToCr(rgb[0], rgb[1], rgb[2]);
+		}
+	}
+}
+
+FrameCapture::~FrameCapture()
+{
+	close();
+}
+
+void FrameCapture::open(const CaptureSettings& captureSettings)
+{
+	settings = captureSettings;
+	if (settings.queueFrames == 0)
+	{
+		throw runtime_error("capture queue must hold at least one frame");
+	}
+
+	pipe = !settings.path.empty() && settings.path[0] == '|';
+	if (pipe)
+	{
+		string command = settings.path.substr(1);
+#ifdef _WIN32
+		pOutput = _popen(command.c_str(), "wb");
+#else
+		signal(SIGPIPE, SIG_IGN); // GR[_ɏIfwrite̎sƂĈ
+		pOutput = popen(command.c_str(), "w");
+#endif
+	}
+	else
+	{
+		pOutput = fopen(settings.path.c_str(), "wb");
+	}
+	if (pOutput == nullptr)
+	{
+		throw runtime_error("failed to open capture output: " + settings.path);
+	}
+
+	// 傫͍ŏ̃t[Ō܂̂ŁAf̃͂̎Ɋmۂ
+	buffers.resize(settings.queueFrames);
+	for (uint32_t i = 0; i < settings.queueFrames; i++)
+	{
+		freeBuffers.push_back(i);
+	}
+	writer = thread(&FrameCapture::writerLoop, this);
+}
+
+void FrameCapture::push(const ReadbackFrame& frame)
+{
+	PROFILE_ZONE("capture push");
+	uint32_t index;
+	{
+		unique_lock<mutex> lock(queueMutex);
+		if (failed)
+		{
+			throw runtime_error("failed to write capture: " + settings.path);
+		}
+		if (width == 0)
+		{
+			width = frame.width;
+			height = frame.height;
+		}
+		if (frame.width != width || frame.height != height)
+		{
+			resizedFrames++;
+			return;
+		}
+		if (settings.policy == CaptureDropPolicy::Wait)
+		{
+			queueChanged.wait(lock, [&]() { return !freeBuffers.empty() || failed; });
+			if (failed)
+			{
+				throw runtime_error("failed to write capture: " + settings.path);
+			}
+		}
+		else if (freeBuffers.empty())
+		{
+			droppedFrames++;
+			return;
+		}
+		index = freeBuffers.front();
+		freeBuffers.pop_front();
+	}
+
+	// oobt@͂̃Xbĥ̂Ȃ̂ŃbN̊OŃRs[
+	CaptureBuffer& buffer = buffers[index];
+	buffer.frame = frame.frame;
+	buffer.rgba.assign(frame.pRgba, frame.pRgba + static_cast<size_t>(frame.width) * frame.height * 4);
+
+	{
+		lock_guard<mutex> lock(queueMutex);
+		queuedBuffers.push_back(index);
+	}
+	queueChanged.notify_all();
+}
+
+void FrameCapture::close()
+{
+	if (pOutput == nullptr)
+	{
+		return;
+	}
+	{
+		lock_guard<mutex> lock(queueMutex);
+		stopping = true;
+	}
+	queueChanged.notify_all();
+	writer.join();
+
+#ifdef _WIN32
+	int result = pipe ? _pclose(pOutput) : fclose(pOutput);
+#else
+	int result = pipe ? pclose(pOutput) : fclose(pOutput);
+#endif
+	pOutput = nullptr;
+
+	cout << "capture: " << writtenFrames << " frames written to " << settings.path;
+	if (droppedFrames > 0)
+	{
+		cout << ", " << droppedFrames << " dropped (queue full)";
+	}
+	if (resizedFrames > 0)
+	{
+		cout << ", " << resizedFrames << " dropped (size changed)";
+	}
+	if (failed || result != 0)
+	{
+		cout << ", write failed";
+	}
+	cout << endl;
+}
+
+// L[ł~߂w܂ő҂B~߂鎞͎c؂ĂI
+void FrameCapture::writerLoop()
+{
+	setProfileThreadName("CPU capture");
+	bool headerWritten = false;
+	while (true)
+	{
+		uint32_t index;
+		{
+			unique_lock<mutex> lock(queueMutex);
+			queueChanged.wait(lock, [&]() { return !queuedBuffers.empty() || stopping; });
+			if (queuedBuffers.empty())
+			{
+				return;
+			}
+			index = queuedBuffers.front();
+			queuedBuffers.pop_front();
+		}
+
+		if (!failed)
+		{
+			if (!headerWritten && settings.format == CaptureFormat::Y4m)
+			{
+				fprintf(pOutput, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n", width, height, settings.fps);
+			}
+			headerWritten = true;
+			writeFrame(buffers[index]);
+		}
+
+		{
+			lock_guard<mutex> lock(queueMutex);
+			failed = failed || ferror(pOutput) != 0;
+			freeBuffers.push_back(index);
+		}
+		queueChanged.notify_all();
+	}
+}
+
+void FrameCapture::writeFrame(const CaptureBuffer& buffer)
+{
+	PROFILE_ZONE("capture write");
+	if (settings.format == CaptureFormat::Raw)
+	{
+		fwrite(buffer.rgba.data(), 1, buffer.rgba.size(), pOutput);
+	}
+	else
+	{
+		convertRgbaToI420(buffer.rgba.data(), width, height, &yuv);
+		fputs("FRAME\n", pOutput);
+		fwrite(yuv.data(), 1, yuv.size(), pOutput);
+	}
+	writtenFrames++;
+}
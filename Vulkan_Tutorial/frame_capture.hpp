@@ -0,0 +1,76 @@
+#pragma once
+
+#include "my_vulkan.hpp"
+
+#include <condition_variable>
+#include <mutex>
+
+// ǂݖ߂t[oXbhŃt@CpCv (GR[_) ֗
+enum class CaptureFormat
+{
+	Raw, // RGBA8l߂ĕׂ邾 (ffmpeg -f rawvideo -pix_fmt rgba -s WxH -r fps -i -)
+	Y4m, // YUV4MPEG2 4:2:0 (BT.601 ~ebhW)Bffmpeg -i - ł̂܂ܓǂ߂
+};
+
+enum class CaptureDropPolicy
+{
+	Drop, // L[tȂ炻̃t[̂ĂB`͎~߂Ȃ
+	Wait, // 󂭂܂ő҂ (`悪ȏ܂ŗBSt[KvȃwbhX)
+};
+
+struct CaptureSettings
+{
+	string path; // ȂL^ȂB"|R}h" Ȃ炻̃R}h̕W͂֏
+	CaptureFormat format = CaptureFormat::Y4m;
+	CaptureDropPolicy policy = CaptureDropPolicy::Drop;
+	uint32_t queueFrames = 4; // o҂ɂłt[ (ꂾ̃t[̃Ɋmۂ)
+	uint32_t fps = 60; // Y4M̃wb_ɏt[[g
+};
+
+class FrameCapture
+{
+public:
+	FrameCapture() = default;
+	~FrameCapture();
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	// o͂JďoXbhn߂BJȂruntime_error𓊂
+	void open(const CaptureSettings& settings);
+	// ǂݖ߂̃R[obNĂԁBfL[փRs[邾ŁAϊƏ݂͏oXbhł
+	// ݂ɎsĂruntime_error𓊂
+	void push(const ReadbackFrame& frame);
+	// c؂ăXbh~߁Ao͂
+	void close();
+
+private:
+	struct CaptureBuffer
+	{
+		uint64_t frame;
+		vector<uint8_t> rgba;
+	};
+
+	void writerLoop();
+	void writeFrame(const CaptureBuffer& buffer);
+
+	CaptureSettings settings;
+	FILE* pOutput = nullptr;
+	bool pipe = false;
+	thread writer;
+
+	mutex queueMutex;
+	condition_variable queueChanged;
+	vector<CaptureBuffer> buffers;
+	deque<uint32_t> freeBuffers;
+	deque<uint32_t> queuedBuffers;
+	bool stopping = false;
+	bool failed = false;
+
+	// ŏ̃t[̑傫Brŕςt[͏Ȃ̂Ŏ̂Ă
+	uint32_t width = 0;
+	uint32_t height = 0;
+	vector<uint8_t> yuv; // oXbhG
+	uint64_t writtenFrames = 0;
+	uint64_t droppedFrames = 0;
+	uint64_t resizedFrames = 0;
+};
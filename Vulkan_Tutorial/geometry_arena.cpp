@@ -0,0 +1,84 @@
+#include "geometry_arena.hpp"
+
+bool allocateRange(vector<GeometryRange>* pFreeRanges, uint64_t size, uint64_t* pOffset)
+{
+	if (size == 0)
+	{
+		*pOffset = 0;
+		return true;
+	}
+
+	auto best = pFreeRanges->end();
+	for (auto it = pFreeRanges->begin(); it != pFreeRanges->end(); ++it)
+	{
+		if (it->size >= size && (best == pFreeRanges->end() || it->size < best->size))
+		{
+			best = it;
+		}
+	}
+	if (best == pFreeRanges->end())
+	{
+		return false;
+	}
+
+	*pOffset = best->offset;
+	best->offset += size;
+	best->size -= size;
+	if (best->size == 0)
+	{
+		pFreeRanges->erase(best);
+	}
+	return true;
+}
+
+void freeRange(vector<GeometryRange>* pFreeRanges, uint64_t offset, uint64_t size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+
+	auto next = lower_bound(pFreeRanges->begin(), pFreeRanges->end(), offset,
+		[](const GeometryRange& range, uint64_t value) { return range.offset < value; });
+
+	bool mergePrev = next != pFreeRanges->begin() && prev(next)->offset + prev(next)->size == offset;
+	bool mergeNext = next != pFreeRanges->end() && offset + size == next->offset;
+	if (mergePrev && mergeNext)
+	{
+		prev(next)->size += size + next->size;
+		pFreeRanges->erase(next);
+	}
+	else if (mergePrev)
+	{
+		prev(next)->size += size;
+	}
+	else if (mergeNext)
+	{
+		next->offset = offset;
+		next->size += size;
+	}
+	else
+	{
+		pFreeRanges->insert(next, { offset, size });
+	}
+}
+
+uint64_t totalFreeRange(const vector<GeometryRange>& freeRanges)
+{
+	uint64_t total = 0;
+	for (const auto& range : freeRanges)
+	{
+		total += range.size;
+	}
+	return total;
+}
+
+uint64_t largestFreeRange(const vector<GeometryRange>& freeRanges)
+{
+	uint64_t largest = 0;
+	for (const auto& range : freeRanges)
+	{
+		largest = max(largest, range.size);
+	}
+	return largest;
+}
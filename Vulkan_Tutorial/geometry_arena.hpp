@@ -0,0 +1,14 @@
+#pragma once
+
+#include "my_vulkan.hpp"
+
+// WIgA[i̋󂫗̈̊Ǘ (Pʂ͌Ăяo߂B_CfbNX)
+// 󂫗̈̓ItZbgɕׁAɗׂ̋󂫂ƌ
+
+// ܂钆ōł󂫂؂o (best fit)B󂫂false
+bool allocateRange(vector<GeometryRange>* pFreeRanges, uint64_t size, uint64_t* pOffset);
+
+void freeRange(vector<GeometryRange>* pFreeRanges, uint64_t offset, uint64_t size);
+
+uint64_t totalFreeRange(const vector<GeometryRange>& freeRanges);
+uint64_t largestFreeRange(const vector<GeometryRange>& freeRanges);
@@ -1,13 +1,257 @@
 #include <iostream>
 
 #include "my_vulkan.hpp"
+#include "frame_capture.hpp"
 
-int main()
+// \Evt@CEx`}[NE^EGPUEf̐ݒǂށBmȂIvVruntime_errorɂ
+static void parseSettings(int argc, char** argv, PresentSettings* pSettings, ProfilerSettings* pProfiler, BenchmarkSettings* pBenchmark,
+	CaptureSettings* pCapture, string* pDevice, string* pModel)
+{
+	PresentSettings& settings = *pSettings;
+	for (int i = 1; i < argc; i++)
+	{
+		string option = argv[i];
+		string value = i + 1 < argc ? argv[i + 1] : "";
+		if (option == "--low-latency")
+		{
+			settings.lowLatency = true;
+			continue;
+		}
+		if (option == "--headless")
+		{
+			pBenchmark->headless = true;
+			continue;
+		}
+		if (option == "--readback")
+		{
+			pBenchmark->readback = true;
+			continue;
+		}
+		if (value.empty())
+		{
+			throw runtime_error("missing value for " + option);
+		}
+		i++;
+
+		auto number = [&]()
+		{
+			double result = -1.0;
+			try
+			{
+				result = stod(value);
+			}
+			catch (const exception&)
+			{
+			}
+			if (result < 0.0)
+			{
+				throw runtime_error("invalid value for " + option + ": " + value);
+			}
+			return result;
+		};
+
+		if (option == "--present-mode")
+		{
+			const pair<const char*, VkPresentModeKHR> modes[] = {
+				{ "immediate", VK_PRESENT_MODE_IMMEDIATE_KHR },
+				{ "mailbox", VK_PRESENT_MODE_MAILBOX_KHR },
+				{ "fifo", VK_PRESENT_MODE_FIFO_KHR },
+				{ "fifo-relaxed", VK_PRESENT_MODE_FIFO_RELAXED_KHR },
+			};
+			auto it = find_if(begin(modes), end(modes), [&](const auto& mode) { return value == mode.first; });
+			if (it == end(modes))
+			{
+				throw runtime_error("unknown present mode: " + value);
+			}
+			settings.presentMode = it->second;
+		}
+		else if (option == "--frames-in-flight")
+		{
+			settings.framesInFlight = static_cast<uint32_t>(number());
+		}
+		else if (option == "--swapchain-images")
+		{
+			settings.swapchainImages = static_cast<uint32_t>(number());
+		}
+		else if (option == "--fps")
+		{
+			settings.targetFps = value == "refresh" ? -1.0 : number();
+		}
+		else if (option == "--frames")
+		{
+			pBenchmark->frames = static_cast<uint32_t>(number());
+		}
+		else if (option == "--warmup")
+		{
+			pBenchmark->warmupFrames = static_cast<uint32_t>(number());
+		}
+		else if (option == "--size")
+		{
+			size_t x = value.find('x');
+			try
+			{
+				pBenchmark->width = static_cast<uint32_t>(stoul(value.substr(0, x)));
+				pBenchmark->height = static_cast<uint32_t>(stoul(value.substr(x + 1)));
+			}
+			catch (const exception&)
+			{
+				x = string::npos;
+			}
+			if (x == string::npos || pBenchmark->width == 0 || pBenchmark->height == 0)
+			{
+				throw runtime_error("invalid value for " + option + ": " + value);
+			}
+		}
+		else if (option == "--frame-time")
+		{
+			pBenchmark->frameTime = number();
+		}
+		else if (option == "--stats")
+		{
+			pBenchmark->statsPath = value;
+		}
+		else if (option == "--capture")
+		{
+			pCapture->path = value;
+		}
+		else if (option == "--capture-format")
+		{
+			if (value != "raw" && value != "y4m")
+			{
+				throw runtime_error("unknown capture format: " + value);
+			}
+			pCapture->format = value == "raw" ? CaptureFormat::Raw : CaptureFormat::Y4m;
+		}
+		else if (option == "--capture-policy")
+		{
+			if (value != "drop" && value != "wait")
+			{
+				throw runtime_error("unknown capture policy: " + value);
+			}
+			pCapture->policy = value == "drop" ? CaptureDropPolicy::Drop : CaptureDropPolicy::Wait;
+		}
+		else if (option == "--capture-queue")
+		{
+			pCapture->queueFrames = static_cast<uint32_t>(number());
+		}
+		else if (option == "--capture-fps")
+		{
+			pCapture->fps = static_cast<uint32_t>(number());
+			if (pCapture->fps == 0)
+			{
+				throw runtime_error("invalid value for " + option + ": " + value);
+			}
+		}
+		else if (option == "--memory-report")
+		{
+			pProfiler->memoryReportPath = value;
+		}
+		else if (option == "--trace")
+		{
+			pProfiler->tracePath = value;
+		}
+		else if (option == "--trace-frames")
+		{
+			size_t colon = value.find(':');
+			string first = value.substr(0, colon);
+			string last = colon == string::npos ? first : value.substr(colon + 1);
+			try
+			{
+				pProfiler->firstFrame = first.empty() ? 0 : stoull(first);
+				pProfiler->lastFrame = last.empty() ? numeric_limits<uint64_t>::max() : stoull(last);
+			}
+			catch (const exception&)
+			{
+				throw runtime_error("invalid value for " + option + ": " + value);
+			}
+			if (pProfiler->firstFrame > pProfiler->lastFrame)
+			{
+				throw runtime_error("invalid value for " + option + ": " + value);
+			}
+		}
+		else if (option == "--device")
+		{
+			*pDevice = value;
+		}
+		else if (option == "--model")
+		{
+			*pModel = value;
+		}
+		else
+		{
+			throw runtime_error("unknown option: " + option);
+		}
+	}
+}
+
+int main(int argc, char** argv)
 {
 	Vulkan app;
 
 	try {
-		app.run();
+		// --convert-mesh <file>     : <file>.meshcache ďI
+		// --bench-mesh-cache <file> : t@CƃLbV̓ǂݍݎԂׂďI
+		// ȊO͕\̐ݒ
+		// --present-mode <immediate|mailbox|fifo|fifo-relaxed> : mailbox (Ȃfifo)
+		// --frames-in-flight <n>    : CPUsłt[ ( 2)
+		// --swapchain-images <n>    : Xbv`F[̉摜 ( minImageCount + 1)
+		// --fps <n|refresh>         : t[[g̏ (refresh̓j^̃tbV[g)
+		// --low-latency             : Õt[\Ă玟̃t[̓͂ǂ
+		// --headless                : EBhE炸ItXN[ɕ`ČvAʂJSONŏoďI
+		//                             (fBXvC̖BlavapipeȂ VK_ICD_FILENAMES=.../lvp_icd.x86_64.json)
+		// --frames <n>              : vt[ ( 1000)
+		// --warmup <n>              : vOɎ̂Ăt[ ( 30)
+		// --size <w>x<h>            : ItXN[̑傫 ( 800x600)
+		// --frame-time <s>          : 1t[Ői߂V[̎ ( 1/60)
+		// --stats <file>            : ʂJSON̏o͐ ( Wo)
+		// --readback                : `摜𖈃t[ǂݖ߂ (񓯊Bt[xRGBAɂȂ)
+		// --capture <file|"|cmd">  : `t[St@CAR}h̕W͂֏
+		//                             ( --capture "|ffmpeg -y -i - out.mp4")
+		// --capture-format <y4m|raw>: y4m (4:2:0)BrawRGBA8ׂ邾
+		// --capture-policy <drop|wait> : oǂȂɎ̂Ă邩҂ ( drop)
+		// --capture-queue <n>       : o҂ɂłt[ ( 4)
+		// --capture-fps <n>         : Y4Mɏt[[g ( 60)
+		// --trace <file>            : ICPUGPŰԂChrome trace (JSON) ŏ
+		// --memory-report <file>    : IGPU̗prʁEq[vʂ݂̌ƍő̃oCgJSONŏ
+		// --trace-frames <a:b>      : g[Xɓt[͈̔ (a:  :b B͒߂̑S)
+		// --device <n|name>         : gGPU̔ԍÖꕔ (ϐ VULKAN_TUTORIAL_DEVICE łB͓_̈ԍ)
+		// --model <file>            : ` .obj / .glb ( MODEL_PATHAȂgݍ݂̎lp`)B--headless ƍ킹΂̃fŌv
+		string option = argc >= 3 ? argv[1] : "";
+		if (option == "--convert-mesh")
+		{
+			app.convertMesh(argv[2]);
+		}
+		else if (option == "--bench-mesh-cache")
+		{
+			app.benchmarkMeshCache(argv[2]);
+		}
+		else
+		{
+			PresentSettings presentSettings;
+			ProfilerSettings profilerSettings;
+			BenchmarkSettings benchmarkSettings;
+			CaptureSettings captureSettings;
+			string device;
+			string model = MODEL_PATH;
+			parseSettings(argc, argv, &presentSettings, &profilerSettings, &benchmarkSettings, &captureSettings, &device, &model);
+			app.setDeviceOverride(device);
+			app.setModelPath(model);
+			app.setPresentSettings(presentSettings);
+			app.setProfilerSettings(profilerSettings);
+			app.setBenchmarkSettings(benchmarkSettings);
+			FrameCapture capture;
+			if (!captureSettings.path.empty())
+			{
+				capture.open(captureSettings);
+				app.setReadbackCallback([&](const ReadbackFrame& frame) { capture.push(frame); });
+			}
+			else if (benchmarkSettings.readback)
+			{
+				app.setReadbackCallback([](const ReadbackFrame&) {});
+			}
+			app.run();
+			capture.close();
+		}
 	}
 	catch (const exception& e)
 	{
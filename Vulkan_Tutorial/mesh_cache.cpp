@@ -0,0 +1,254 @@
+#include "mesh_cache.hpp"
+
+#include <filesystem>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT;
+}
+
+//=================================================================
+// Mapped File
+//=================================================================
+
+bool mapFile(const string& path, MappedFile* pFile)
+{
+	*pFile = MappedFile{};
+#ifdef _WIN32
+	pFile->file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (pFile->file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(pFile->file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(pFile->file);
+		return false;
+	}
+	pFile->mapping = CreateFileMappingA(pFile->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (pFile->mapping == nullptr)
+	{
+		CloseHandle(pFile->file);
+		return false;
+	}
+	pFile->pData = static_cast<const uint8_t*>(MapViewOfFile(pFile->mapping, FILE_MAP_READ, 0, 0, 0));
+	if (pFile->pData == nullptr)
+	{
+		CloseHandle(pFile->mapping);
+		CloseHandle(pFile->file);
+		return false;
+	}
+	pFile->size = static_cast<size_t>(size.QuadPart);
+#else
+	pFile->fd = open(path.c_str(), O_RDONLY);
+	if (pFile->fd < 0)
+	{
+		return false;
+	}
+	struct stat st{};
+	if (fstat(pFile->fd, &st) != 0 || st.st_size == 0)
+	{
+		close(pFile->fd);
+		return false;
+	}
+	void* pData = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, pFile->fd, 0);
+	if (pData == MAP_FAILED)
+	{
+		close(pFile->fd);
+		return false;
+	}
+	pFile->pData = static_cast<const uint8_t*>(pData);
+	pFile->size = static_cast<size_t>(st.st_size);
+#endif
+	return true;
+}
+
+void unmapFile(MappedFile* pFile)
+{
+	if (pFile->pData == nullptr)
+	{
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(pFile->pData);
+	CloseHandle(pFile->mapping);
+	CloseHandle(pFile->file);
+#else
+	munmap(const_cast<uint8_t*>(pFile->pData), pFile->size);
+	close(pFile->fd);
+#endif
+	*pFile = MappedFile{};
+}
+
+bool getSourceStamp(const string& path, uint64_t* pSize, int64_t* pTime)
+{
+	error_code error;
+	uintmax_t size = filesystem::file_size(path, error);
+	if (error)
+	{
+		return false;
+	}
+	auto time = filesystem::last_write_time(path, error);
+	if (error)
+	{
+		return false;
+	}
+	*pSize = static_cast<uint64_t>(size);
+	*pTime = static_cast<int64_t>(time.time_since_epoch().count());
+	return true;
+}
+
+//=================================================================
+// Mesh Cache
+//=================================================================
+
+bool openMeshCache(const string& path, const MeshCacheSettings& settings, uint64_t sourceSize, int64_t sourceTime,
+	MappedFile* pFile, MeshCacheData* pData, string* pReason)
+{
+	if (!mapFile(path, pFile))
+	{
+		*pReason = "not found";
+		return false;
+	}
+
+	auto reject = [&](const char* reason)
+	{
+		*pReason = reason;
+		unmapFile(pFile);
+		return false;
+	};
+
+	if (pFile->size < sizeof(MeshCacheHeader))
+	{
+		return reject("truncated header");
+	}
+	MeshCacheHeader header;
+	memcpy(&header, pFile->pData, sizeof(header));
+	if (memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0)
+	{
+		return reject("not a mesh cache");
+	}
+	if (header.version != MESH_CACHE_VERSION || header.headerSize != sizeof(MeshCacheHeader))
+	{
+		return reject("version mismatch");
+	}
+	if (memcmp(&header.settings, &settings, sizeof(settings)) != 0)
+	{
+		return reject("settings changed");
+	}
+	if (header.sourceSize != sourceSize || header.sourceTime != sourceTime)
+	{
+		return reject("source changed");
+	}
+
+	// e\t@CɎ܂ĂāAɕł邱 (ɗvf}Ċ|Žӂh)
+	if (header.vertexCount > pFile->size || header.indexCount > pFile->size || header.lodCount > pFile->size ||
+		header.meshletCount > pFile->size || header.vertexStride > MESH_CACHE_ALIGNMENT ||
+		header.vertexOffset > pFile->size || header.indexOffset > pFile->size ||
+		header.lodOffset > pFile->size || header.meshletOffset > pFile->size)
+	{
+		return reject("corrupt");
+	}
+	uint64_t vertexEnd = header.vertexOffset + header.vertexCount * header.vertexStride;
+	uint64_t indexEnd = header.indexOffset + header.indexCount * header.indexSize;
+	uint64_t lodEnd = header.lodOffset + header.lodCount * sizeof(MeshLod);
+	uint64_t meshletEnd = header.meshletOffset + header.meshletCount * sizeof(MeshletData);
+	bool valid = header.fileSize == pFile->size &&
+		(header.indexSize == 2 || header.indexSize == 4) &&
+		header.vertexOffset >= sizeof(MeshCacheHeader) && header.vertexOffset % MESH_CACHE_ALIGNMENT == 0 &&
+		header.indexOffset >= vertexEnd && header.indexOffset % MESH_CACHE_ALIGNMENT == 0 &&
+		header.lodOffset >= indexEnd && header.lodOffset % MESH_CACHE_ALIGNMENT == 0 &&
+		header.meshletOffset >= lodEnd && header.meshletOffset % MESH_CACHE_ALIGNMENT == 0 &&
+		meshletEnd <= header.fileSize &&
+		header.vertexCount > 0 && header.indexCount > 0 && header.lodCount > 0;
+	if (!valid)
+	{
+		return reject("corrupt");
+	}
+
+	pData->header = header;
+	pData->pVertices = pFile->pData + header.vertexOffset;
+	pData->pIndices = pFile->pData + header.indexOffset;
+	pData->pLods = reinterpret_cast<const MeshLod*>(pFile->pData + header.lodOffset);
+	pData->pMeshlets = reinterpret_cast<const MeshletData*>(pFile->pData + header.meshletOffset);
+
+	for (uint32_t i = 0; i < header.lodCount; i++)
+	{
+		const MeshLod& lod = pData->pLods[i];
+		if (static_cast<uint64_t>(lod.firstIndex) + lod.indexCount > header.indexCount)
+		{
+			return reject("corrupt lod table");
+		}
+	}
+	for (uint32_t i = 0; i < header.meshletCount; i++)
+	{
+		const MeshletData& meshlet = pData->pMeshlets[i];
+		if (static_cast<uint64_t>(meshlet.firstIndex) + meshlet.indexCount > header.indexCount)
+		{
+			return reject("corrupt meshlet table");
+		}
+	}
+	return true;
+}
+
+void writeMeshCache(const string& path, const MeshCacheData& data)
+{
+	MeshCacheHeader header = data.header;
+	memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+	header.version = MESH_CACHE_VERSION;
+	header.headerSize = sizeof(MeshCacheHeader);
+	header.padding = 0;
+
+	uint64_t vertexBytes = header.vertexCount * header.vertexStride;
+	uint64_t indexBytes = header.indexCount * header.indexSize;
+	uint64_t lodBytes = header.lodCount * sizeof(MeshLod);
+	uint64_t meshletBytes = header.meshletCount * sizeof(MeshletData);
+	header.vertexOffset = alignOffset(sizeof(MeshCacheHeader));
+	header.indexOffset = alignOffset(header.vertexOffset + vertexBytes);
+	header.lodOffset = alignOffset(header.indexOffset + indexBytes);
+	header.meshletOffset = alignOffset(header.lodOffset + lodBytes);
+	header.fileSize = header.meshletOffset + meshletBytes;
+
+	string tempPath = path + ".tmp";
+	{
+		ofstream file(tempPath, ios::binary | ios::trunc);
+		if (!file.is_open())
+		{
+			throw runtime_error("failed to create mesh cache: " + tempPath);
+		}
+
+		uint64_t written = 0;
+		auto writeBlock = [&](uint64_t offset, const void* pBlock, uint64_t size)
+		{
+			static const char zeros[MESH_CACHE_ALIGNMENT] = {};
+			file.write(zeros, static_cast<streamsize>(offset - written));
+			file.write(static_cast<const char*>(pBlock), static_cast<streamsize>(size));
+			written = offset + size;
+		};
+		writeBlock(0, &header, sizeof(header));
+		writeBlock(header.vertexOffset, data.pVertices, vertexBytes);
+		writeBlock(header.indexOffset, data.pIndices, indexBytes);
+		writeBlock(header.lodOffset, data.pLods, lodBytes);
+		writeBlock(header.meshletOffset, data.pMeshlets, meshletBytes);
+
+		if (!file)
+		{
+			throw runtime_error("failed to write mesh cache: " + tempPath);
+		}
+	}
+
+	error_code error;
+	filesystem::rename(tempPath, path, error);
+	if (error)
+	{
+		filesystem::remove(tempPath, error);
+		throw runtime_error("failed to replace mesh cache: " + path);
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "my_vulkan.hpp"
+
+// ϊς݃bṼoCiLbV
+// wb_̌256oCgE _(GPU̒_tH[}bĝ܂) / CfbNX(uint16/uint32) / LOD\ / bVbg\ ׂ
+// }bv̈̂܂܃Xe[WOobt@փRs[łAǂݍݎ̉͂̓wb_̌؂
+const char MESH_CACHE_MAGIC[4] = { 'V', 'K', 'M', 'C' };
+const uint32_t MESH_CACHE_VERSION = 1; // `ςグ
+const uint64_t MESH_CACHE_ALIGNMENT = 256;
+const string MESH_CACHE_EXTENSION = ".meshcache";
+
+// ϊɎgݒBႦ΍蒼
+struct MeshCacheSettings
+{
+	uint32_t vertexFormat; // VertexFormat
+	uint32_t optimized; // enableMeshOptimization
+	uint32_t meshlets; // enableClusterCulling
+	uint32_t maxMeshLods;
+	float lodReduction;
+	float lodTargetError;
+	uint32_t meshletMaxVertices;
+	uint32_t meshletMaxTriangles;
+};
+
+struct MeshCacheHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t vertexStride;
+	uint32_t indexSize; // 2 or 4
+	uint32_t lodCount;
+	uint32_t meshletCount;
+	uint32_t padding;
+	MeshCacheSettings settings;
+	uint64_t sourceSize; // t@C̃TCYƍXV
+	int64_t sourceTime;
+	uint64_t fileSize;
+	uint64_t vertexCount;
+	uint64_t indexCount;
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	uint64_t lodOffset;
+	uint64_t meshletOffset;
+	float dequantize[16]; // _̈ʒu -> bV (D)
+	float bounds[4]; // bVԂ̋E
+};
+
+// bVGPUf[^BLbVǂ񂾎̓}bv̈w
+struct MeshCacheData
+{
+	MeshCacheHeader header;
+	const void* pVertices;
+	const void* pIndices;
+	const MeshLod* pLods;
+	const MeshletData* pMeshlets;
+};
+
+struct MappedFile
+{
+	const uint8_t* pData;
+	size_t size;
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#else
+	int fd;
+#endif
+};
+
+// ǂݎpŃ}bvBJȂfalse
+bool mapFile(const string& path, MappedFile* pFile);
+void unmapFile(MappedFile* pFile);
+
+// t@C̃TCYƍXV (Ȃfalse)
+bool getSourceStamp(const string& path, uint64_t* pSize, int64_t* pTime);
+
+// LbV}bvČ؂BEÂEĂ鎞falseԂApReasonɗR
+// pDatã|C^pFile܂ŗL
+bool openMeshCache(const string& path, const MeshCacheSettings& settings, uint64_t sourceSize, int64_t sourceTime,
+	MappedFile* pFile, MeshCacheData* pData, string* pReason);
+
+// ꎞt@CɏĂuBpDatãwb_̓ItZbgȊO𖄂߂ĂBsruntime_error𓊂
+void writeMeshCache(const string& path, const MeshCacheData& data);
@@ -0,0 +1,273 @@
+#include "mesh_clusters.hpp"
+#include "mesh_optimizer.hpp"
+
+// ̈ႤOp`鎞̃RXg (ǉ钸_11Ƃ)
+static const float MESHLET_CONE_WEIGHT = 0.5f;
+
+static glm::vec3 triangleNormal(const vector<Vertex>& vertices, const uint32_t* triangle)
+{
+	const glm::vec3& p0 = vertices[triangle[0]].pos;
+	glm::vec3 normal = glm::cross(vertices[triangle[1]].pos - p0, vertices[triangle[2]].pos - p0);
+	float length = glm::length(normal);
+	return length > 0.0f ? normal / length : glm::vec3(0.0f);
+}
+
+// EƖ@R[ (Optimizing the Graphics Pipeline with Compute, Wihlidal 2016 / meshoptimizer)
+static void computeMeshletBounds(const vector<Vertex>& vertices, const uint32_t* indices, Meshlet* pMeshlet)
+{
+	size_t indexCount = pMeshlet->indexCount;
+
+	glm::vec3 minPos(numeric_limits<float>::max());
+	glm::vec3 maxPos(-numeric_limits<float>::max());
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		minPos = glm::min(minPos, vertices[indices[i]].pos);
+		maxPos = glm::max(maxPos, vertices[indices[i]].pos);
+	}
+	glm::vec3 center = (minPos + maxPos) * 0.5f;
+	float radius = 0.0f;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		radius = max(radius, glm::length(vertices[indices[i]].pos - center));
+	}
+	pMeshlet->center = center;
+	pMeshlet->radius = radius;
+
+	glm::vec3 axis(0.0f);
+	for (size_t i = 0; i < indexCount; i += 3)
+	{
+		axis += triangleNormal(vertices, &indices[i]);
+	}
+	float axisLength = glm::length(axis);
+	pMeshlet->coneApex = center;
+	pMeshlet->coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+	pMeshlet->coneCutoff = 1.0f;
+	if (axisLength <= 0.0f)
+	{
+		return;
+	}
+	axis /= axisLength;
+
+	float minDot = 1.0f;
+	for (size_t i = 0; i < indexCount; i += 3)
+	{
+		glm::vec3 normal = triangleNormal(vertices, &indices[i]);
+		if (normal != glm::vec3(0.0f))
+		{
+			minDot = min(minDot, glm::dot(normal, axis));
+		}
+	}
+
+	// ɋ߂قǍLR[͔肪sŁAقƂǊԈȂ̂ŎgȂ
+	if (minDot <= 0.1f)
+	{
+		return;
+	}
+
+	// SOp`̗̔Ԃɓaxis̓_apexɂ
+	float maxT = 0.0f;
+	for (size_t i = 0; i < indexCount; i += 3)
+	{
+		glm::vec3 normal = triangleNormal(vertices, &indices[i]);
+		if (normal == glm::vec3(0.0f))
+		{
+			continue;
+		}
+		float t = glm::dot(center - vertices[indices[i]].pos, normal) / glm::dot(axis, normal);
+		maxT = max(maxT, t);
+	}
+
+	pMeshlet->coneApex = center - axis * maxT;
+	pMeshlet->coneAxis = axis;
+	pMeshlet->coneCutoff = sqrt(1.0f - minDot * minDot); // @R[̔p90xLĔ]R[cos
+}
+
+void buildMeshlets(const vector<Vertex>& vertices, vector<uint32_t>* pIndices, uint32_t maxVertices, uint32_t maxTriangles,
+	vector<Meshlet>* pMeshlets)
+{
+	const vector<uint32_t>& indices = *pIndices;
+	size_t vertexCount = vertices.size();
+	size_t triangleCount = indices.size() / 3;
+	pMeshlets->clear();
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// _ -> o͂̎Op` (CSR`Ao͂Op`͖ƓւĊO)
+	vector<uint32_t> liveCount(vertexCount, 0);
+	for (uint32_t index : indices)
+	{
+		liveCount[index]++;
+	}
+	vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveCount[v];
+	}
+	vector<uint32_t> adjacency(indices.size());
+	{
+		vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+
+	vector<glm::vec3> normals(triangleCount);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		normals[t] = triangleNormal(vertices, &indices[t * 3]);
+	}
+
+	const uint32_t none = numeric_limits<uint32_t>::max();
+	vector<bool> emitted(triangleCount, false);
+	vector<uint32_t> vertexMeshlet(vertexCount, none); // _Ă郁bVbg
+	vector<uint32_t> meshletVertices;
+	vector<uint32_t> result;
+	result.reserve(indices.size());
+
+	Meshlet meshlet{};
+	uint32_t meshletId = 0;
+	glm::vec3 normalSum(0.0f);
+	size_t cursor = 0; // VbVbg̍ŏ̎Op`Tʒu
+
+	auto finishMeshlet = [&]()
+	{
+		meshlet.indexCount = static_cast<uint32_t>(result.size()) - meshlet.firstIndex;
+		meshlet.vertexCount = static_cast<uint32_t>(meshletVertices.size());
+		computeMeshletBounds(vertices, &result[meshlet.firstIndex], &meshlet);
+		pMeshlets->push_back(meshlet);
+
+		meshlet = Meshlet{};
+		meshlet.firstIndex = static_cast<uint32_t>(result.size());
+		meshletId++;
+		meshletVertices.clear();
+		normalSum = glm::vec3(0.0f);
+	};
+
+	while (true)
+	{
+		uint32_t best = none;
+		if (meshletVertices.empty())
+		{
+			while (cursor < triangleCount && emitted[cursor])
+			{
+				cursor++;
+			}
+			if (cursor == triangleCount)
+			{
+				break;
+			}
+			best = static_cast<uint32_t>(cursor);
+		}
+		else
+		{
+			// bVbg̒_ɗאڂOp`Aǉ钸_Ȃ̋߂̂I
+			float axisLength = glm::length(normalSum);
+			glm::vec3 axis = axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f);
+			float bestScore = numeric_limits<float>::max();
+			for (uint32_t v : meshletVertices)
+			{
+				for (uint32_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v] + liveCount[v]; a++)
+				{
+					uint32_t triangle = adjacency[a];
+					uint32_t extra = 0;
+					for (int k = 0; k < 3; k++)
+					{
+						extra += vertexMeshlet[indices[triangle * 3 + k]] != meshletId ? 1 : 0;
+					}
+					if (meshletVertices.size() + extra > maxVertices)
+					{
+						continue;
+					}
+					float score = extra + MESHLET_CONE_WEIGHT * (1.0f - glm::dot(normals[triangle], axis));
+					if (score < bestScore)
+					{
+						bestScore = score;
+						best = triangle;
+					}
+				}
+			}
+			if (best == none)
+			{
+				finishMeshlet();
+				continue;
+			}
+		}
+
+		emitted[best] = true;
+		for (int k = 0; k < 3; k++)
+		{
+			uint32_t v = indices[best * 3 + k];
+			result.push_back(v);
+			if (vertexMeshlet[v] != meshletId)
+			{
+				vertexMeshlet[v] = meshletId;
+				meshletVertices.push_back(v);
+			}
+
+			uint32_t begin = adjacencyOffsets[v];
+			uint32_t end = begin + liveCount[v];
+			for (uint32_t a = begin; a < end; a++)
+			{
+				if (adjacency[a] == best)
+				{
+					swap(adjacency[a], adjacency[end - 1]);
+					liveCount[v]--;
+					break;
+				}
+			}
+		}
+		normalSum += normals[best];
+
+		if ((result.size() - meshlet.firstIndex) / 3 >= maxTriangles)
+		{
+			finishMeshlet();
+		}
+	}
+
+	if (!meshletVertices.empty())
+	{
+		finishMeshlet();
+	}
+
+	*pIndices = move(result);
+}
+
+void optimizeMeshletVertexCache(vector<uint32_t>* pIndices, size_t vertexCount, const vector<Meshlet>& meshlets, uint32_t cacheSize)
+{
+	// bVbg̒_0ԍU蒼čœKA̔ԍɖ߂
+	const uint32_t none = numeric_limits<uint32_t>::max();
+	vector<uint32_t> localIndex(vertexCount, none);
+	vector<uint32_t> globalIndex;
+	vector<uint32_t> local;
+	vector<uint32_t> clusters;
+	for (const auto& meshlet : meshlets)
+	{
+		uint32_t* begin = pIndices->data() + meshlet.firstIndex;
+		local.clear();
+		globalIndex.clear();
+		for (uint32_t i = 0; i < meshlet.indexCount; i++)
+		{
+			uint32_t& slot = localIndex[begin[i]];
+			if (slot == none)
+			{
+				slot = static_cast<uint32_t>(globalIndex.size());
+				globalIndex.push_back(begin[i]);
+			}
+			local.push_back(slot);
+		}
+
+		optimizeVertexCache(&local, globalIndex.size(), cacheSize, &clusters);
+
+		for (uint32_t i = 0; i < meshlet.indexCount; i++)
+		{
+			begin[i] = globalIndex[local[i]];
+		}
+		for (uint32_t v : globalIndex)
+		{
+			localIndex[v] = none;
+		}
+	}
+}
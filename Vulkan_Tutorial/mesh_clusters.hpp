@@ -0,0 +1,28 @@
+#pragma once
+
+#include "my_vulkan.hpp"
+
+const uint32_t MESHLET_MAX_VERTICES = 64;
+const uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+// CfbNXobt@ŘAOp`̂܂Ƃ܂
+struct Meshlet
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	uint32_t vertexCount;
+	glm::vec3 center; // E
+	float radius;
+	glm::vec3 coneApex; // @R[Bapex̎axis̓ςcutoffȏȂS
+	glm::vec3 coneAxis;
+	float coneCutoff; // 1ȂR[ŊԈȂ
+};
+
+// אڂOp`𒸓_EOp`̏܂ł܂Ƃ߁AbVbgɃCfbNXבւ
+// _̒ǉȂȂOp`D悷̂Ŗ@R[Ȃ₷
+void buildMeshlets(const vector<Vertex>& vertices, vector<uint32_t>* pIndices, uint32_t maxVertices, uint32_t maxTriangles,
+	vector<Meshlet>* pMeshlets);
+
+// ebVbg̒Tipsify|BbuildMeshlets͗אڂ̍L鏇ɎOp`ׂ̂ŁA
+// ̃CfbNX̃LbVœK̓bVbg̒ł͎ (bVbg̕т͌̏̂܂)
+void optimizeMeshletVertexCache(vector<uint32_t>* pIndices, size_t vertexCount, const vector<Meshlet>& meshlets, uint32_t cacheSize);
@@ -0,0 +1,1005 @@
+#include "mesh_loader.hpp"
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <cmath>
+#include <cctype>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+//=================================================================
+// Common
+//=================================================================
+
+// XbhƂɏd_Bł܂Ƃ߂đŜ̔ԍɐU蒼
+struct DedupChunk
+{
+	vector<Vertex> vertices;
+	vector<uint32_t> indices; // verticesւ̃CfbNX
+	vector<uint32_t> remap; // vertices̔ԍ -> Ŝ̔ԍ
+	unordered_map<Vertex, uint32_t> map;
+
+	uint32_t add(const Vertex& vertex)
+	{
+		auto result = map.try_emplace(vertex, static_cast<uint32_t>(vertices.size()));
+		if (result.second)
+		{
+			vertices.push_back(vertex);
+		}
+		return result.first->second;
+	}
+};
+
+static uint32_t workerCount()
+{
+	return max(1u, thread::hardware_concurrency());
+}
+
+// [0, count)[J[XbhŏBO͍ŏ̂̂Ăяoœ
+static void parallelFor(size_t count, const function<void(size_t)>& body)
+{
+	uint32_t threadCount = static_cast<uint32_t>(min<size_t>(workerCount(), count));
+	if (threadCount <= 1)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			body(i);
+		}
+		return;
+	}
+
+	atomic<size_t> next{ 0 };
+	exception_ptr error;
+	mutex errorMutex;
+	vector<thread> threads;
+	for (uint32_t t = 0; t < threadCount; t++)
+	{
+		threads.emplace_back([&]()
+		{
+			try
+			{
+				for (size_t i = next++; i < count; i = next++)
+				{
+					body(i);
+				}
+			}
+			catch (...)
+			{
+				lock_guard<mutex> lock(errorMutex);
+				if (!error) error = current_exception();
+				next = count;
+			}
+		});
+	}
+	for (auto& t : threads)
+	{
+		t.join();
+	}
+
+	if (error)
+	{
+		rethrow_exception(error);
+	}
+}
+
+// e`N̒_ŜŏdAremap𖄂߂
+static void mergeChunks(vector<DedupChunk>& chunks, vector<Vertex>* pVertices)
+{
+	size_t total = 0;
+	for (auto& chunk : chunks)
+	{
+		chunk.map = {}; // ȍ~͎gȂ̂Őɉ
+		total += chunk.vertices.size();
+	}
+
+	unordered_map<Vertex, uint32_t> map;
+	map.reserve(total);
+	pVertices->clear();
+	pVertices->reserve(total);
+
+	for (auto& chunk : chunks)
+	{
+		chunk.remap.resize(chunk.vertices.size());
+		for (size_t i = 0; i < chunk.vertices.size(); i++)
+		{
+			auto result = map.try_emplace(chunk.vertices[i], static_cast<uint32_t>(pVertices->size()));
+			if (result.second)
+			{
+				pVertices->push_back(chunk.vertices[i]);
+			}
+			chunk.remap[i] = result.first->second;
+		}
+		chunk.vertices = {};
+	}
+}
+
+static vector<char> readBinaryFile(const string& path)
+{
+	ifstream file(path, ios::ate | ios::binary);
+	if (!file.is_open())
+	{
+		throw runtime_error("failed to open mesh file: " + path);
+	}
+
+	size_t fileSize = static_cast<size_t>(file.tellg());
+	vector<char> buffer(fileSize);
+	file.seekg(0);
+	file.read(buffer.data(), fileSize);
+
+	return buffer;
+}
+
+static double elapsedMs(chrono::steady_clock::time_point begin)
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+}
+
+//=================================================================
+// OBJ
+//=================================================================
+
+// ʂ̒_B̃CfbNX̓`N擪̑ΈʒuɂĂAS`N̉͌ɉ
+struct ObjCorner
+{
+	int32_t position;
+	int32_t texCoord;
+	uint8_t positionRelative;
+	uint8_t texCoordRelative;
+};
+
+struct ObjChunk
+{
+	const char* begin;
+	const char* end;
+	vector<glm::vec3> positions;
+	vector<glm::vec3> colors;
+	vector<glm::vec2> texCoords;
+	vector<ObjCorner> corners; // Op`ɕς
+	size_t positionBase;
+	size_t texCoordBase;
+};
+
+static const char* skipSpaces(const char* p, const char* end)
+{
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+	return p;
+}
+
+static const char* skipLine(const char* p, const char* end)
+{
+	while (p < end && *p != '\n') p++;
+	return p < end ? p + 1 : end;
+}
+
+// strtod̓P[邤ɒx̂ŎOœǂ
+static const char* parseDouble(const char* p, const char* end, double* out)
+{
+	p = skipSpaces(p, end);
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = *p == '-';
+		p++;
+	}
+
+	double value = 0.0;
+	while (p < end && *p >= '0' && *p <= '9')
+	{
+		value = value * 10.0 + (*p++ - '0');
+	}
+	if (p < end && *p == '.')
+	{
+		p++;
+		double scale = 0.1;
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			value += (*p++ - '0') * scale;
+			scale *= 0.1;
+		}
+	}
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		p++;
+		bool negativeExp = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negativeExp = *p == '-';
+			p++;
+		}
+		int exponent = 0;
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			exponent = exponent * 10 + (*p++ - '0');
+		}
+		value *= pow(10.0, negativeExp ? -exponent : exponent);
+	}
+
+	*out = negative ? -value : value;
+	return p;
+}
+
+static const char* parseFloat(const char* p, const char* end, float* out)
+{
+	double value = 0.0;
+	p = parseDouble(p, end, &value);
+	*out = static_cast<float>(value);
+	return p;
+}
+
+static const char* parseInt(const char* p, const char* end, int32_t* out)
+{
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = *p == '-';
+		p++;
+	}
+
+	int32_t value = 0;
+	while (p < end && *p >= '0' && *p <= '9')
+	{
+		value = value * 10 + (*p++ - '0');
+	}
+
+	*out = negative ? -value : value;
+	return p;
+}
+
+static void parseObjChunk(ObjChunk* pChunk)
+{
+	const char* p = pChunk->begin;
+	const char* end = pChunk->end;
+	vector<ObjCorner> face;
+
+	while (p < end)
+	{
+		p = skipSpaces(p, end);
+		if (p + 1 >= end)
+		{
+			break;
+		}
+
+		if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+		{
+			// v x y z [r g b]
+			glm::vec3 position;
+			p = parseFloat(p + 2, end, &position.x);
+			p = parseFloat(p, end, &position.y);
+			p = parseFloat(p, end, &position.z);
+			// l3Ȃ璸_J[ (1ȂwȂ̂Ŗ)
+			float extra[3] = {};
+			int extraCount = 0;
+			for (; extraCount < 3; extraCount++)
+			{
+				p = skipSpaces(p, end);
+				if (p >= end || *p == '\n' || *p == '#')
+				{
+					break;
+				}
+				p = parseFloat(p, end, &extra[extraCount]);
+			}
+			glm::vec3 color = extraCount == 3 ? glm::vec3(extra[0], extra[1], extra[2]) : glm::vec3(1.0f);
+			pChunk->positions.push_back(position);
+			pChunk->colors.push_back(color);
+		}
+		else if (p[0] == 'v' && p[1] == 't')
+		{
+			glm::vec2 texCoord;
+			p = parseFloat(p + 2, end, &texCoord.x);
+			p = parseFloat(p, end, &texCoord.y);
+			pChunk->texCoords.push_back(texCoord);
+		}
+		else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+		{
+			// f v/vt/vn ... (vt, vn͏ȗ)
+			face.clear();
+			p += 2;
+			while (true)
+			{
+				p = skipSpaces(p, end);
+				if (p >= end || *p == '\n' || *p == '#')
+				{
+					break;
+				}
+
+				ObjCorner corner{ 0, -1, 0, 0 };
+				int32_t index = 0;
+				p = parseInt(p, end, &index);
+				if (index == 0)
+				{
+					throw runtime_error("invalid obj face index!");
+				}
+				corner.positionRelative = index < 0;
+				corner.position = index < 0 ? static_cast<int32_t>(pChunk->positions.size()) + index : index - 1;
+
+				if (p < end && *p == '/')
+				{
+					p++;
+					if (p < end && *p != '/')
+					{
+						p = parseInt(p, end, &index);
+						if (index != 0)
+						{
+							corner.texCoordRelative = index < 0;
+							corner.texCoord = index < 0 ? static_cast<int32_t>(pChunk->texCoords.size()) + index : index - 1;
+						}
+					}
+					if (p < end && *p == '/')
+					{
+						p++;
+						p = parseInt(p, end, &index); // @͎gȂ
+					}
+				}
+				face.push_back(corner);
+			}
+
+			// ɎOp`
+			for (size_t i = 2; i < face.size(); i++)
+			{
+				pChunk->corners.push_back(face[0]);
+				pChunk->corners.push_back(face[i - 1]);
+				pChunk->corners.push_back(face[i]);
+			}
+		}
+
+		p = skipLine(p, end);
+	}
+}
+
+static void loadObj(const vector<char>& file, vector<Vertex>* pVertices, vector<uint32_t>* pIndices, MeshLoadStats* pStats)
+{
+	// s̓rŐ؂Ȃ悤ɁAs̒Ń`Nɕ
+	const size_t minChunkSize = 1 << 20;
+	size_t chunkSize = max(minChunkSize, file.size() / (workerCount() * 4) + 1);
+	vector<ObjChunk> chunks;
+	const char* data = file.data();
+	const char* fileEnd = data + file.size();
+	for (const char* p = data; p < fileEnd;)
+	{
+		const char* chunkEnd = p + min(chunkSize, static_cast<size_t>(fileEnd - p));
+		while (chunkEnd < fileEnd && chunkEnd[-1] != '\n') chunkEnd++;
+
+		ObjChunk chunk{};
+		chunk.begin = p;
+		chunk.end = chunkEnd;
+		chunks.push_back(move(chunk));
+		p = chunkEnd;
+	}
+
+	parallelFor(chunks.size(), [&](size_t i) { parseObjChunk(&chunks[i]); });
+
+	// _AāA`NƂ̐擪ʒu߂
+	vector<glm::vec3> positions;
+	vector<glm::vec3> colors;
+	vector<glm::vec2> texCoords;
+	size_t cornerCount = 0;
+	for (auto& chunk : chunks)
+	{
+		chunk.positionBase = positions.size();
+		chunk.texCoordBase = texCoords.size();
+		positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+		colors.insert(colors.end(), chunk.colors.begin(), chunk.colors.end());
+		texCoords.insert(texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+		chunk.positions = {};
+		chunk.colors = {};
+		chunk.texCoords = {};
+		cornerCount += chunk.corners.size();
+	}
+
+	// `NƂɒ_gݗĂďd
+	vector<DedupChunk> dedup(chunks.size());
+	parallelFor(chunks.size(), [&](size_t i)
+	{
+		const ObjChunk& chunk = chunks[i];
+		DedupChunk& out = dedup[i];
+		out.indices.reserve(chunk.corners.size());
+		out.map.reserve(chunk.corners.size() / 4);
+
+		for (const auto& corner : chunk.corners)
+		{
+			int64_t position = corner.position + (corner.positionRelative ? static_cast<int64_t>(chunk.positionBase) : 0);
+			if (position < 0 || position >= static_cast<int64_t>(positions.size()))
+			{
+				throw runtime_error("obj face references missing position!");
+			}
+
+			Vertex vertex{};
+			vertex.pos = positions[position];
+			vertex.color = colors[position];
+			if (corner.texCoord >= 0 || corner.texCoordRelative)
+			{
+				int64_t texCoord = corner.texCoord + (corner.texCoordRelative ? static_cast<int64_t>(chunk.texCoordBase) : 0);
+				if (texCoord < 0 || texCoord >= static_cast<int64_t>(texCoords.size()))
+				{
+					throw runtime_error("obj face references missing texcoord!");
+				}
+				// OBJ͍_AVulkan͍㌴_
+				vertex.texCoord = { texCoords[texCoord].x, 1.0f - texCoords[texCoord].y };
+			}
+
+			out.indices.push_back(out.add(vertex));
+		}
+	});
+	pStats->inputVertexCount = cornerCount;
+
+	auto mergeStart = chrono::steady_clock::now();
+	mergeChunks(dedup, pVertices);
+
+	pIndices->resize(cornerCount);
+	vector<size_t> indexOffsets(dedup.size());
+	for (size_t i = 0, offset = 0; i < dedup.size(); i++)
+	{
+		indexOffsets[i] = offset;
+		offset += dedup[i].indices.size();
+	}
+	parallelFor(dedup.size(), [&](size_t i)
+	{
+		uint32_t* out = pIndices->data() + indexOffsets[i];
+		for (uint32_t index : dedup[i].indices)
+		{
+			*out++ = dedup[i].remap[index];
+		}
+	});
+	pStats->mergeMs = elapsedMs(mergeStart);
+}
+
+//=================================================================
+// glTF 2.0 (.glb)
+//=================================================================
+
+// glTFJSON`Nǂނ߂̍ŏJSON
+struct JsonValue
+{
+	enum Type { Null, Bool, Number, String, Array, Object } type = Null;
+	double number = 0.0;
+	string str;
+	vector<JsonValue> items;
+	vector<pair<string, JsonValue>> members;
+
+	const JsonValue* find(const char* key) const
+	{
+		for (const auto& m : members)
+		{
+			if (m.first == key) return &m.second;
+		}
+		return nullptr;
+	}
+
+	const JsonValue& operator[](const char* key) const
+	{
+		const JsonValue* value = find(key);
+		if (value == nullptr)
+		{
+			throw runtime_error(string("gltf: missing property ") + key);
+		}
+		return *value;
+	}
+
+	const JsonValue& operator[](size_t index) const
+	{
+		if (type != Array || index >= items.size())
+		{
+			throw runtime_error("gltf: index out of range!");
+		}
+		return items[index];
+	}
+
+	size_t asIndex() const
+	{
+		if (type != Number || number < 0.0)
+		{
+			throw runtime_error("gltf: invalid index!");
+		}
+		return static_cast<size_t>(number);
+	}
+
+	double numberOr(const char* key, double fallback) const
+	{
+		const JsonValue* value = find(key);
+		return value != nullptr && value->type == Number ? value->number : fallback;
+	}
+};
+
+struct JsonParser
+{
+	const char* p;
+	const char* end;
+
+	void skipWhitespace()
+	{
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+	}
+
+	void expect(char c)
+	{
+		skipWhitespace();
+		if (p >= end || *p != c)
+		{
+			throw runtime_error("gltf: malformed json!");
+		}
+		p++;
+	}
+
+	string parseString()
+	{
+		expect('"');
+		string result;
+		while (p < end && *p != '"')
+		{
+			if (*p == '\\' && p + 1 < end)
+			{
+				p++;
+				switch (*p)
+				{
+				case 'n': result += '\n'; break;
+				case 't': result += '\t'; break;
+				case 'r': result += '\r'; break;
+				case 'b': result += '\b'; break;
+				case 'f': result += '\f'; break;
+				case 'u': p += min<ptrdiff_t>(4, end - p - 1); result += '?'; break; // OȊOł͎gȂ
+				default: result += *p; break;
+				}
+				p++;
+			}
+			else
+			{
+				result += *p++;
+			}
+		}
+		expect('"');
+		return result;
+	}
+
+	JsonValue parseValue()
+	{
+		skipWhitespace();
+		if (p >= end)
+		{
+			throw runtime_error("gltf: unexpected end of json!");
+		}
+
+		JsonValue value;
+		if (*p == '{')
+		{
+			value.type = JsonValue::Object;
+			p++;
+			skipWhitespace();
+			if (p < end && *p == '}')
+			{
+				p++;
+				return value;
+			}
+			while (true)
+			{
+				string key = parseString();
+				expect(':');
+				value.members.emplace_back(move(key), parseValue());
+				skipWhitespace();
+				if (p < end && *p == ',')
+				{
+					p++;
+					continue;
+				}
+				expect('}');
+				return value;
+			}
+		}
+		if (*p == '[')
+		{
+			value.type = JsonValue::Array;
+			p++;
+			skipWhitespace();
+			if (p < end && *p == ']')
+			{
+				p++;
+				return value;
+			}
+			while (true)
+			{
+				value.items.push_back(parseValue());
+				skipWhitespace();
+				if (p < end && *p == ',')
+				{
+					p++;
+					continue;
+				}
+				expect(']');
+				return value;
+			}
+		}
+		if (*p == '"')
+		{
+			value.type = JsonValue::String;
+			value.str = parseString();
+			return value;
+		}
+		if (end - p >= 4 && strncmp(p, "true", 4) == 0)
+		{
+			value.type = JsonValue::Bool;
+			value.number = 1.0;
+			p += 4;
+			return value;
+		}
+		if (end - p >= 5 && strncmp(p, "false", 5) == 0)
+		{
+			value.type = JsonValue::Bool;
+			p += 5;
+			return value;
+		}
+		if (end - p >= 4 && strncmp(p, "null", 4) == 0)
+		{
+			p += 4;
+			return value;
+		}
+
+		double number = 0.0;
+		const char* start = p;
+		p = parseDouble(p, end, &number);
+		if (p == start)
+		{
+			throw runtime_error("gltf: malformed json!");
+		}
+		value.type = JsonValue::Number;
+		value.number = number;
+		return value;
+	}
+};
+
+struct GltfAccessor
+{
+	const uint8_t* data;
+	size_t count;
+	size_t stride;
+	uint32_t componentType;
+	uint32_t componentCount;
+	bool normalized;
+
+	// vfiő4floatœǂ
+	glm::vec4 read(size_t i) const
+	{
+		const uint8_t* element = data + i * stride;
+		glm::vec4 value(0.0f, 0.0f, 0.0f, 1.0f);
+		for (uint32_t c = 0; c < componentCount; c++)
+		{
+			switch (componentType)
+			{
+			case 5120: { int8_t v; memcpy(&v, element + c, 1); value[c] = normalized ? max(v / 127.0f, -1.0f) : v; break; }
+			case 5121: { uint8_t v = element[c]; value[c] = normalized ? v / 255.0f : v; break; }
+			case 5122: { int16_t v; memcpy(&v, element + c * 2, 2); value[c] = normalized ? max(v / 32767.0f, -1.0f) : v; break; }
+			case 5123: { uint16_t v; memcpy(&v, element + c * 2, 2); value[c] = normalized ? v / 65535.0f : v; break; }
+			case 5125: { uint32_t v; memcpy(&v, element + c * 4, 4); value[c] = static_cast<float>(v); break; }
+			case 5126: { memcpy(&value[c], element + c * 4, 4); break; }
+			}
+		}
+		return value;
+	}
+
+	uint32_t readIndex(size_t i) const
+	{
+		const uint8_t* element = data + i * stride;
+		switch (componentType)
+		{
+		case 5121: return element[0];
+		case 5123: { uint16_t v; memcpy(&v, element, 2); return v; }
+		default: { uint32_t v; memcpy(&v, element, 4); return v; }
+		}
+	}
+};
+
+static GltfAccessor getAccessor(const JsonValue& json, const uint8_t* bin, size_t binSize, size_t index)
+{
+	const JsonValue& accessor = json["accessors"][index];
+	if (accessor.find("sparse") != nullptr || accessor.find("bufferView") == nullptr)
+	{
+		throw runtime_error("gltf: sparse accessors are not supported!");
+	}
+	const JsonValue& view = json["bufferViews"][accessor["bufferView"].asIndex()];
+	if (view["buffer"].asIndex() != 0)
+	{
+		throw runtime_error("gltf: only the glb binary buffer is supported!");
+	}
+
+	GltfAccessor result{};
+	result.componentType = static_cast<uint32_t>(accessor["componentType"].number);
+	result.count = accessor["count"].asIndex();
+	const JsonValue* normalized = accessor.find("normalized");
+	result.normalized = normalized != nullptr && normalized->number != 0.0;
+
+	const string& type = accessor["type"].str;
+	result.componentCount = type == "SCALAR" ? 1 : type == "VEC2" ? 2 : type == "VEC3" ? 3 : type == "VEC4" ? 4 : 0;
+	uint32_t componentSize = result.componentType == 5120 || result.componentType == 5121 ? 1 :
+		result.componentType == 5122 || result.componentType == 5123 ? 2 : 4;
+	if (result.componentCount == 0)
+	{
+		throw runtime_error("gltf: unsupported accessor type " + type);
+	}
+
+	size_t elementSize = static_cast<size_t>(componentSize) * result.componentCount;
+	size_t offset = static_cast<size_t>(view.numberOr("byteOffset", 0.0) + accessor.numberOr("byteOffset", 0.0));
+	size_t viewLength = static_cast<size_t>(view["byteLength"].number);
+	result.stride = static_cast<size_t>(view.numberOr("byteStride", 0.0));
+	if (result.stride == 0)
+	{
+		result.stride = elementSize;
+	}
+
+	size_t viewEnd = static_cast<size_t>(view.numberOr("byteOffset", 0.0)) + viewLength;
+	if (result.count > 0 && (viewEnd > binSize || offset + result.stride * (result.count - 1) + elementSize > viewEnd))
+	{
+		throw runtime_error("gltf: accessor out of buffer range!");
+	}
+	result.data = bin + offset;
+
+	return result;
+}
+
+static glm::mat4 nodeMatrix(const JsonValue& node)
+{
+	const JsonValue* matrix = node.find("matrix");
+	if (matrix != nullptr && matrix->items.size() == 16)
+	{
+		glm::mat4 result;
+		for (int i = 0; i < 16; i++)
+		{
+			glm::value_ptr(result)[i] = static_cast<float>(matrix->items[i].number); // D
+		}
+		return result;
+	}
+
+	glm::vec3 translation(0.0f);
+	glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+	glm::vec3 scale(1.0f);
+	if (const JsonValue* t = node.find("translation"))
+	{
+		translation = { t->items.at(0).number, t->items.at(1).number, t->items.at(2).number };
+	}
+	if (const JsonValue* r = node.find("rotation"))
+	{
+		// glTFxyzwAglm::quat̃RXgN^wxyz
+		rotation = glm::quat(static_cast<float>(r->items.at(3).number), static_cast<float>(r->items.at(0).number),
+			static_cast<float>(r->items.at(1).number), static_cast<float>(r->items.at(2).number));
+	}
+	if (const JsonValue* s = node.find("scale"))
+	{
+		scale = { s->items.at(0).number, s->items.at(1).number, s->items.at(2).number };
+	}
+	return glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+}
+
+struct GltfPrimitive
+{
+	GltfAccessor position;
+	GltfAccessor texCoord;
+	GltfAccessor color;
+	GltfAccessor indices;
+	bool hasTexCoord;
+	bool hasColor;
+	bool hasIndices;
+	glm::mat4 matrix;
+	size_t firstSlice;
+	size_t indexOffset;
+};
+
+// ȃv~eBuɏł悤A_̐Ƃɕďd
+const size_t GLTF_VERTEX_SLICE = 1 << 16;
+
+static void loadGlb(const vector<char>& file, vector<Vertex>* pVertices, vector<uint32_t>* pIndices, MeshLoadStats* pStats)
+{
+	// wb_(magic, version, length) + JSON`N + BIN`N
+	auto readU32 = [&](size_t offset)
+	{
+		uint32_t value = 0;
+		if (offset + 4 <= file.size()) memcpy(&value, file.data() + offset, 4);
+		return value;
+	};
+	if (file.size() < 20 || readU32(0) != 0x46546C67 || readU32(4) != 2)
+	{
+		throw runtime_error("not a glTF 2.0 binary file!");
+	}
+
+	size_t jsonLength = readU32(12);
+	if (readU32(16) != 0x4E4F534A || 20 + jsonLength > file.size())
+	{
+		throw runtime_error("gltf: missing json chunk!");
+	}
+	const char* jsonBegin = file.data() + 20;
+
+	const uint8_t* bin = nullptr;
+	size_t binSize = 0;
+	size_t binHeader = 20 + ((jsonLength + 3) & ~size_t(3));
+	if (binHeader + 8 <= file.size() && readU32(binHeader + 4) == 0x004E4942)
+	{
+		binSize = min<size_t>(readU32(binHeader), file.size() - binHeader - 8);
+		bin = reinterpret_cast<const uint8_t*>(file.data() + binHeader + 8);
+	}
+
+	JsonParser parser{ jsonBegin, jsonBegin + jsonLength };
+	JsonValue json = parser.parseValue();
+
+	// V[̃m[hǂAbVƃ[hs̑gW߂
+	vector<pair<size_t, glm::mat4>> meshInstances;
+	const JsonValue* nodes = json.find("nodes");
+	const JsonValue* scenes = json.find("scenes");
+	if (nodes != nullptr && scenes != nullptr && !scenes->items.empty())
+	{
+		size_t sceneIndex = static_cast<size_t>(json.numberOr("scene", 0.0));
+		vector<pair<size_t, glm::mat4>> stack;
+		size_t visited = 0;
+		if (const JsonValue* roots = (*scenes)[sceneIndex].find("nodes"))
+		{
+			for (const auto& root : roots->items)
+			{
+				stack.emplace_back(root.asIndex(), glm::mat4(1.0f));
+			}
+		}
+		while (!stack.empty())
+		{
+			auto item = stack.back();
+			stack.pop_back();
+			// m[h͐e1ĂȂ̂ŁAK␔m[h𒴂zĂ
+			if (++visited > nodes->items.size())
+			{
+				throw runtime_error("gltf: node hierarchy has a cycle!");
+			}
+
+			const JsonValue& node = (*nodes)[item.first];
+			glm::mat4 world = item.second * nodeMatrix(node);
+			if (const JsonValue* mesh = node.find("mesh"))
+			{
+				meshInstances.emplace_back(mesh->asIndex(), world);
+			}
+			if (const JsonValue* children = node.find("children"))
+			{
+				for (const auto& child : children->items)
+				{
+					stack.emplace_back(child.asIndex(), world);
+				}
+			}
+		}
+	}
+	else if (const JsonValue* meshes = json.find("meshes"))
+	{
+		for (size_t i = 0; i < meshes->items.size(); i++)
+		{
+			meshInstances.emplace_back(i, glm::mat4(1.0f));
+		}
+	}
+
+	// Op`Xg̃v~eBu
+	vector<GltfPrimitive> primitives;
+	size_t sliceCount = 0;
+	size_t indexCount = 0;
+	for (const auto& instance : meshInstances)
+	{
+		for (const auto& prim : json["meshes"][instance.first]["primitives"].items)
+		{
+			if (prim.numberOr("mode", 4.0) != 4.0)
+			{
+				continue;
+			}
+
+			const JsonValue& attributes = prim["attributes"];
+			GltfPrimitive primitive{};
+			primitive.position = getAccessor(json, bin, binSize, attributes["POSITION"].asIndex());
+			if (const JsonValue* texCoord = attributes.find("TEXCOORD_0"))
+			{
+				primitive.texCoord = getAccessor(json, bin, binSize, texCoord->asIndex());
+				primitive.hasTexCoord = primitive.texCoord.count >= primitive.position.count;
+			}
+			if (const JsonValue* color = attributes.find("COLOR_0"))
+			{
+				primitive.color = getAccessor(json, bin, binSize, color->asIndex());
+				primitive.hasColor = primitive.color.count >= primitive.position.count;
+			}
+			if (const JsonValue* indices = prim.find("indices"))
+			{
+				primitive.indices = getAccessor(json, bin, binSize, indices->asIndex());
+				primitive.hasIndices = true;
+			}
+			primitive.matrix = instance.second;
+			primitive.firstSlice = sliceCount;
+			primitive.indexOffset = indexCount;
+
+			sliceCount += (primitive.position.count + GLTF_VERTEX_SLICE - 1) / GLTF_VERTEX_SLICE;
+			indexCount += (primitive.hasIndices ? primitive.indices.count : primitive.position.count) / 3 * 3;
+			pStats->inputVertexCount += primitive.position.count;
+			primitives.push_back(primitive);
+		}
+	}
+
+	// _XCXƂɓǂ݁Ad
+	vector<pair<size_t, size_t>> slices; // (v~eBu, XCX̐擪_)
+	slices.reserve(sliceCount);
+	for (size_t i = 0; i < primitives.size(); i++)
+	{
+		for (size_t first = 0; first < primitives[i].position.count; first += GLTF_VERTEX_SLICE)
+		{
+			slices.emplace_back(i, first);
+		}
+	}
+
+	vector<DedupChunk> dedup(slices.size());
+	parallelFor(slices.size(), [&](size_t s)
+	{
+		const GltfPrimitive& primitive = primitives[slices[s].first];
+		size_t first = slices[s].second;
+		size_t last = min(first + GLTF_VERTEX_SLICE, primitive.position.count);
+		DedupChunk& out = dedup[s];
+		out.indices.reserve(last - first);
+		out.map.reserve(last - first);
+
+		for (size_t i = first; i < last; i++)
+		{
+			Vertex vertex{};
+			vertex.pos = glm::vec3(primitive.matrix * glm::vec4(glm::vec3(primitive.position.read(i)), 1.0f));
+			vertex.color = primitive.hasColor ? glm::vec3(primitive.color.read(i)) : glm::vec3(1.0f);
+			vertex.texCoord = primitive.hasTexCoord ? glm::vec2(primitive.texCoord.read(i)) : glm::vec2(0.0f);
+			out.indices.push_back(out.add(vertex)); // ̒_ԍ -> `N̔ԍ
+		}
+	});
+
+	auto mergeStart = chrono::steady_clock::now();
+	mergeChunks(dedup, pVertices);
+
+	pIndices->resize(indexCount);
+	parallelFor(primitives.size(), [&](size_t p)
+	{
+		const GltfPrimitive& primitive = primitives[p];
+		size_t count = (primitive.hasIndices ? primitive.indices.count : primitive.position.count) / 3 * 3;
+		uint32_t* out = pIndices->data() + primitive.indexOffset;
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t index = primitive.hasIndices ? primitive.indices.readIndex(i) : i;
+			if (index >= primitive.position.count)
+			{
+				throw runtime_error("gltf: index out of range!");
+			}
+			const DedupChunk& chunk = dedup[primitive.firstSlice + index / GLTF_VERTEX_SLICE];
+			*out++ = chunk.remap[chunk.indices[index % GLTF_VERTEX_SLICE]];
+		}
+	});
+	pStats->mergeMs = elapsedMs(mergeStart);
+}
+
+//=================================================================
+// Entry
+//=================================================================
+
+void loadMesh(const string& path, vector<Vertex>* pVertices, vector<uint32_t>* pIndices, MeshLoadStats* pStats)
+{
+	MeshLoadStats stats{};
+	stats.threadCount = workerCount();
+	auto start = chrono::steady_clock::now();
+
+	vector<char> file = readBinaryFile(path);
+	stats.readMs = elapsedMs(start);
+
+	string extension = path.substr(path.find_last_of('.') + 1);
+	transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(tolower(c)); });
+
+	auto parseStart = chrono::steady_clock::now();
+	if (extension == "obj")
+	{
+		loadObj(file, pVertices, pIndices, &stats);
+	}
+	else if (extension == "glb")
+	{
+		loadGlb(file, pVertices, pIndices, &stats);
+	}
+	else
+	{
+		throw runtime_error("unsupported mesh format: " + path);
+	}
+
+	stats.totalMs = elapsedMs(start);
+	stats.parseMs = elapsedMs(parseStart) - stats.mergeMs;
+	stats.triangleCount = pIndices->size() / 3;
+	stats.vertexCount = pVertices->size();
+
+	if (pStats != nullptr)
+	{
+		*pStats = stats;
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "my_vulkan.hpp"
+
+struct MeshLoadStats
+{
+	size_t triangleCount;
+	size_t vertexCount; // d
+	size_t inputVertexCount; // dO (OBJ͖ʂ̒_AglTF̓ANZT̒_)
+	uint32_t threadCount;
+	double readMs; // t@Cǂݍ
+	double parseMs; // ͂ƊeXbhł̏d
+	double mergeMs; // XbhԂ̏dƃCfbNX̏o
+	double totalMs;
+};
+
+// .obj / .glb ǂݍ݁Ad_ƃCfbNXԂ
+// ͂̓[J[XbhōsAsruntime_error𓊂
+void loadMesh(const string& path, vector<Vertex>* pVertices, vector<uint32_t>* pIndices, MeshLoadStats* pStats);
@@ -0,0 +1,298 @@
+#include "mesh_optimizer.hpp"
+
+VertexCacheStats analyzeVertexCache(const vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+{
+	// timestamps[v]cacheSizẽ~XȓȂLbVɍڂĂ
+	vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+	size_t transformed = 0;
+
+	for (uint32_t index : indices)
+	{
+		if (time - timestamps[index] > cacheSize)
+		{
+			timestamps[index] = time++;
+			transformed++;
+		}
+	}
+
+	VertexCacheStats stats{};
+	size_t triangleCount = indices.size() / 3;
+	stats.acmr = triangleCount > 0 ? static_cast<float>(transformed) / triangleCount : 0.0f;
+	stats.atvr = vertexCount > 0 ? static_cast<float>(transformed) / vertexCount : 0.0f;
+	return stats;
+}
+
+//=================================================================
+// Tipsify
+//=================================================================
+
+void optimizeVertexCache(vector<uint32_t>* pIndices, size_t vertexCount, uint32_t cacheSize, vector<uint32_t>* pClusters)
+{
+	const vector<uint32_t>& indices = *pIndices;
+	size_t triangleCount = indices.size() / 3;
+	pClusters->clear();
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// _ -> אڎOp` (CSR`)
+	vector<uint32_t> liveCount(vertexCount, 0);
+	for (uint32_t index : indices)
+	{
+		liveCount[index]++;
+	}
+	vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveCount[v];
+	}
+	vector<uint32_t> adjacency(indices.size());
+	{
+		vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+
+	vector<uint32_t> cacheTime(vertexCount, 0);
+	vector<bool> emitted(triangleCount, false);
+	vector<uint32_t> deadEnd; // ŋߎg_̃X^bN
+	vector<uint32_t> candidates;
+	vector<uint32_t> result;
+	result.reserve(indices.size());
+
+	uint32_t time = cacheSize + 1;
+	size_t cursor = 0; // fbhGh甲邽߂̏ʒu
+	int64_t fanning = 0;
+	bool newCluster = true;
+
+	while (fanning >= 0)
+	{
+		// ŏfanningoɃfbhGhɂȂƓÊŁÃNX^͍Ȃ
+		uint32_t clusterStart = static_cast<uint32_t>(result.size() / 3);
+		if (newCluster && (pClusters->empty() || pClusters->back() != clusterStart))
+		{
+			pClusters->push_back(clusterStart);
+		}
+		newCluster = false;
+
+		// fanning̖̎o͂̎Op`ׂďo
+		candidates.clear();
+		for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; a++)
+		{
+			uint32_t triangle = adjacency[a];
+			if (emitted[triangle])
+			{
+				continue;
+			}
+			emitted[triangle] = true;
+
+			for (int k = 0; k < 3; k++)
+			{
+				uint32_t v = indices[triangle * 3 + k];
+				result.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				liveCount[v]--;
+				if (time - cacheTime[v] > cacheSize)
+				{
+					cacheTime[v] = time++;
+				}
+			}
+		}
+
+		// fanning̓LbVɎcĂāAc̎Op`oĂLbV痎ȂōłÂ_
+		int64_t next = -1;
+		int64_t bestPriority = -1;
+		for (uint32_t v : candidates)
+		{
+			if (liveCount[v] == 0)
+			{
+				continue;
+			}
+			int64_t priority = 0;
+			if (time - cacheTime[v] + 2 * liveCount[v] <= cacheSize)
+			{
+				priority = time - cacheTime[v];
+			}
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = v;
+			}
+		}
+
+		if (next < 0)
+		{
+			// fbhGh: ŋߎg_AȂΏԂɖ̒_T
+			newCluster = true;
+			while (!deadEnd.empty() && next < 0)
+			{
+				uint32_t v = deadEnd.back();
+				deadEnd.pop_back();
+				if (liveCount[v] > 0)
+				{
+					next = v;
+				}
+			}
+			while (next < 0 && cursor < vertexCount)
+			{
+				if (liveCount[cursor] > 0)
+				{
+					next = cursor;
+				}
+				cursor++;
+			}
+		}
+
+		fanning = next;
+	}
+
+	*pIndices = move(result);
+}
+
+//=================================================================
+// Overdraw
+//=================================================================
+
+void optimizeOverdraw(vector<uint32_t>* pIndices, const vector<Vertex>& vertices, const vector<uint32_t>& clusters,
+	uint32_t cacheSize, float threshold)
+{
+	const vector<uint32_t>& indices = *pIndices;
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0 || clusters.empty())
+	{
+		return;
+	}
+
+	// NX^͕בւƑÕLbVpȂ̂ŁÃLbV琔
+	vector<uint32_t> timestamps(vertices.size(), 0);
+	uint32_t time = 0;
+	auto simulate = [&](size_t triangle)
+	{
+		uint32_t misses = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			uint32_t v = indices[triangle * 3 + k];
+			if (time - timestamps[v] > cacheSize)
+			{
+				timestamps[v] = time++;
+				misses++;
+			}
+		}
+		return misses;
+	};
+	auto flushCache = [&]() { time += cacheSize + 1; };
+
+	// NX^P̂ACMRthreshold{ȓɎ܂Ă鏊ŁAɏȃNX^ɕ
+	vector<uint32_t> softClusters;
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		size_t begin = clusters[c];
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+		flushCache();
+		size_t clusterMisses = 0;
+		for (size_t t = begin; t < end; t++)
+		{
+			clusterMisses += simulate(t);
+		}
+		float clusterThreshold = threshold * static_cast<float>(clusterMisses) / (end - begin);
+
+		flushCache();
+		softClusters.push_back(static_cast<uint32_t>(begin));
+		size_t start = begin;
+		size_t misses = 0;
+		for (size_t t = begin; t < end; t++)
+		{
+			misses += simulate(t);
+			if (t + 1 < end && static_cast<float>(misses) / (t + 1 - start) <= clusterThreshold)
+			{
+				softClusters.push_back(static_cast<uint32_t>(t + 1));
+				start = t + 1;
+				misses = 0;
+				flushCache();
+			}
+		}
+	}
+
+	// bVS猩ăNX^ǂꂾOĂ邩
+	glm::vec3 meshCentroid(0.0f);
+	for (uint32_t index : indices)
+	{
+		meshCentroid += vertices[index].pos;
+	}
+	meshCentroid /= static_cast<float>(indices.size());
+
+	vector<pair<float, uint32_t>> order(softClusters.size());
+	for (size_t c = 0; c < softClusters.size(); c++)
+	{
+		size_t begin = softClusters[c];
+		size_t end = c + 1 < softClusters.size() ? softClusters[c + 1] : triangleCount;
+
+		glm::vec3 centroid(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+		for (size_t t = begin; t < end; t++)
+		{
+			const glm::vec3& p0 = vertices[indices[t * 3 + 0]].pos;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].pos;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].pos;
+			glm::vec3 n = glm::cross(p1 - p0, p2 - p0); // ͖ʐς2{
+			float a = glm::length(n);
+			centroid += (p0 + p1 + p2) * (a / 3.0f);
+			normal += n;
+			area += a;
+		}
+		centroid = area > 0.0f ? centroid / area : vertices[indices[begin * 3]].pos;
+		float normalLength = glm::length(normal);
+		normal = normalLength > 0.0f ? normal / normalLength : glm::vec3(0.0f);
+
+		order[c] = { glm::dot(centroid - meshCentroid, normal), static_cast<uint32_t>(c) };
+	}
+
+	// ÕNX^͑B₷̂Őɕ`
+	stable_sort(order.begin(), order.end(), [](const pair<float, uint32_t>& a, const pair<float, uint32_t>& b)
+	{
+		return a.first > b.first;
+	});
+
+	vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (const auto& item : order)
+	{
+		size_t c = item.second;
+		size_t begin = softClusters[c];
+		size_t end = c + 1 < softClusters.size() ? softClusters[c + 1] : triangleCount;
+		result.insert(result.end(), indices.begin() + begin * 3, indices.begin() + end * 3);
+	}
+
+	*pIndices = move(result);
+}
+
+//=================================================================
+// Vertex Fetch
+//=================================================================
+
+void optimizeVertexFetch(vector<Vertex>* pVertices, vector<uint32_t>* pIndices)
+{
+	const uint32_t unused = numeric_limits<uint32_t>::max();
+	vector<uint32_t> remap(pVertices->size(), unused);
+	vector<Vertex> result;
+	result.reserve(pVertices->size());
+
+	for (uint32_t& index : *pIndices)
+	{
+		if (remap[index] == unused)
+		{
+			remap[index] = static_cast<uint32_t>(result.size());
+			result.push_back((*pVertices)[index]);
+		}
+		index = remap[index];
+	}
+
+	*pVertices = move(result);
+}
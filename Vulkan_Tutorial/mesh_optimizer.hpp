@@ -0,0 +1,26 @@
+#pragma once
+
+#include "my_vulkan.hpp"
+
+const uint32_t VERTEX_CACHE_SIZE = 16; // |XggXtH[LbV(FIFO)̑zTCY
+const float OVERDRAW_THRESHOLD = 1.05f; // I[o[h[œKŋACMR̈
+
+struct VertexCacheStats
+{
+	float acmr; // ϊ_ / Op` (0.5zA3ň)
+	float atvr; // ϊ_ / _ (1z)
+};
+
+// FIFOLbVV~[gACMR/ATVR߂
+VertexCacheStats analyzeVertexCache(const vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize);
+
+// Tipsify (Sander et al. 2007) ŎOp`בւBpClustersɂ͊eNX^擪̎Op`ԍ
+void optimizeVertexCache(vector<uint32_t>* pIndices, size_t vertexCount, uint32_t cacheSize, vector<uint32_t>* pClusters);
+
+// NX^Ô̂珇ɕׁA_ɂ炸I[o[h[炷
+// LbVthreshold{舫ȂȂ͈͂ŃNX^ׂĂׂ
+void optimizeOverdraw(vector<uint32_t>* pIndices, const vector<Vertex>& vertices, const vector<uint32_t>& clusters,
+	uint32_t cacheSize, float threshold);
+
+// CfbNXōŏɎQƂꂽɒ_בւACfbNXU蒼 (gp̒_͏)
+void optimizeVertexFetch(vector<Vertex>* pVertices, vector<uint32_t>* pIndices);
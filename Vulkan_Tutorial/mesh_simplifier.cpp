@@ -0,0 +1,346 @@
+#include "mesh_simplifier.hpp"
+
+// ʂ܂ł̋̓a\Ώ̍s (Garland, Heckbert 1997)
+struct Quadric
+{
+	double a00, a11, a22, a01, a02, a12;
+	double b0, b1, b2;
+	double c;
+	double weight;
+
+	static Quadric fromPlane(const glm::dvec3& normal, double d, double weight)
+	{
+		Quadric q{};
+		q.a00 = normal.x * normal.x * weight;
+		q.a11 = normal.y * normal.y * weight;
+		q.a22 = normal.z * normal.z * weight;
+		q.a01 = normal.x * normal.y * weight;
+		q.a02 = normal.x * normal.z * weight;
+		q.a12 = normal.y * normal.z * weight;
+		q.b0 = normal.x * d * weight;
+		q.b1 = normal.y * d * weight;
+		q.b2 = normal.z * d * weight;
+		q.c = d * d * weight;
+		q.weight = weight;
+		return q;
+	}
+
+	void add(const Quadric& q)
+	{
+		a00 += q.a00; a11 += q.a11; a22 += q.a22;
+		a01 += q.a01; a02 += q.a02; a12 += q.a12;
+		b0 += q.b0; b1 += q.b1; b2 += q.b2;
+		c += q.c;
+		weight += q.weight;
+	}
+
+	// d݂Ŋς̋̓
+	double error(const glm::vec3& p) const
+	{
+		double x = p.x, y = p.y, z = p.z;
+		double e = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+			2.0 * (b0 * x + b1 * y + b2 * z) + c;
+		return weight > 0.0 ? fabs(e) / weight : 0.0;
+	}
+};
+
+enum VertexKind : uint8_t
+{
+	Manifold, // ǂւłkł
+	Border, // E̕ӂɉĂ̂ݏkł
+	Locked, // Ȃ
+};
+
+struct Collapse
+{
+	uint32_t from;
+	uint32_t to;
+	double error;
+};
+
+static uint64_t edgeKey(uint32_t a, uint32_t b)
+{
+	return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+}
+
+vector<uint32_t> simplifyMesh(const vector<Vertex>& vertices, const vector<uint32_t>& indices, size_t targetIndexCount,
+	float targetError, float* pResultError)
+{
+	size_t vertexCount = vertices.size();
+	vector<uint32_t> result = indices;
+	float resultError = 0.0f;
+	if (indices.size() <= targetIndexCount)
+	{
+		if (pResultError != nullptr) *pResultError = 0.0f;
+		return result;
+	}
+
+	// ʒu̒_\_ɂ܂Ƃ߂
+	vector<uint32_t> canonical(vertexCount);
+	vector<uint32_t> wedgeCount(vertexCount, 0);
+	{
+		unordered_map<glm::vec3, uint32_t> positions;
+		positions.reserve(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			canonical[v] = positions.try_emplace(vertices[v].pos, v).first->second;
+			wedgeCount[canonical[v]]++;
+		}
+	}
+
+	// ʒuŌӂƂ̎Op`B1Ȃ狫EA3ȏȂ񑽗l
+	unordered_map<uint64_t, uint32_t> edgeCounts;
+	edgeCounts.reserve(indices.size());
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			edgeCounts[edgeKey(canonical[indices[i + k]], canonical[indices[i + (k + 1) % 3]])]++;
+		}
+	}
+
+	vector<uint8_t> kind(vertexCount, Manifold);
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		if (wedgeCount[canonical[v]] > 1)
+		{
+			kind[v] = Locked;
+		}
+	}
+
+	// ʂ̓񎟌덷ƁAEۂ߂̋EӂɐȖʂ̓񎟌덷
+	vector<Quadric> quadrics(vertexCount, Quadric{});
+	glm::vec3 minPos(numeric_limits<float>::max());
+	glm::vec3 maxPos(-numeric_limits<float>::max());
+	for (const auto& v : vertices)
+	{
+		minPos = glm::min(minPos, v.pos);
+		maxPos = glm::max(maxPos, v.pos);
+	}
+	double extent = max(static_cast<double>(glm::length(maxPos - minPos)), 1e-12);
+	const double borderWeight = 10.0;
+
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		glm::dvec3 p[3];
+		for (int k = 0; k < 3; k++)
+		{
+			p[k] = glm::dvec3(vertices[indices[i + k]].pos);
+		}
+		glm::dvec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+		double area = glm::length(normal);
+		if (area <= 0.0)
+		{
+			continue;
+		}
+		normal /= area;
+
+		Quadric q = Quadric::fromPlane(normal, -glm::dot(normal, p[0]), area);
+		for (int k = 0; k < 3; k++)
+		{
+			quadrics[canonical[indices[i + k]]].add(q);
+		}
+
+		for (int k = 0; k < 3; k++)
+		{
+			uint32_t a = canonical[indices[i + k]];
+			uint32_t b = canonical[indices[i + (k + 1) % 3]];
+			uint32_t count = edgeCounts[edgeKey(a, b)];
+			if (count == 1)
+			{
+				glm::dvec3 edge = p[(k + 1) % 3] - p[k];
+				double length = glm::length(edge);
+				glm::dvec3 borderNormal = glm::cross(edge, normal);
+				double borderLength = glm::length(borderNormal);
+				if (borderLength > 0.0)
+				{
+					borderNormal /= borderLength;
+					Quadric bq = Quadric::fromPlane(borderNormal, -glm::dot(borderNormal, p[k]), length * length * borderWeight);
+					quadrics[a].add(bq);
+					quadrics[b].add(bq);
+				}
+				if (kind[a] == Manifold) kind[a] = Border;
+				if (kind[b] == Manifold) kind[b] = Border;
+			}
+			else if (count > 2)
+			{
+				kind[a] = Locked;
+				kind[b] = Locked;
+			}
+		}
+	}
+
+	// \_łȂ_͑\_̕ނƓ񎟌덷g (LockedȊOł͎g\)
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		if (kind[canonical[v]] == Locked)
+		{
+			kind[v] = Locked;
+		}
+	}
+
+	double errorLimit = static_cast<double>(targetError) * extent;
+	errorLimit *= errorLimit;
+
+	vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+	vector<uint32_t> adjacency;
+	vector<uint32_t> remap(vertexCount);
+	vector<uint8_t> touched(vertexCount);
+	vector<Collapse> collapses;
+	vector<uint32_t> bestCollapse(vertexCount);
+
+	while (result.size() > targetIndexCount)
+	{
+		size_t triangleCount = result.size() / 3;
+
+		// _ -> Op`
+		fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (uint32_t index : result)
+		{
+			adjacencyOffsets[index + 1]++;
+		}
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+		}
+		adjacency.resize(result.size());
+		{
+			vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < result.size(); i++)
+			{
+				adjacency[cursor[result[i]]++] = static_cast<uint32_t>(i / 3);
+			}
+		}
+
+		// _Ƃɍł덷̏kI
+		const uint32_t none = numeric_limits<uint32_t>::max();
+		fill(bestCollapse.begin(), bestCollapse.end(), none);
+		collapses.clear();
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				for (int dir = 0; dir < 2; dir++)
+				{
+					uint32_t from = result[i + (dir == 0 ? k : (k + 1) % 3)];
+					uint32_t to = result[i + (dir == 0 ? (k + 1) % 3 : k)];
+					if (kind[from] == Locked)
+					{
+						continue;
+					}
+					if (kind[from] == Border && (kind[to] == Manifold || edgeCounts[edgeKey(canonical[from], canonical[to])] != 1))
+					{
+						continue;
+					}
+
+					Quadric q = quadrics[from];
+					q.add(quadrics[canonical[to]]);
+					double error = q.error(vertices[to].pos);
+					if (bestCollapse[from] == none)
+					{
+						bestCollapse[from] = static_cast<uint32_t>(collapses.size());
+						collapses.push_back({ from, to, error });
+					}
+					else if (error < collapses[bestCollapse[from]].error)
+					{
+						collapses[bestCollapse[from]] = { from, to, error };
+					}
+				}
+			}
+		}
+
+		sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+		// 1̏kł悻2̎Op`
+		size_t collapsesNeeded = (triangleCount - targetIndexCount / 3) / 2 + 1;
+		size_t applied = 0;
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			remap[v] = v;
+		}
+		fill(touched.begin(), touched.end(), 0);
+
+		for (const auto& collapse : collapses)
+		{
+			if (collapse.error > errorLimit || applied >= collapsesNeeded)
+			{
+				break;
+			}
+			if (touched[collapse.from] || touched[collapse.to])
+			{
+				continue;
+			}
+
+			// kŗԂOp`΍̗pȂ
+			bool flipped = false;
+			const glm::vec3& target = vertices[collapse.to].pos;
+			for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1] && !flipped; a++)
+			{
+				const uint32_t* tri = &result[adjacency[a] * 3];
+				if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to)
+				{
+					continue;
+				}
+				glm::vec3 p[3];
+				glm::vec3 q[3];
+				for (int k = 0; k < 3; k++)
+				{
+					p[k] = vertices[tri[k]].pos;
+					q[k] = tri[k] == collapse.from ? target : p[k];
+				}
+				glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+				glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+				flipped = glm::dot(before, after) <= 0.0f;
+			}
+			if (flipped)
+			{
+				continue;
+			}
+
+			remap[collapse.from] = collapse.to;
+			quadrics[canonical[collapse.to]].add(quadrics[collapse.from]);
+
+			// [1-ringۂƎgpς݂ɂB̑̏k񂪁ȀkŌ`̕ςOp`
+			// Â܂ܗԂ蔻肷邱ƂȂȂ
+			for (uint32_t v : { collapse.from, collapse.to })
+			{
+				for (uint32_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; a++)
+				{
+					const uint32_t* tri = &result[adjacency[a] * 3];
+					touched[tri[0]] = 1;
+					touched[tri[1]] = 1;
+					touched[tri[2]] = 1;
+				}
+			}
+			resultError = max(resultError, static_cast<float>(sqrt(collapse.error) / extent));
+			applied++;
+		}
+
+		if (applied == 0)
+		{
+			break;
+		}
+
+		// k𔽉fAׂꂽOp`
+		size_t write = 0;
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			uint32_t a = remap[result[i + 0]];
+			uint32_t b = remap[result[i + 1]];
+			uint32_t c = remap[result[i + 2]];
+			if (canonical[a] != canonical[b] && canonical[b] != canonical[c] && canonical[c] != canonical[a])
+			{
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+			}
+		}
+		result.resize(write);
+	}
+
+	if (pResultError != nullptr)
+	{
+		*pResultError = resultError;
+	}
+	return result;
+}
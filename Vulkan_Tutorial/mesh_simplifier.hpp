@@ -0,0 +1,10 @@
+#pragma once
+
+#include "my_vulkan.hpp"
+
+// 񎟌덷(QEM)ɂӂ̏kŃbVȗA_QƂCfbNXԂ
+// _͊̂̂֏k񂷂邾Ȃ̂Œ_obt@LODԂŋLł
+// UVV[ȂǓʒuɕ̒_鏊ƁA񑽗l̂̕ӂ̒_͓Ȃ
+// targetErrorpResultError̓bV̑傫(AABB̑Ίp)ɑ΂鑊Ό덷
+vector<uint32_t> simplifyMesh(const vector<Vertex>& vertices, const vector<uint32_t>& indices, size_t targetIndexCount,
+	float targetError, float* pResultError);
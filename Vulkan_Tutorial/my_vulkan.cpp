@@ -1,13 +1,34 @@
 #include "my_vulkan.hpp"
+#include "mesh_loader.hpp"
+#include "mesh_optimizer.hpp"
+#include "mesh_simplifier.hpp"
+#include "mesh_clusters.hpp"
+#include "mesh_cache.hpp"
+#include "geometry_arena.hpp"
+#include "profiler.hpp"
+#include "pixel_swizzle.hpp"
+#include "task_graph.hpp"
+#include "render_graph.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
 void Vulkan::run()
 {
-	initWindow("Ushinokoku");
+	setProfileThreadName("CPU main");
+	if (!headless)
+	{
+		initWindow("Ushinokoku");
+	}
 	initVulkan();
-	mainLoop();
+	if (headless)
+	{
+		benchmarkLoop();
+	}
+	else
+	{
+		mainLoop();
+	}
 	cleanup();
 }
 
@@ -25,53 +46,185 @@ void Vulkan::framebufferResizeCallback(GLFWwindow *pWindow, int width, int heigh
 {
 	auto app = reinterpret_cast<Vulkan*>(glfwGetWindowUserPointer(pWindow));
 	app->framebufferResized = true;
+	app->lastResizeEvent = chrono::steady_clock::now();
 }
 
+// ̊eiKˑ֌W̃OtɂāAˑ̏ÎsɎs
+// L[ւ̒oEfoCX̊mہEEBhEGiK͂̃XbhAȊO (t@C̓ǂݍ݂Ɖ́A
+// pCvC̃RpCȂǂCPȔd) ̓[J[œ
 void Vulkan::initVulkan()
 {
-	createInstance();
-	createSurface();
-	selectPhysicalDevice();
-	createDevice();
-	createSwapChain();
-	createImageViews();
-	createRenderPass();
-	createDescriptorSetLayout();
-	createGraphicsPipeline();
-	createFrameBuffers();
-	createCommandPools();
-	createTextureImage();
-	createTextureImageView();
-	createTextureSampler();
-	createVertexBuffer(vertices.data(), sizeof(vertices[0]) * vertices.size());
-	createIndexBuffer(indices.data(), sizeof(indices[0]) * indices.size());
-	createUniformBuffers();
-	createDescriptorPool();
-	createDescriptorSets();
-	createCommandBuffer();
-	createSyncObjects();
+	bool meshCacheUsable = false;
+	vector<TaskGraphNode> steps = {
+		// foCXvȂiK͍ŏn߂
+		{ "texture decode", {}, false, [&]() { loadTexturePixels(); } },
+		{ "mesh cache probe", {}, false, [&]() { meshCacheUsable = probeMeshCache(); } },
+		{ "load model", { "mesh cache probe" }, false, [&]() { if (!meshCacheUsable) loadModel(); } },
+		{ "mesh lods", { "load model" }, false, [&]() { if (!meshCacheUsable) createMeshLods(); } },
+
+		{ "instance", {}, true, [&]() { createInstance(); } },
+		{ "surface", { "instance" }, true, [&]() { if (!headless) createSurface(); } },
+		{ "physical device", { "surface" }, true, [&]() { selectPhysicalDevice(); } },
+		{ "device", { "physical device" }, true, [&]() { createDevice(); } },
+		{ "frame timeline", { "device" }, true, [&]() { createFrameTimeline(); } },
+		{ "swapchain", { "device" }, true, [&]() { createSwapChain(); } },
+		{ "image views", { "swapchain" }, true, [&]() { createImageViews(); } },
+		{ "render pass", { "swapchain" }, false, [&]() { createRenderPass(); } },
+		{ "descriptor set layout", { "device" }, false, [&]() { createDescriptorSetLayout(); } },
+		{ "graphics pipeline", { "render pass", "descriptor set layout" }, false, [&]() { createGraphicsPipeline(); } },
+		{ "culling pipeline", { "descriptor set layout" }, false, [&]() { createCullingPipeline(); } },
+		{ "depth reduce pipeline", { "device" }, false, [&]() { createDepthReducePipeline(); } },
+		{ "depth resources", { "render pass" }, true, [&]() { createDepthResources(); } },
+		{ "framebuffers", { "image views", "depth resources" }, true, [&]() { createFrameBuffers(); } },
+		// 1񂫂̃R}h̓^CCŊ҂
+		{ "command pools", { "frame timeline" }, true, [&]() { createCommandPools(); } },
+		{ "texture image", { "texture decode", "command pools" }, true, [&]() { createTextureImage(); } },
+		{ "texture image view", { "texture image" }, true, [&]() { createTextureImageView(); } },
+		{ "texture sampler", { "device" }, false, [&]() { createTextureSampler(); } },
+		{ "mesh buffers", { "mesh lods", "command pools" }, true, [&]()
+			{
+				if (meshCacheUsable && loadMeshCache())
+				{
+					return;
+				}
+				if (meshCacheUsable)
+				{
+					// ׂɃLbVς
+					loadModel();
+					createMeshLods();
+				}
+				createMeshBuffers();
+			} },
+		{ "scene", { "mesh buffers" }, true, [&]() { createScene(); } },
+		{ "scene buffers", { "scene" }, true, [&]() { createSceneBuffers(); } },
+		{ "uniform buffers", { "device" }, true, [&]() { createUniformBuffers(); } },
+		{ "culling resources", { "scene" }, true, [&]() { createCullingResources(); } },
+		{ "gpu profiler", { "command pools" }, true, [&]() { createGpuProfiler(); } },
+		{ "descriptor pool", { "device" }, true, [&]() { createDescriptorPool(); } },
+		{ "descriptor sets", { "descriptor pool", "descriptor set layout", "uniform buffers", "texture image view", "texture sampler",
+			"scene buffers", "culling resources" }, true, [&]() { createDescriptorSets(); } },
+		{ "depth pyramid", { "descriptor sets", "depth resources", "depth reduce pipeline" }, true, [&]() { createDepthPyramid(); } },
+		{ "readback buffers", { "swapchain" }, true, [&]() { createReadbackBuffers(); } },
+		{ "command buffer", { "command pools" }, true, [&]() { createCommandBuffer(); } },
+		{ "sync objects", { "swapchain" }, true, [&]() { createSyncObjects(); } },
+	};
+
+	uint32_t threadCount = enableParallelInit ? clamp(thread::hardware_concurrency(), 1u, INIT_MAX_THREADS) : 1;
+	TaskGraphStats stats{};
+	runTaskGraph(&steps, threadCount, &stats);
+	reportInitTimings(steps, stats);
+
+	if (enableModelReload && !modelPath.empty())
+	{
+		getSourceStamp(modelPath, &modelSourceSize, &modelSourceTime);
+	}
+}
+
+// eiK̊JnEԁEXbhƁAŒoH (ȏ͕񉻂ŏk܂Ȃ) o
+void Vulkan::reportInitTimings(const vector<TaskGraphNode>& steps, const TaskGraphStats& stats)
+{
+	cout << "init: " << stats.wallMs << " ms on " << stats.threadCount << " threads (" << stats.workMs << " ms of work, critical path "
+		<< stats.criticalPathMs << " ms:";
+	for (size_t i = 0; i < stats.criticalPath.size(); i++)
+	{
+		cout << (i == 0 ? " " : " -> ") << steps[stats.criticalPath[i]].name;
+	}
+	cout << ")" << endl;
+
+	vector<const TaskGraphNode*> sorted;
+	for (const auto& step : steps)
+	{
+		sorted.push_back(&step);
+	}
+	sort(sorted.begin(), sorted.end(), [](const TaskGraphNode* a, const TaskGraphNode* b) { return a->startMs < b->startMs; });
+	for (const TaskGraphNode* step : sorted)
+	{
+		cout << "init:   " << step->name << " " << step->durationMs << " ms (at " << step->startMs << " ms, "
+			<< (step->thread == 0 ? string("main") : "worker " + to_string(step->thread)) << ")" << endl;
+	}
 }
 
 void Vulkan::mainLoop()
 {
 	while (!glfwWindowShouldClose(window))
 	{
-		glfwPollEvents();
+		// ŏ̓Cxg܂Ŗ
+		int width = 0, height = 0;
+		glfwGetFramebufferSize(window, &width, &height);
+		if (width == 0 || height == 0)
+		{
+			glfwWaitEvents();
+			continue;
+		}
+
+		setProfileFrame(frameNumber);
+		PROFILE_ZONE("frame");
+		{
+			PROFILE_ZONE("pace");
+			paceFrame(); // ͂ǂޑOɑ҂
+		}
+		{
+			PROFILE_ZONE("poll events");
+			glfwPollEvents();
+		}
+		checkModelReload();
 		drawFrame();
 	}
 
 	vkDeviceWaitIdle(device); // ̌cleanup()
+	finishFrames();
+}
+
+// GPU󂢂ĂĂԁBǂłȂŌ̐t[̋ԂƉ摜ÂɏEĂg[X
+void Vulkan::finishFrames()
+{
+	for (uint32_t i = 0; i < framesInFlight; i++)
+	{
+		readGpuProfiler((currentFrame + i) % framesInFlight);
+		readPipelineStats((currentFrame + i) % framesInFlight);
+		deliverReadback((currentFrame + i) % framesInFlight);
+	}
+	collectCpuProfile();
+	writeTrace();
+
+	if (!profilerSettings.memoryReportPath.empty())
+	{
+		ofstream file(profilerSettings.memoryReportPath, ios::trunc);
+		writeMemoryReport(file);
+		if (!file)
+		{
+			throw runtime_error("failed to write memory report: " + profilerSettings.memoryReportPath);
+		}
+	}
 }
 
 void Vulkan::cleanup()
 {
-	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	for (uint32_t i = 0; i < framesInFlight; i++)
 	{
 		for (auto semaphore : { imageAvailableSemaphores[i], renderFinishedSemaphores[i] })
 		{
 			vkDestroySemaphore(device, semaphore, nullptr);
 		}
-		vkDestroyFence(device, inFlightFences[i], nullptr);
+	}
+	for (auto fence : inFlightFences)
+	{
+		vkDestroyFence(device, fence, nullptr);
+	}
+	vkDestroySemaphore(device, timelineSemaphore, nullptr);
+	vkDestroySemaphore(device, computeTimelineSemaphore, nullptr);
+	for (auto queryPool : gpuQueryPools)
+	{
+		vkDestroyQueryPool(device, queryPool, nullptr);
+	}
+	for (auto queryPool : statsQueryPools)
+	{
+		vkDestroyQueryPool(device, queryPool, nullptr);
+	}
+	for (size_t i = 0; i < readbackBuffers.size(); i++)
+	{
+		vkDestroyBuffer(device, readbackBuffers[i], nullptr);
+		freeMemory(readbackBuffersMemory[i]);
 	}
 	for (auto pool : commandPools)
 	{
@@ -79,42 +232,89 @@ void Vulkan::cleanup()
 	}
 	vkDestroyPipeline(device, pipeline, nullptr);
 	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+	vkDestroyPipeline(device, cullPipeline, nullptr);
+	vkDestroyPipeline(device, clusterCullPipeline, nullptr);
+	vkDestroyPipelineLayout(device, cullPipelineLayout, nullptr);
+	vkDestroyPipeline(device, depthReducePipeline, nullptr);
+	vkDestroyPipelineLayout(device, depthReducePipelineLayout, nullptr);
 	vkDestroyRenderPass(device, renderPass, nullptr);
+	vkDestroyRenderPass(device, renderPassLoad, nullptr);
 	cleanupSwapChain();
+	flushDeferredDestroys(); // mainLoop̍ŌGPU͋󂢂Ă
+	vkDestroySampler(device, depthPyramidSampler, nullptr);
+	vkDestroyDescriptorSetLayout(device, depthReduceSetLayout, nullptr);
 	vkDestroySampler(device, textureSampler, nullptr);
 	vkDestroyImageView(device, textureImageView, nullptr);
 	vkDestroyImage(device, textureImage, nullptr);
-	vkFreeMemory(device, textureImageMemory, nullptr);
-	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	freeMemory(textureImageMemory);
+	for (uint32_t i = 0; i < framesInFlight; i++)
 	{
 		vkDestroyBuffer(device, uniformBuffers[i], nullptr);
-		vkFreeMemory(device, uniformBuffersMemory[i], nullptr);
+		freeMemory(uniformBuffersMemory[i]);
 	}
+	destroySceneResources();
 	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
 	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+	vkDestroyDescriptorSetLayout(device, cullDescriptorSetLayout, nullptr);
 	vkDestroyBuffer(device, vertexBuffer, nullptr);
 	vkDestroyBuffer(device, indexBuffer, nullptr);
-	vkFreeMemory(device, vertexBufferMemory, nullptr);
-	vkFreeMemory(device, indexBufferMemory, nullptr);
+	freeMemory(vertexBufferMemory);
+	freeMemory(indexBufferMemory);
 	vkDeviceWaitIdle(device); // ƂĂ
+	reportLeakedMemory();
 	vkDestroyDevice(device, nullptr); // j
 	vkDestroySurfaceKHR(instance, surface, nullptr);
 	vkDestroyInstance(instance, nullptr); // ԍŌɔjVulkanIuWFNg
-	glfwDestroyWindow(window);
-	glfwTerminate();
+	if (!headless)
+	{
+		glfwDestroyWindow(window);
+		glfwTerminate();
+	}
 }
 
+// Xbv`F[Ƃ̑傫Ɉˑ郊\[Xxjɉ
+// swapChaiñnh͍蒼oldSwapchainɎĝŎc
 void Vulkan::cleanupSwapChain()
 {
 	for (auto framebuffer : swapChainFramebuffers)
 	{
-		vkDestroyFramebuffer(device, framebuffer, nullptr);
+		destroyLater(DeferredObject::Framebuffer, framebuffer);
 	}
 	for (auto imageView : swapChainImageViews)
 	{
-		vkDestroyImageView(device, imageView, nullptr);
+		destroyLater(DeferredObject::ImageView, imageView);
+	}
+	for (size_t i = 0; i < offscreenImagesMemory.size(); i++)
+	{
+		destroyLater(DeferredObject::Image, swapChainImages[i]);
+		destroyLater(DeferredObject::Memory, offscreenImagesMemory[i]);
+	}
+	offscreenImagesMemory.clear();
+	destroyLater(DeferredObject::ImageView, depthImageView);
+	for (const auto& resource : frameGraph.resources)
+	{
+		if (resource.transient)
+		{
+			destroyLater(DeferredObject::Image, resource.handle);
+		}
+	}
+	for (auto memory : frameGraph.transientMemory)
+	{
+		destroyLater(DeferredObject::Memory, memory);
+	}
+	frameGraph.transientMemory.clear();
+	destroyLater(DeferredObject::DescriptorPool, depthPyramidDescriptorPool);
+	for (auto view : depthPyramidMips)
+	{
+		destroyLater(DeferredObject::ImageView, view);
 	}
-	vkDestroySwapchainKHR(device, swapChain, nullptr);
+	destroyLater(DeferredObject::ImageView, depthPyramidView);
+	destroyLater(DeferredObject::Image, depthPyramid);
+	destroyLater(DeferredObject::Memory, depthPyramidMemory);
+	destroyLater(DeferredObject::SwapChain, swapChain);
+	swapChainFramebuffers.clear();
+	swapChainImageViews.clear();
+	depthPyramidMips.clear();
 }
 
 void Vulkan::createInstance()
@@ -127,16 +327,36 @@ void Vulkan::createInstance()
 	appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
 	appInfo.apiVersion = VK_API_VERSION_1_0;
 
-	uint32_t glfwExtensionCount = 0;
-	const char** glfwExtensions;
+	// T[tFX̊g (wbhXł͗vȂ)
+	vector<const char*> instanceExtensions;
+	if (!headless)
+	{
+		uint32_t glfwExtensionCount = 0;
+		const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		instanceExtensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+	}
 
-	glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+	// Vulkan 1.0ŃfoCX̊g@\(^CCZ}tHȂ)₢킹̂Ɏg
+	{
+		uint32_t count = 0;
+		vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr);
+		vector<VkExtensionProperties> available(count);
+		vkEnumerateInstanceExtensionProperties(nullptr, &count, available.data());
+		for (const auto& extension : available)
+		{
+			if (strcmp(extension.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0)
+			{
+				instanceExtensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+				physicalDeviceProperties2Supported = true;
+			}
+		}
+	}
 
 	VkInstanceCreateInfo instanceInfo{};
 	instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 	instanceInfo.pApplicationInfo = &appInfo;
-	instanceInfo.enabledExtensionCount = glfwExtensionCount;
-	instanceInfo.ppEnabledExtensionNames = glfwExtensions;
+	instanceInfo.enabledExtensionCount = static_cast<uint32_t>(instanceExtensions.size());
+	instanceInfo.ppEnabledExtensionNames = instanceExtensions.data();
 	instanceInfo.enabledLayerCount = 0;
 
 	if (enableValidationLayers)
@@ -169,20 +389,160 @@ void Vulkan::selectPhysicalDevice()
 		vkEnumeratePhysicalDevices(instance, &count, physDevs.data());
 	}
 
-	// KGPUI
-	for (const auto& p : physDevs)
+	// w (--deviceAȂΊϐ) ͔ԍÖꕔ
+	string requested = deviceOverride;
+	string requestedBy = "--device";
+	if (requested.empty())
+	{
+		const char* pEnv = getenv(DEVICE_OVERRIDE_ENV);
+		requested = pEnv != nullptr ? pEnv : "";
+		requestedBy = DEVICE_OVERRIDE_ENV;
+	}
+
+	// KGPUɓ_tAԍ̂IԁB_Ȃ񋓏Ő̂ (GPUlavapipec)
+	// w肪΂Ɉvŏ̂̂g
+	int64_t bestScore = -1;
+	for (uint32_t i = 0; i < physDevs.size(); i++)
 	{
-		if (isDeviceSuitable(p))
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physDevs[i], &properties);
+		string reason;
+		bool suitable = isDeviceSuitable(physDevs[i], &reason);
+		int64_t score = suitable ? scorePhysicalDevice(physDevs[i], &reason) : -1;
+		cout << "gpu [" << i << "] " << properties.deviceName << ": " << (suitable ? "score " + to_string(score) : "unsuitable")
+			<< " (" << reason << ")" << endl;
+
+		if (requested.empty())
 		{
-			physicalDevice = p;
-			break;
+			if (score > bestScore)
+			{
+				physicalDevice = physDevs[i];
+				bestScore = score;
+			}
+		}
+		else if (physicalDevice == VK_NULL_HANDLE &&
+			(requested == to_string(i) || strstr(properties.deviceName, requested.c_str()) != nullptr))
+		{
+			if (!suitable)
+			{
+				throw runtime_error("requested GPU is unsuitable: " + string(properties.deviceName) + " (" + reason + ")");
+			}
+			physicalDevice = physDevs[i];
 		}
 	}
 
 	if (physicalDevice == VK_NULL_HANDLE)
 	{
-		throw runtime_error("failed to find a asuitable GPU!");
+		throw runtime_error(requested.empty() ? "failed to find a asuitable GPU!" : "no GPU matches " + requestedBy + "=" + requested);
+	}
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	cout << "gpu: using " << properties.deviceName << (requested.empty() ? " (highest score)" : " (" + requestedBy + "=" + requested + ")") << endl;
+
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+	heapMemoryUsage.assign(memoryProperties.memoryHeapCount, MemoryUsage{});
+}
+
+// GPUقǍ_BނԌAނ̒̓EL[E@\EAPIo[WŌ܂
+// pReasonɓ𑫂
+int64_t Vulkan::scorePhysicalDevice(VkPhysicalDevice physDev, string* pReason)
+{
+	VkPhysicalDeviceProperties properties{};
+	VkPhysicalDeviceFeatures features{};
+	VkPhysicalDeviceMemoryProperties physMemProps{};
+	vkGetPhysicalDeviceProperties(physDev, &properties);
+	vkGetPhysicalDeviceFeatures(physDev, &features);
+	vkGetPhysicalDeviceMemoryProperties(physDev, &physMemProps);
+
+	int64_t score = 0;
+	string& reason = *pReason;
+	auto add = [&](int64_t points, const string& what)
+	{
+		score += points;
+		reason += (reason.empty() ? "" : ", ") + what + " +" + to_string(points);
+	};
+
+	switch (properties.deviceType)
+	{
+	case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: add(10000, "discrete"); break;
+	case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: add(5000, "integrated"); break;
+	case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: add(2000, "virtual"); break;
+	case VK_PHYSICAL_DEVICE_TYPE_CPU: add(0, "cpu"); break;
+	default: add(1000, "other"); break;
+	}
+
+	// ԑ傫DEVICE_LOCAL̃q[v (GPU͋L񍐂̂Ŏނ̓_zȂ悤ɂ)
+	VkDeviceSize deviceLocal = 0;
+	for (uint32_t i = 0; i < physMemProps.memoryHeapCount; i++)
+	{
+		if (physMemProps.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+		{
+			deviceLocal = max(deviceLocal, physMemProps.memoryHeaps[i].size);
+		}
+	}
+	int64_t deviceLocalMiB = static_cast<int64_t>(deviceLocal / (1024 * 1024));
+	add(min<int64_t>(deviceLocalMiB / 32, 1000), to_string(deviceLocalMiB) + " MiB device-local");
+
+	// OtBbNXƕʂ̃Rs[gE]L[Δ񓯊Ɏg
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physDev, &familyCount, nullptr);
+	vector<VkQueueFamilyProperties> families(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physDev, &familyCount, families.data());
+	bool asyncCompute = false;
+	bool dedicatedTransfer = false;
+	for (const auto& family : families)
+	{
+		bool graphics = (family.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+		bool compute = (family.queueFlags & VK_QUEUE_COMPUTE_BIT) != 0;
+		asyncCompute |= compute && !graphics;
+		dedicatedTransfer |= (family.queueFlags & VK_QUEUE_TRANSFER_BIT) && !graphics && !compute;
+	}
+	if (asyncCompute)
+	{
+		add(100, "async compute queue");
+	}
+	if (dedicatedTransfer)
+	{
+		add(50, "transfer queue");
+	}
+
+	// gΑȂ (ȂĂ) @\
+	uint32_t extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties(physDev, nullptr, &extensionCount, nullptr);
+	vector<VkExtensionProperties> extensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(physDev, nullptr, &extensionCount, extensions.data());
+	auto hasExtension = [&](const char* name)
+	{
+		return any_of(extensions.begin(), extensions.end(), [&](const VkExtensionProperties& e) { return strcmp(e.extensionName, name) == 0; });
+	};
+	if (features.multiDrawIndirect)
+	{
+		add(50, "multiDrawIndirect");
+	}
+	if (hasExtension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME))
+	{
+		add(50, "draw_indirect_count");
+	}
+	if (hasExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+	{
+		add(30, "timeline_semaphore");
 	}
+	if (hasExtension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+	{
+		add(10, "present_wait");
+	}
+	if (features.pipelineStatisticsQuery)
+	{
+		add(10, "pipelineStatisticsQuery");
+	}
+	if (properties.limits.timestampComputeAndGraphics)
+	{
+		add(10, "timestamps");
+	}
+
+	uint32_t minor = VK_VERSION_MINOR(properties.apiVersion);
+	add(10 * minor, "Vulkan 1." + to_string(minor));
+	return score;
 }
 
 void Vulkan::createDevice()
@@ -215,17 +575,145 @@ void Vulkan::createDevice()
 
 	// T|[g̗L
 	requiredFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+	requiredFeatures.drawIndirectFirstInstance = VK_TRUE; // JOʂ̃CX^X͈͂firstInstanceœn
+	multiDrawIndirectSupported = supportedFeatures.multiDrawIndirect == VK_TRUE;
 	requiredFeatures.tessellationShader = VK_TRUE;
 	requiredFeatures.geometryShader = VK_TRUE;
 	requiredFeatures.samplerAnisotropy = VK_TRUE;
+	requiredFeatures.pipelineStatisticsQuery = enablePipelineStatistics ? supportedFeatures.pipelineStatisticsQuery : VK_FALSE;
+	pipelineStatisticsSupported = requiredFeatures.pipelineStatisticsQuery == VK_TRUE;
+
+	// bVbg̕`搔GPUn̂ɎgBȂΏ܂ŕׂ`R}h̎c0Ŗ߂
+	vector<const char*> enabledExtensions = deviceExtensions;
+	bool timelineSemaphoreExtension = false;
+	bool presentIdExtension = false;
+	bool presentWaitExtension = false;
+	// CX^X1.0Ȃ̂ŁA_Ci~bN_Oˑ (1.1/1.2ŏi) gꏏɗLɂ
+	const vector<const char*> dynamicRenderingExtensions = {
+		VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
+		VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,
+		VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME,
+		VK_KHR_MULTIVIEW_EXTENSION_NAME,
+		VK_KHR_MAINTENANCE_2_EXTENSION_NAME,
+	};
+	size_t dynamicRenderingExtensionCount = 0;
+	{
+		uint32_t count = 0;
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &count, nullptr);
+		vector<VkExtensionProperties> available(count);
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &count, available.data());
+		for (const auto& extension : available)
+		{
+			if (strcmp(extension.extensionName, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0)
+			{
+				enabledExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+				drawIndirectCountSupported = true;
+			}
+			if (strcmp(extension.extensionName, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) == 0)
+			{
+				timelineSemaphoreExtension = true;
+			}
+			presentIdExtension |= strcmp(extension.extensionName, VK_KHR_PRESENT_ID_EXTENSION_NAME) == 0;
+			presentWaitExtension |= strcmp(extension.extensionName, VK_KHR_PRESENT_WAIT_EXTENSION_NAME) == 0;
+			for (const char* name : dynamicRenderingExtensions)
+			{
+				dynamicRenderingExtensionCount += strcmp(extension.extensionName, name) == 0 ? 1 : 0;
+			}
+		}
+	}
+
+	// ^CCZ}tHpresent_id/present_waitA_Ci~bN_O͊gĂ@\LɂKv
+	VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures{};
+	timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+	VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+	presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+	VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+	presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+	dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+	auto pfnGetPhysicalDeviceFeatures2 = physicalDeviceProperties2Supported ? reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+		vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR")) : nullptr;
+	if (pfnGetPhysicalDeviceFeatures2 != nullptr)
+	{
+		timelineFeatures.pNext = &presentIdFeatures;
+		presentIdFeatures.pNext = &presentWaitFeatures;
+		presentWaitFeatures.pNext = &dynamicRenderingFeatures;
+		VkPhysicalDeviceFeatures2KHR features2{};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+		features2.pNext = &timelineFeatures;
+		pfnGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+		timelineSemaphoreSupported = enableTimelineSemaphore && timelineSemaphoreExtension && timelineFeatures.timelineSemaphore == VK_TRUE;
+		presentWaitSupported = !headless && presentIdExtension && presentWaitExtension &&
+			presentIdFeatures.presentId == VK_TRUE && presentWaitFeatures.presentWait == VK_TRUE;
+		dynamicRenderingSupported = enableDynamicRendering && dynamicRenderingExtensionCount == dynamicRenderingExtensions.size() &&
+			dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+	}
+
+	// ĝpNextɂȂ
+	void* pFeatureChain = nullptr;
+	if (timelineSemaphoreSupported)
+	{
+		enabledExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+		timelineFeatures.pNext = pFeatureChain;
+		timelineFeatures.timelineSemaphore = VK_TRUE;
+		pFeatureChain = &timelineFeatures;
+	}
+	if (presentWaitSupported)
+	{
+		enabledExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+		enabledExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+		presentIdFeatures.pNext = pFeatureChain;
+		presentIdFeatures.presentId = VK_TRUE;
+		presentWaitFeatures.pNext = &presentIdFeatures;
+		presentWaitFeatures.presentWait = VK_TRUE;
+		pFeatureChain = &presentWaitFeatures;
+	}
+	if (dynamicRenderingSupported)
+	{
+		enabledExtensions.insert(enabledExtensions.end(), dynamicRenderingExtensions.begin(), dynamicRenderingExtensions.end());
+		dynamicRenderingFeatures.pNext = pFeatureChain;
+		dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+		pFeatureChain = &dynamicRenderingFeatures;
+	}
+
+	// 񓯊Rs[g̓L[܂҂킹Ƀ^CCZ}tHg
+	const char* asyncComputeOff = nullptr;
+	if (!enableAsyncCompute)
+	{
+		asyncComputeOff = "disabled";
+	}
+	else if (!queueIndices.computeFamily.has_value())
+	{
+		asyncComputeOff = "no separate compute queue family";
+	}
+	else if (!timelineSemaphoreSupported)
+	{
+		asyncComputeOff = "no timeline semaphore";
+	}
+	asyncComputeEnabled = asyncComputeOff == nullptr;
+	if (asyncComputeEnabled)
+	{
+		computeQueueFamily = queueIndices.computeFamily.value();
+		// v[gpƓt@~ȂÃL[p (t@~2xnĂ͂Ȃ)
+		if (uniqueQueueFamilies.insert(computeQueueFamily).second)
+		{
+			VkDeviceQueueCreateInfo queueCI{};
+			queueCI.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queueCI.queueFamilyIndex = computeQueueFamily;
+			queueCI.queueCount = 1;
+			queueCI.pQueuePriorities = &queue_priority;
+			devQueueInfo.push_back(queueCI);
+		}
+	}
 
 	VkDeviceCreateInfo deviceInfo{};
 	deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	deviceInfo.pNext = pFeatureChain;
 	deviceInfo.pQueueCreateInfos = devQueueInfo.data();
 	deviceInfo.queueCreateInfoCount = static_cast<uint32_t>( devQueueInfo.size() );
 	deviceInfo.pEnabledFeatures = &requiredFeatures;
-	deviceInfo.enabledExtensionCount = static_cast<uint32_t>( deviceExtensions.size() );
-	deviceInfo.ppEnabledExtensionNames = deviceExtensions.data();
+	deviceInfo.enabledExtensionCount = static_cast<uint32_t>( enabledExtensions.size() );
+	deviceInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
 	if (enableValidationLayers)
 	{
@@ -248,6 +736,62 @@ void Vulkan::createDevice()
 
 	// v[gL[̃nh擾
 	vkGetDeviceQueue(device, queueIndices.presentFamily.value(), 0, &presentQueue);
+
+	if (drawIndirectCountSupported)
+	{
+		pfnCmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+			vkGetDeviceProcAddr(device, "vkCmdDrawIndexedIndirectCountKHR"));
+		drawIndirectCountSupported = pfnCmdDrawIndexedIndirectCount != nullptr;
+	}
+	if (timelineSemaphoreSupported)
+	{
+		pfnGetSemaphoreCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(
+			vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR"));
+		pfnWaitSemaphores = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR"));
+		timelineSemaphoreSupported = pfnGetSemaphoreCounterValue != nullptr && pfnWaitSemaphores != nullptr;
+	}
+	if (presentWaitSupported)
+	{
+		pfnWaitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(device, "vkWaitForPresentKHR"));
+		presentWaitSupported = pfnWaitForPresent != nullptr;
+	}
+	if (dynamicRenderingSupported)
+	{
+		pfnCmdBeginRendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(vkGetDeviceProcAddr(device, "vkCmdBeginRenderingKHR"));
+		pfnCmdEndRendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(device, "vkCmdEndRenderingKHR"));
+		dynamicRenderingSupported = pfnCmdBeginRendering != nullptr && pfnCmdEndRendering != nullptr;
+	}
+	cout << "rendering: " << (dynamicRenderingSupported ? "dynamic rendering" : "render pass objects") << endl;
+	if (asyncComputeEnabled && !timelineSemaphoreSupported)
+	{
+		asyncComputeOff = "no timeline semaphore";
+		asyncComputeEnabled = false;
+	}
+	if (asyncComputeEnabled)
+	{
+		vkGetDeviceQueue(device, computeQueueFamily, 0, &computeQueue);
+		sharedQueueFamilies.assign(uniqueQueueFamilies.begin(), uniqueQueueFamilies.end());
+	}
+	cout << "async compute: " << (asyncComputeEnabled ? "queue family " + to_string(computeQueueFamily) :
+		string("off (") + asyncComputeOff + "), compute runs on the graphics queue") << endl;
+
+	// ^CX^vg邩
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	vector<VkQueueFamilyProperties> queueFamilyProps;
+	{
+		uint32_t count = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, nullptr);
+		queueFamilyProps.resize(count);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, queueFamilyProps.data());
+	}
+	timestampPeriod = properties.limits.timestampPeriod;
+	uint32_t timestampValidBits = queueFamilyProps[queueIndices.graphicsFamily.value()].timestampValidBits;
+	timestampsSupported = properties.limits.timestampPeriod > 0.0f && timestampValidBits > 0;
+	timestampMask = timestampValidBits >= 64 ? ~0ull : (1ull << timestampValidBits) - 1;
+	// vZL[̃^CX^v}XNœǂނ̂ŁALrbgg
+	computeTimestampsSupported = asyncComputeEnabled && timestampsSupported &&
+		queueFamilyProps[computeQueueFamily].timestampValidBits == timestampValidBits;
 }
 
 void Vulkan::createSurface()
@@ -261,11 +805,21 @@ void Vulkan::createSurface()
 
 void Vulkan::createSwapChain()
 {
+	if (headless)
+	{
+		createOffscreenImages();
+		return;
+	}
+
 	SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice);
 	VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
 	VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
 	uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+	if (presentSettings.swapchainImages > 0)
+	{
+		imageCount = max(presentSettings.swapchainImages, swapChainSupport.capabilities.minImageCount);
+	}
 
 	if (0 < swapChainSupport.capabilities.maxImageCount && swapChainSupport.capabilities.maxImageCount < imageCount)
 	{
@@ -281,6 +835,14 @@ void Vulkan::createSwapChain()
 	swapchainInfo.imageExtent = extent;
 	swapchainInfo.imageArrayLayers = 1;
 	swapchainInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	if (readbackEnabled)
+	{
+		if (!(swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+		{
+			throw runtime_error("failed to enable readback: swapchain images cannot be copied");
+		}
+		swapchainInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	}
 
 	QueueFamilyIndices indices = findQueueFamiles(physicalDevice);
 	uint32_t queueFamilyIndices[] = { indices.graphicsFamily.value(), indices.presentFamily.value() };
@@ -299,9 +861,10 @@ void Vulkan::createSwapChain()
 	}
 	swapchainInfo.preTransform = swapChainSupport.capabilities.currentTransform;
 	swapchainInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-	swapchainInfo.presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+	presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+	swapchainInfo.presentMode = presentMode;
 	swapchainInfo.clipped = VK_TRUE;
-	swapchainInfo.oldSwapchain = VK_NULL_HANDLE;
+	swapchainInfo.oldSwapchain = swapChain; // 蒼̎͑ÕXbv`F[̎p
 
 	if (vkCreateSwapchainKHR(device, &swapchainInfo, nullptr, &swapChain) != VK_SUCCESS)
 	{
@@ -320,17 +883,44 @@ void Vulkan::createSwapChain()
 	swapChainExtent = extent;
 }
 
+// Xbv`F[̑̉摜Bacquire͏ԂɎg񂵁Apresent͂Ȃ
+// t[̑҂ŉ摜gframesInFlightÕt[܂ł͏IĂ̂ŁAframesInFlightȏɂ
+void Vulkan::createOffscreenImages()
+{
+	uint32_t imageCount = max(framesInFlight, presentSettings.swapchainImages);
+	swapChainImageFormat = VK_FORMAT_B8G8R8A8_SRGB; // EBhE̎Ɠ`
+	swapChainExtent = { benchmarkSettings.width, benchmarkSettings.height };
+	swapChainImages.resize(imageCount);
+	offscreenImagesMemory.resize(imageCount);
+	for (uint32_t i = 0; i < imageCount; i++)
+	{
+		createImage(swapChainExtent.width, swapChainExtent.height, 1, swapChainImageFormat, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			&swapChainImages[i], &offscreenImagesMemory[i], MemoryCategory::RenderTarget, "offscreen color");
+	}
+}
+
 void Vulkan::createImageViews()
 {
 	swapChainImageViews.resize(swapChainImages.size());
 	for (uint32_t i = 0; i < swapChainImages.size(); i++)
 	{
-		swapChainImageViews[i] = createImageView(swapChainImages[i], swapChainImageFormat);
+		swapChainImageViews[i] = createImageView(swapChainImages[i], swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 0, 1);
 	}
 }
 
 void Vulkan::createRenderPass()
 {
+	depthFormat = findDepthFormat();
+
+	// _Ci~bN_Oł̓A^b`g`ɓn̂ŁA_[pX͍Ȃ
+	if (dynamicRenderingSupported)
+	{
+		return;
+	}
+
+	// OpX: NAĕ`悷
+	// CAEg̑JڂƃpX̑O̓̓t[Ot̃oAōŝŁAA^b`g̃CAEĝ܂܏o肷
 	VkAttachmentDescription colorAttachment{};
 	colorAttachment.format = swapChainImageFormat;
 	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -338,39 +928,56 @@ void Vulkan::createRenderPass()
 	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentDescription depthAttachment{};
+	depthAttachment.format = depthFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; // Hi-ŽɂȂ
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 	VkAttachmentReference colorAttachmentRef{};
 	colorAttachmentRef.attachment = 0; //index of colorAttachment
 	colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+	VkAttachmentReference depthAttachmentRef{};
+	depthAttachmentRef.attachment = 1;
+	depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
 	VkSubpassDescription subpass{};
 	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 	subpass.colorAttachmentCount = 1;
 	subpass.pColorAttachments = &colorAttachmentRef;
+	subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
-	VkSubpassDependency dependency{};
-	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-	dependency.dstSubpass = 0;
-	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.srcAccessMask = 0;
-	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
 
 	VkRenderPassCreateInfo renderPassInfo{};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	renderPassInfo.attachmentCount = 1;
-	renderPassInfo.pAttachments = &colorAttachment;
+	renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	renderPassInfo.pAttachments = attachments.data();
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpass;
-	renderPassInfo.dependencyCount = 1;
-	renderPassInfo.pDependencies = &dependency;
 
 	if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
 	{
 		throw runtime_error("failed to create render pass!");
 	}
+
+	// 㔼pX: ǑʂǂݍŒǉ`悷
+	// (loadOpȊO͓Ȃ̂ŃpCvCƃt[obt@Lł)
+	attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+
+	if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPassLoad) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to create render pass!");
+	}
 }
 
 void Vulkan::createGraphicsPipeline()
@@ -395,8 +1002,9 @@ void Vulkan::createGraphicsPipeline()
 
 	VkPipelineShaderStageCreateInfo shaderStages[]	= {vertShaderStageInfo, fragShaderStageInfo};
 
-	auto bindingDescription = Vertex::getBindingDescription();
-	auto attributeDescriptions = Vertex::getAttributeDescriptions();
+	auto bindingDescription = VERTEX_FORMAT == VertexFormat::Float ? Vertex::getBindingDescription() : PackedVertex::getBindingDescription();
+	auto attributeDescriptions = VERTEX_FORMAT == VertexFormat::Float ? Vertex::getAttributeDescriptions() :
+		PackedVertex::getAttributeDescriptions(VERTEX_FORMAT);
 
 	VkPipelineVertexInputStateCreateInfo vertexInput{};
 	vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -461,6 +1069,14 @@ void Vulkan::createGraphicsPipeline()
 	multisampling.alphaToCoverageEnable = VK_FALSE;
 	multisampling.alphaToOneEnable = VK_FALSE;
 
+	VkPipelineDepthStencilStateCreateInfo depthStencil{};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.depthTestEnable = VK_TRUE;
+	depthStencil.depthWriteEnable = VK_TRUE;
+	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+	depthStencil.depthBoundsTestEnable = VK_FALSE;
+	depthStencil.stencilTestEnable = VK_FALSE;
+
 	VkPipelineColorBlendAttachmentState colorBlendAttachment{};
 	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
 	colorBlendAttachment.blendEnable = VK_FALSE;
@@ -503,12 +1119,23 @@ void Vulkan::createGraphicsPipeline()
 	pipelineInfo.pViewportState = &viewportState;
 	pipelineInfo.pRasterizationState = &rasterizer;
 	pipelineInfo.pMultisampleState = &multisampling;
-	pipelineInfo.pDepthStencilState = nullptr; // Optional
+	pipelineInfo.pDepthStencilState = &depthStencil;
 	pipelineInfo.pColorBlendState = &colorBlending;
 	pipelineInfo.pDynamicState = &dynamicState;
 	pipelineInfo.layout = pipelineLayout;
 	pipelineInfo.renderPass = renderPass;
 	pipelineInfo.subpass = 0; //index
+
+	// _Ci~bN_Oł̓_[pX̑ɃA^b`ǧ`n (XeV͎gȂ)
+	VkPipelineRenderingCreateInfoKHR renderingInfo{};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+	renderingInfo.colorAttachmentCount = 1;
+	renderingInfo.pColorAttachmentFormats = &swapChainImageFormat;
+	renderingInfo.depthAttachmentFormat = depthFormat;
+	if (dynamicRenderingSupported)
+	{
+		pipelineInfo.pNext = &renderingInfo;
+	}
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineInfo.basePipelineIndex = -1;
 
@@ -540,12 +1167,19 @@ VkShaderModule Vulkan::createShaderModule(vector<char>& code)
 
 void Vulkan::createFrameBuffers()
 {
+	// _Ci~bN_Oł͗vȂ̂ŁAXbv`F[̍蒼ō̂
+	if (dynamicRenderingSupported)
+	{
+		return;
+	}
+
 	swapChainFramebuffers.resize(swapChainImageViews.size());
 
 	for (size_t i = 0; i < swapChainImageViews.size(); i++)
 	{
 		vector<VkImageView> attachments = {
-			swapChainImageViews[i]
+			swapChainImageViews[i],
+			depthImageView
 		};
 
 		VkFramebufferCreateInfo framebufferInfo{};
@@ -582,11 +1216,15 @@ void Vulkan::createCommandPools()
 {
 	QueueFamilyIndices indices = findQueueFamiles(physicalDevice);
 	createCommandPool(&graphicsCmdPool, indices.graphicsFamily.value());
+	if (asyncComputeEnabled)
+	{
+		createCommandPool(&computeCmdPool, computeQueueFamily);
+	}
 }
 
 void Vulkan::createCommandBuffer()
 {
-	commandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+	commandBuffers.resize(framesInFlight);
 	VkCommandBufferAllocateInfo allocInfo{};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	allocInfo.commandPool = graphicsCmdPool;
@@ -597,6 +1235,22 @@ void Vulkan::createCommandBuffer()
 	{
 		throw runtime_error("failed to create commanBuffers!");
 	}
+	if (!asyncComputeEnabled)
+	{
+		return;
+	}
+
+	lateCommandBuffers.resize(framesInFlight);
+	if (vkAllocateCommandBuffers(device, &allocInfo, lateCommandBuffers.data()) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to create commanBuffers!");
+	}
+	computeCommandBuffers.resize(framesInFlight);
+	allocInfo.commandPool = computeCmdPool;
+	if (vkAllocateCommandBuffers(device, &allocInfo, computeCommandBuffers.data()) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to create compute commanBuffers!");
+	}
 }
 
 VkCommandBuffer Vulkan::beginSingleTimeCommands()
@@ -632,14 +1286,24 @@ void Vulkan::endSingleTimeCommands(VkCommandBuffer commandBuffer)
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &commandBuffer;
 
-	vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-	vkQueueWaitIdle(graphicsQueue);
+	// L[̒o͏Ɋ̂ŁA̒l҂Ă΂܂ł̃t[IĂ
+	uint64_t value = submitTimeline(graphicsQueue, submitInfo, nullptr, VK_NULL_HANDLE);
+	if (timelineSemaphoreSupported)
+	{
+		waitTimelineValue(value);
+	}
+	else
+	{
+		vkQueueWaitIdle(graphicsQueue);
+		completedTimelineValue = value;
+	}
 
 	vkFreeCommandBuffers(device, graphicsCmdPool, 1, &commandBuffer);
 }
 
 void Vulkan::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
 {
+	PROFILE_ZONE("recordCommandBuffer");
 	VkCommandBufferBeginInfo beginInfo{};
 	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
@@ -648,43 +1312,64 @@ void Vulkan::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIn
 		throw runtime_error("failed to begin commandBuffer!");
 	}
 
-	VkClearValue clearValue{};
-	clearValue.color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
-
-	VkRenderPassBeginInfo renderPassInfo{};
-	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	renderPassInfo.renderPass = renderPass;
-	renderPassInfo.framebuffer = swapChainFramebuffers[imageIndex];
-	renderPassInfo.renderArea.offset = { 0, 0 };
-	renderPassInfo.renderArea.extent = swapChainExtent;
-	renderPassInfo.clearValueCount = 1;
-	renderPassInfo.pClearValues = &clearValue;
-
-	// _Ci~bN
-	VkViewport viewport{};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = static_cast<float>(swapChainExtent.width);
-	viewport.height = static_cast<float>(swapChainExtent.height);
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-
-	VkRect2D scissor{};
-	scissor.offset = { 0, 0 };
-	scissor.extent = swapChainExtent;
+	// 񓯊Rs[g̎̓^CX^ṽZbgƃJO(O)recordAsyncComputeɋL^Ă
+	if (!asyncComputeEnabled)
+	{
+		gpuScopes[currentFrame].clear();
+		gpuScopeFrames[currentFrame] = frameNumber;
+		if (!gpuQueryPools.empty())
+		{
+			vkCmdResetQueryPool(commandBuffer, gpuQueryPools[currentFrame], 0, GPU_PROFILER_MAX_SCOPES * 2);
+		}
+	}
+	statsPasses[currentFrame].clear();
+	if (!statsQueryPools.empty())
+	{
+		vkCmdResetQueryPool(commandBuffer, statsQueryPools[currentFrame], 0, PIPELINE_STATS_MAX_PASSES);
+	}
+	uint32_t frameScope = beginGpuScope(commandBuffer, "frame");
 
+	// SbVA[i1g̃obt@ɂ̂ŁAoCh̓R}hobt@̍ŏ1ōς (_[pX܂ŗL)
 	VkBuffer vertexBuffers[] = { vertexBuffer };
-	size_t offsets[] = {0};
-
-	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	VkDeviceSize offsets[] = { 0 };
 	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-	vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[currentFrame], 0, nullptr);
-	vkCmdDrawIndexed(commandBuffer, indices.size(), 1, 0, 0, 0);
-	vkCmdEndRenderPass(commandBuffer);
+	vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, geometryIndexType);
+
+	// 荞ރC[WւApXƂ̊Ԃ̃oA̓OtL^
+	frameImageIndex = imageIndex;
+	frameGraph.resources[frameGraphColor].handle = swapChainImages[imageIndex];
+	frameGraph.resources[frameGraphPyramid].handle = depthPyramid;
+
+	// 񓯊Rs[g̎recordAsyncComputeL^Ă
+	if (!asyncComputeEnabled && depthPyramidNeedsClear)
+	{
+		recordDepthPyramidClear(commandBuffer);
+		depthPyramidNeedsClear = false;
+	}
+
+	uint32_t passCount = static_cast<uint32_t>(frameGraph.passes.size());
+	if (asyncComputeEnabled)
+	{
+		// 㔼̕`̑OŒo𕪂Ãt[̃JO㔼̕`ƕsɑ悤ɂ
+		recordRenderGraph(frameGraph, commandBuffer, 0, frameGraphLatePass);
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			throw runtime_error("failed to record command!");
+		}
+		commandBuffer = lateCommandBuffers[currentFrame];
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw runtime_error("failed to begin commandBuffer!");
+		}
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, geometryIndexType);
+		recordRenderGraph(frameGraph, commandBuffer, frameGraphLatePass, passCount);
+	}
+	else
+	{
+		recordRenderGraph(frameGraph, commandBuffer, 0, passCount);
+	}
+	endGpuScope(commandBuffer, frameScope);
 
 	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
 	{
@@ -692,11 +1377,148 @@ void Vulkan::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIn
 	}
 }
 
+// vZL[ŎsÕJOBOtBbNX̃R}hobt@GPUŎŝŁA^CX^ṽZbgł
+void Vulkan::recordAsyncCompute(VkCommandBuffer commandBuffer)
+{
+	PROFILE_ZONE("recordAsyncCompute");
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to begin compute commandBuffer!");
+	}
+
+	gpuScopes[currentFrame].clear();
+	gpuScopeFrames[currentFrame] = frameNumber;
+	if (!gpuQueryPools.empty())
+	{
+		vkCmdResetQueryPool(commandBuffer, gpuQueryPools[currentFrame], 0, GPU_PROFILER_MAX_SCOPES * 2);
+	}
+
+	if (depthPyramidNeedsClear)
+	{
+		recordDepthPyramidClear(commandBuffer);
+		depthPyramidNeedsClear = false;
+	}
+
+	uint32_t scope = beginGpuScope(commandBuffer, "cull pass 0");
+	recordCulling(commandBuffer, 0);
+	endGpuScope(commandBuffer, scope);
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to record compute command!");
+	}
+}
+
+// Õt[Hi-Z܂ł҂ăJOAvZL[̃^CCi߂
+void Vulkan::submitAsyncCompute()
+{
+	uint64_t signalValue = computeTimelineValue + 1;
+	VkTimelineSemaphoreSubmitInfoKHR timelineInfo{};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+	timelineInfo.waitSemaphoreValueCount = 1;
+	timelineInfo.pWaitSemaphoreValues = &hiZTimelineValue;
+	timelineInfo.signalSemaphoreValueCount = 1;
+	timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.pNext = &timelineInfo;
+	submitInfo.waitSemaphoreCount = 1;
+	submitInfo.pWaitSemaphores = &timelineSemaphore;
+	submitInfo.pWaitDstStageMask = &waitStage;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &computeCommandBuffers[currentFrame];
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &computeTimelineSemaphore;
+
+	if (vkQueueSubmit(computeQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to submit compute queue!");
+	}
+	computeTimelineValue = signalValue;
+}
+
+void Vulkan::recordSceneDraw(VkCommandBuffer commandBuffer, uint32_t pass)
+{
+	// _Ci~bN
+	VkViewport viewport{};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(swapChainExtent.width);
+	viewport.height = static_cast<float>(swapChainExtent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor{};
+	scissor.offset = { 0, 0 };
+	scissor.extent = swapChainExtent;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[currentFrame], 0, nullptr);
+	// instanceCount̓JOpXށBpXƂdrawCountł
+	uint32_t drawCount = static_cast<uint32_t>(drawTemplates.size()) / 2;
+	VkDeviceSize drawOffset = pass * drawCount * sizeof(VkDrawIndexedIndirectCommand);
+	if (multiDrawIndirectSupported)
+	{
+		vkCmdDrawIndexedIndirect(commandBuffer, drawCommandBuffers[currentFrame], drawOffset, drawCount, sizeof(VkDrawIndexedIndirectCommand));
+	}
+	else
+	{
+		for (uint32_t i = 0; i < drawCount; i++)
+		{
+			vkCmdDrawIndexedIndirect(commandBuffer, drawCommandBuffers[currentFrame], drawOffset + i * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+		}
+	}
+
+	// bVbg̕`͑Oɋl߂ĂAclusterStateBuffersɂ
+	if (clusterDrawCapacity > 0)
+	{
+		VkDeviceSize clusterDrawOffset = pass * clusterDrawCapacity * sizeof(VkDrawIndexedIndirectCommand);
+		if (drawIndirectCountSupported)
+		{
+			VkDeviceSize countOffset = pass * sizeof(ClusterCullState) + offsetof(ClusterCullState, drawCount);
+			pfnCmdDrawIndexedIndirectCount(commandBuffer, clusterDrawBuffers[currentFrame], clusterDrawOffset,
+				clusterStateBuffers[currentFrame], countOffset, clusterDrawCapacity, sizeof(VkDrawIndexedIndirectCommand));
+		}
+		else
+		{
+			vkCmdDrawIndexedIndirect(commandBuffer, clusterDrawBuffers[currentFrame], clusterDrawOffset, clusterDrawCapacity,
+				sizeof(VkDrawIndexedIndirectCommand));
+		}
+	}
+}
+
 void Vulkan::drawFrame()
 {
-	vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+	PROFILE_ZONE("drawFrame");
+	{
+		PROFILE_ZONE("wait frame");
+		waitTimelineValue(frameTimelineValues[currentFrame]);
+	}
+	measureFrameLatency(currentFrame);
+	readCullingResults(currentFrame);
+	readGpuProfiler(currentFrame);
+	readPipelineStats(currentFrame);
+	deliverReadback(currentFrame);
+	collectDeferredDestroys();
+	updateDepthPyramidBinding(currentFrame);
 	uint32_t imageIndex = 0;
-	VkResult imgResult = vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+	VkResult imgResult = VK_SUCCESS;
+	if (headless)
+	{
+		imageIndex = static_cast<uint32_t>(frameNumber % swapChainImages.size());
+	}
+	else
+	{
+		PROFILE_ZONE("acquire");
+		imgResult = vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+	}
 	if (imgResult == VK_ERROR_OUT_OF_DATE_KHR)
 	{
 		recreateSwapChain();
@@ -707,27 +1529,78 @@ void Vulkan::drawFrame()
 		throw runtime_error("failed to aquire swap chain image!");
 	}
 	updateUniformBuffer(currentFrame);
-	vkResetFences(device, 1, &inFlightFences[currentFrame]); // VOi
+	if (!timelineSemaphoreSupported)
+	{
+		vkResetFences(device, 1, &inFlightFences[currentFrame]); // VOi
+	}
 	vkResetCommandBuffer(commandBuffers[currentFrame], 0);
+	if (asyncComputeEnabled)
+	{
+		recordAsyncCompute(computeCommandBuffers[currentFrame]);
+	}
 	recordCommandBuffer(commandBuffers[currentFrame], imageIndex);
 
 	vector<VkSemaphore> waitSemaphores = { imageAvailableSemaphores[currentFrame]};
+	vector<VkPipelineStageFlags> waitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+	vector<uint64_t> waitValues = { 0 };
 	vector<VkSemaphore> signalSemaphores = {renderFinishedSemaphores[currentFrame]};
-	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+	if (headless)
+	{
+		waitSemaphores.clear();
+		waitStages.clear();
+		waitValues.clear();
+		signalSemaphores.clear();
+	}
+	if (asyncComputeEnabled)
+	{
+		// O̕`̊Ԑڈƌ㔼̃JOvZL[̌ʂǂ
+		waitSemaphores.push_back(computeTimelineSemaphore);
+		waitStages.push_back(VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT);
+		waitValues.push_back(computeTimelineValue + 1);
+	}
 
 	VkSubmitInfo submitInfo{};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 	submitInfo.waitSemaphoreCount = waitSemaphores.size();
 	submitInfo.pWaitSemaphores = waitSemaphores.data();
-	submitInfo.pWaitDstStageMask = waitStages;
+	submitInfo.pWaitDstStageMask = waitStages.data();
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &commandBuffers[currentFrame];
 	submitInfo.signalSemaphoreCount = signalSemaphores.size();
 	submitInfo.pSignalSemaphores = signalSemaphores.data();
 
-	if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
 	{
-		throw runtime_error("failed to submit draw command queue!");
+		PROFILE_ZONE("submit");
+		if (asyncComputeEnabled)
+		{
+			submitAsyncCompute();
+
+			// Hi-Z܂ (̃t[̃JO҂) ƌ㔼̕` (\ƃt[̊) ɕĒo
+			submitInfo.signalSemaphoreCount = 0;
+			hiZTimelineValue = submitTimeline(graphicsQueue, submitInfo, waitValues.data(), VK_NULL_HANDLE);
+
+			VkSubmitInfo lateSubmitInfo{};
+			lateSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			lateSubmitInfo.commandBufferCount = 1;
+			lateSubmitInfo.pCommandBuffers = &lateCommandBuffers[currentFrame];
+			lateSubmitInfo.signalSemaphoreCount = signalSemaphores.size();
+			lateSubmitInfo.pSignalSemaphores = signalSemaphores.data();
+			frameTimelineValues[currentFrame] = submitTimeline(graphicsQueue, lateSubmitInfo, nullptr, VK_NULL_HANDLE);
+		}
+		else
+		{
+			frameTimelineValues[currentFrame] = submitTimeline(graphicsQueue, submitInfo, nullptr,
+				timelineSemaphoreSupported ? VK_NULL_HANDLE : inFlightFences[currentFrame]);
+		}
+	}
+
+	if (headless)
+	{
+		currentFrame = (currentFrame + 1) % framesInFlight;
+		frameNumber++;
+		collectCpuProfile();
+		return;
 	}
 
 	vector<VkSwapchainKHR>swapChains = { swapChain };
@@ -741,358 +1614,3150 @@ void Vulkan::drawFrame()
 	presentInfo.pImageIndices = &imageIndex;
 	presentInfo.pResults = nullptr;
 
-	VkResult presentResult = vkQueuePresentKHR(presentQueue, &presentInfo);
+	// present_waitŕ\ꂽm邽߂ɔԍt
+	VkPresentIdKHR presentIdInfo{};
+	uint64_t id = lastPresentId + 1;
+	if (presentWaitSupported)
+	{
+		presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+		presentIdInfo.swapchainCount = 1;
+		presentIdInfo.pPresentIds = &id;
+		presentInfo.pNext = &presentIdInfo;
+	}
 
-	if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR || framebufferResized)
+	VkResult presentResult;
+	{
+		PROFILE_ZONE("present");
+		presentResult = vkQueuePresentKHR(presentQueue, &presentInfo);
+	}
+	framePresentIds[currentFrame] = presentWaitSupported ? id : 0;
+	frameInputTimes[currentFrame] = frameInputTime;
+	lastPresentId = id;
+
+	// TCYύX̘ÁA~܂Ă1񂾂蒼 (gȂȂ͑҂Ȃ)
+	bool resizeSettled = chrono::steady_clock::now() - lastResizeEvent >= chrono::milliseconds(RESIZE_SETTLE_MS);
+	if (presentResult == VK_ERROR_OUT_OF_DATE_KHR ||
+		((presentResult == VK_SUBOPTIMAL_KHR || framebufferResized) && resizeSettled))
 	{
 		recreateSwapChain();
-		framebufferResized = false;
 	}
 	else if (presentResult != VK_SUCCESS)
 	{
 		throw runtime_error("failed to present!");
 	}
 
-	currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+	currentFrame = (currentFrame + 1) % framesInFlight;
+	frameNumber++;
+	collectCpuProfile();
+	reportStats();
 }
 
 void Vulkan::createSyncObjects()
 {
-	imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-	renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-	inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+	imageAvailableSemaphores.resize(framesInFlight);
+	renderFinishedSemaphores.resize(framesInFlight);
+	frameTimelineValues.assign(framesInFlight, 0); // 0͍ŏ犮Ă
+	framePresentIds.assign(framesInFlight, 0);
+	frameInputTimes.assign(framesInFlight, chrono::steady_clock::time_point{});
 
 	VkSemaphoreCreateInfo semaphoreInfo{};
 	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
+	for (uint32_t i = 0; i < framesInFlight; i++)
+	{
+		if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
+			vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS)
+		{
+			throw runtime_error("failed to create synchronization Objects");
+		}
+	}
+
+	// ^CC΃tFX͗vȂ
+	if (timelineSemaphoreSupported)
+	{
+		return;
+	}
+
+	inFlightFences.resize(framesInFlight);
 	VkFenceCreateInfo fenceInfo{};
 	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	for (uint32_t i = 0; i < framesInFlight; i++)
 	{
-		if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
-			vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS ||
-			vkCreateFence(device, &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS)
+		if (vkCreateFence(device, &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS)
 		{
 			throw runtime_error("failed to create synchronization Objects");
 		}
 	}
 }
 
-void Vulkan::recreateSwapChain()
+//=================================================================
+// Frame Graph
+//=================================================================
+
+// pXǂݏ郊\[X錾ApXԂ̃oAƐ[x̃OtɔC
+// L[̒̓B񓯊Rs[g̃JO(O)̓Ot̊OŁAL[̊Ԃ̓Z}tHő҂
+void Vulkan::buildFrameGraph()
 {
-	// EBhETCYO̎
-	int width = 0, height = 0;
-	glfwGetFramebufferSize(window, &width, &height);
-	while (width == 0 || height == 0)
+	// ꎞC[W͂̃t[ł͐[xŋLNȂ̂ŁAdȂȂ2ׂȃOtŊm߂Ă
+	// (Hi-Z͎̃t[Aǂݖ߂CPUt[ɓǂނ̂Ńt[܂Ő)
+	checkRenderGraphAliasing();
+
+	frameGraph = RenderGraph{};
+	RenderGraph* pGraph = &frameGraph;
+
+	VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+	if (depthFormat != VK_FORMAT_D32_SFLOAT)
 	{
-		glfwGetFramebufferSize(window, &width, &height);
-		glfwWaitEvents();
+		depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
 	}
 
-	vkDeviceWaitIdle(device);
-	cleanupSwapChain();
-	createSwapChain();
-	createImageViews();
-	createFrameBuffers();
+	// Hi-Ẑ߂ɃTvO
+	VkImageCreateInfo depthInfo{};
+	depthInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	depthInfo.imageType = VK_IMAGE_TYPE_2D;
+	depthInfo.extent = { swapChainExtent.width, swapChainExtent.height, 1 };
+	depthInfo.mipLevels = 1;
+	depthInfo.arrayLayers = 1;
+	depthInfo.format = depthFormat;
+	depthInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	depthInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	depthInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	depthInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	frameGraphColor = addRenderGraphImage(pGraph, "color", VK_IMAGE_ASPECT_COLOR_BIT, RenderGraphAccess::Acquire);
+	frameGraphDepth = addRenderGraphTransientImage(pGraph, "depth", depthInfo, depthAspect);
+	// Hi-Z͎̃t[̑OJOǂ
+	frameGraphPyramid = addRenderGraphImage(pGraph, "depth pyramid", VK_IMAGE_ASPECT_COLOR_BIT, RenderGraphAccess::ComputeWrite);
+	// t[Ƃ̃obt@ (bVbg̕`ƃJE^͕`R}hƈꏏɈ)
+	uint32_t drawCommands = addRenderGraphBuffer(pGraph, "draw commands", RenderGraphAccess::None);
+	uint32_t visible = addRenderGraphBuffer(pGraph, "visible instances", RenderGraphAccess::None);
+	uint32_t stats = addRenderGraphBuffer(pGraph, "culling stats", RenderGraphAccess::None);
+	uint32_t cullState = addRenderGraphBuffer(pGraph, "culling state", RenderGraphAccess::None);
+	// LOD̗͑St[1Ȃ̂ŁAÕt[݂̏҂
+	uint32_t objectLods = addRenderGraphBuffer(pGraph, "object lods", RenderGraphAccess::ComputeReadWrite);
+
+	auto cullPass = [this](uint32_t pass)
+	{
+		return [this, pass](VkCommandBuffer commandBuffer)
+		{
+			uint32_t scope = beginGpuScope(commandBuffer, pass == 0 ? "cull pass 0" : "cull pass 1");
+			recordCulling(commandBuffer, pass);
+			endGpuScope(commandBuffer, scope);
+		};
+	};
+	vector<RenderGraphUse> cullUses = {
+		{ frameGraphPyramid, RenderGraphAccess::ComputeRead },
+		{ drawCommands, RenderGraphAccess::ComputeReadWrite },
+		{ visible, RenderGraphAccess::ComputeReadWrite },
+		{ stats, RenderGraphAccess::ComputeReadWrite },
+		{ cullState, RenderGraphAccess::ComputeReadWrite },
+		{ objectLods, RenderGraphAccess::ComputeReadWrite },
+	};
+	vector<RenderGraphUse> drawUses = {
+		{ frameGraphColor, RenderGraphAccess::ColorAttachment },
+		{ frameGraphDepth, RenderGraphAccess::DepthAttachment },
+		{ drawCommands, RenderGraphAccess::IndirectRead },
+		{ visible, RenderGraphAccess::VertexRead },
+	};
+
+	// O: Ot[ŌĂIuWFNgOt[Hi-ZŔ肵ĕ`
+	if (!asyncComputeEnabled)
+	{
+		addRenderGraphPass(pGraph, "cull pass 0", cullUses, cullPass(0));
+	}
+	addRenderGraphPass(pGraph, "draw pass 0", drawUses, [this](VkCommandBuffer commandBuffer) { recordDrawPass(commandBuffer, 0); });
+
+	// t[̐[xHi-Z蒼
+	addRenderGraphPass(pGraph, "hi-z", {
+		{ frameGraphDepth, RenderGraphAccess::ComputeSampled },
+		{ frameGraphPyramid, RenderGraphAccess::ComputeReadWrite },
+	}, [this](VkCommandBuffer commandBuffer)
+	{
+		uint32_t scope = beginGpuScope(commandBuffer, "hi-z");
+		recordDepthPyramid(commandBuffer);
+		endGpuScope(commandBuffer, scope);
+	});
+
+	// 㔼: OŎՕƔ肳ꂽ̂VHi-ZōĔ肵ĕ`
+	addRenderGraphPass(pGraph, "cull pass 1", cullUses, cullPass(1));
+	frameGraphLatePass = addRenderGraphPass(pGraph, "draw pass 1", drawUses,
+		[this](VkCommandBuffer commandBuffer) { recordDrawPass(commandBuffer, 1); });
+
+	if (readbackEnabled)
+	{
+		uint32_t readback = addRenderGraphBuffer(pGraph, "readback", RenderGraphAccess::None);
+		addRenderGraphPass(pGraph, "readback", {
+			{ frameGraphColor, RenderGraphAccess::TransferRead },
+			{ readback, RenderGraphAccess::TransferWrite },
+		}, [this](VkCommandBuffer commandBuffer)
+		{
+			uint32_t scope = beginGpuScope(commandBuffer, "readback");
+			recordReadback(commandBuffer, frameImageIndex);
+			endGpuScope(commandBuffer, scope);
+		});
+		setRenderGraphOutput(pGraph, readback, RenderGraphAccess::HostRead);
+	}
+
+	// wbhX̉摜̓v[gȂ̂ł̂܂܎c
+	setRenderGraphOutput(pGraph, frameGraphColor, headless ? RenderGraphAccess::None : RenderGraphAccess::Present);
+	setRenderGraphOutput(pGraph, stats, RenderGraphAccess::HostRead);
+	setRenderGraphOutput(pGraph, frameGraphPyramid, RenderGraphAccess::None);
+	setRenderGraphOutput(pGraph, objectLods, RenderGraphAccess::None);
+	compileRenderGraph(pGraph);
+
+	createRenderGraphTransients(pGraph, device, [this](const VkMemoryRequirements& memRequirements, VkDeviceMemory* pMemory)
+	{
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = memRequirements.size;
+		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		allocateMemory(allocInfo, MemoryCategory::RenderTarget, "transient attachments", pMemory);
+	});
+
+	cout << "render graph: " << frameGraph.passes.size() << " passes (" << frameGraph.culledPasses << " culled), "
+		<< frameGraph.barrierCount << " barriers (" << frameGraph.imageTransitionCount << " image transitions), transient memory "
+		<< frameGraph.transientAllocatedBytes / (1024.0 * 1024.0) << " MB (" << frameGraph.transientBytes / (1024.0 * 1024.0)
+		<< " MB without aliasing)" << endl;
 }
 
-void Vulkan::createVertexBuffer(void *pData, size_t size)
+// O̓NAĕ`A㔼͑Ǒʂǂݍŕ`
+// A^b`g̃CAEg̓t[OtJڍς
+void Vulkan::recordDrawPass(VkCommandBuffer commandBuffer, uint32_t pass)
 {
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-	createBuffer(size, &stagingBuffer, &stagingBufferMemory, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-		         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-	void* pointer;
-	vkMapMemory(device, stagingBufferMemory, 0, size, 0, &pointer);
-	memcpy(pointer, pData, size);
-	vkUnmapMemory(device, stagingBufferMemory);
+	array<VkClearValue, 2> clearValues{};
+	clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+	clearValues[1].depthStencil = { 1.0f, 0 };
+	VkAttachmentLoadOp loadOp = pass == 0 ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+
+	const char* name = pass == 0 ? "draw pass 0" : "draw pass 1";
+	uint32_t scope = beginGpuScope(commandBuffer, name);
+	uint32_t statsPass = beginPipelineStats(commandBuffer, name);
+	if (dynamicRenderingSupported)
+	{
+		VkRenderingAttachmentInfoKHR colorAttachment{};
+		colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+		colorAttachment.imageView = swapChainImageViews[frameImageIndex];
+		colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		colorAttachment.loadOp = loadOp;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.clearValue = clearValues[0];
+
+		VkRenderingAttachmentInfoKHR depthAttachment{};
+		depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+		depthAttachment.imageView = depthImageView;
+		depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthAttachment.loadOp = loadOp;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; // Hi-ŽɂȂ
+		depthAttachment.clearValue = clearValues[1];
+
+		VkRenderingInfoKHR renderingInfo{};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+		renderingInfo.renderArea.offset = { 0, 0 };
+		renderingInfo.renderArea.extent = swapChainExtent;
+		renderingInfo.layerCount = 1;
+		renderingInfo.colorAttachmentCount = 1;
+		renderingInfo.pColorAttachments = &colorAttachment;
+		renderingInfo.pDepthAttachment = &depthAttachment;
+
+		pfnCmdBeginRendering(commandBuffer, &renderingInfo);
+		recordSceneDraw(commandBuffer, pass);
+		pfnCmdEndRendering(commandBuffer);
+	}
+	else
+	{
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = pass == 0 ? renderPass : renderPassLoad;
+		renderPassInfo.framebuffer = swapChainFramebuffers[frameImageIndex];
+		renderPassInfo.renderArea.offset = { 0, 0 };
+		renderPassInfo.renderArea.extent = swapChainExtent;
+		if (loadOp == VK_ATTACHMENT_LOAD_OP_CLEAR)
+		{
+			renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+			renderPassInfo.pClearValues = clearValues.data();
+		}
+
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		recordSceneDraw(commandBuffer, pass);
+		vkCmdEndRenderPass(commandBuffer);
+	}
+	endPipelineStats(commandBuffer, statsPass);
+	endGpuScope(commandBuffer, scope);
+}
+
+//=================================================================
+// Frame Timeline
+//=================================================================
+
+// ̃Abv[hli߂̂ŁAfoCXɗpӂ
+void Vulkan::createFrameTimeline()
+{
+	cout << "frame sync: " << (timelineSemaphoreSupported ? "timeline semaphore" : "fences") << endl;
+	if (!timelineSemaphoreSupported)
+	{
+		return;
+	}
+
+	VkSemaphoreTypeCreateInfoKHR typeInfo{};
+	typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+	typeInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext = &typeInfo;
+	if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &timelineSemaphore) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to create timeline semaphore!");
+	}
+	// vZL[͕ʂ̒l̗ (Z}tH2̃L[Mƒl鏇ۏ؂łȂ)
+	if (asyncComputeEnabled && vkCreateSemaphore(device, &semaphoreInfo, nullptr, &computeTimelineSemaphore) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to create compute timeline semaphore!");
+	}
+}
+
+// ^CC̎̒lMoāA̒lԂ
+// ^CCȂfenceŊǂ (fenceȂ̒o͌Ăяo҂؂)
+// pWaitValues̓^CCZ}tH҂n (oCiZ}tH̏0)
+uint64_t Vulkan::submitTimeline(VkQueue queue, const VkSubmitInfo& submitInfo, const uint64_t* pWaitValues, VkFence fence)
+{
+	uint64_t value = submittedTimelineValue + 1;
+
+	VkSubmitInfo info = submitInfo;
+	vector<VkSemaphore> signalSemaphores(info.pSignalSemaphores, info.pSignalSemaphores + info.signalSemaphoreCount);
+	vector<uint64_t> signalValues(info.signalSemaphoreCount, 0); // oCiZ}tH̒l͖
+	vector<uint64_t> waitValues(info.waitSemaphoreCount, 0);
+	if (pWaitValues != nullptr)
+	{
+		waitValues.assign(pWaitValues, pWaitValues + info.waitSemaphoreCount);
+	}
+	VkTimelineSemaphoreSubmitInfoKHR timelineInfo{};
+	if (timelineSemaphoreSupported)
+	{
+		signalSemaphores.push_back(timelineSemaphore);
+		signalValues.push_back(value);
+
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+		timelineInfo.pNext = info.pNext;
+		timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+		timelineInfo.pWaitSemaphoreValues = waitValues.data();
+		timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+		timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+		info.pNext = &timelineInfo;
+		info.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+		info.pSignalSemaphores = signalSemaphores.data();
+	}
+
+	if (vkQueueSubmit(queue, 1, &info, fence) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to submit draw command queue!");
+	}
+	submittedTimelineValue = value;
+	return value;
+}
+
+// ҂ɊlXVĕԂ
+uint64_t Vulkan::pollTimeline()
+{
+	if (timelineSemaphoreSupported)
+	{
+		uint64_t value = 0;
+		if (pfnGetSemaphoreCounterValue(device, timelineSemaphore, &value) == VK_SUCCESS)
+		{
+			completedTimelineValue = max(completedTimelineValue, value);
+		}
+	}
+	else
+	{
+		// o͏Ɋ̂ŁAVOiς݂̃tFX̒lO͑SIĂ
+		for (size_t i = 0; i < inFlightFences.size(); i++)
+		{
+			if (frameTimelineValues[i] > completedTimelineValue && vkGetFenceStatus(device, inFlightFences[i]) == VK_SUCCESS)
+			{
+				completedTimelineValue = frameTimelineValues[i];
+			}
+		}
+	}
+	return completedTimelineValue;
+}
+
+bool Vulkan::isTimelineValueComplete(uint64_t value)
+{
+	return value <= completedTimelineValue || value <= pollTimeline();
+}
+
+void Vulkan::waitTimelineValue(uint64_t value)
+{
+	if (isTimelineValueComplete(value))
+	{
+		return;
+	}
+
+	if (timelineSemaphoreSupported)
+	{
+		VkSemaphoreWaitInfoKHR waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &timelineSemaphore;
+		waitInfo.pValues = &value;
+		if (pfnWaitSemaphores(device, &waitInfo, UINT64_MAX) != VK_SUCCESS)
+		{
+			throw runtime_error("failed to wait for timeline semaphore!");
+		}
+	}
+	else
+	{
+		// value܂ލłt[̃tFX҂
+		size_t slot = inFlightFences.size();
+		for (size_t i = 0; i < inFlightFences.size(); i++)
+		{
+			if (frameTimelineValues[i] >= value && (slot == inFlightFences.size() || frameTimelineValues[i] < frameTimelineValues[slot]))
+			{
+				slot = i;
+			}
+		}
+		if (slot == inFlightFences.size())
+		{
+			vkQueueWaitIdle(graphicsQueue);
+			value = submittedTimelineValue;
+		}
+		else
+		{
+			vkWaitForFences(device, 1, &inFlightFences[slot], VK_TRUE, UINT64_MAX);
+			value = frameTimelineValues[slot];
+		}
+	}
+	completedTimelineValue = max(completedTimelineValue, value);
+}
+
+//=================================================================
+// Memory Tracker
+//=================================================================
+
+static const char* memoryCategoryName(MemoryCategory category)
+{
+	switch (category)
+	{
+	case MemoryCategory::Vertex: return "vertex";
+	case MemoryCategory::Index: return "index";
+	case MemoryCategory::Uniform: return "uniform";
+	case MemoryCategory::Storage: return "storage";
+	case MemoryCategory::Texture: return "texture";
+	case MemoryCategory::Staging: return "staging";
+	case MemoryCategory::RenderTarget: return "render target";
+	default: return "other";
+	}
+}
+
+// foCX̊蓖Ă͑SĂʂAprEOEq[vL^
+void Vulkan::allocateMemory(const VkMemoryAllocateInfo& allocInfo, MemoryCategory category, const char* name, VkDeviceMemory* pMemory)
+{
+	if (vkAllocateMemory(device, &allocInfo, nullptr, pMemory) != VK_SUCCESS)
+	{
+		throw runtime_error(string("failed to allocate memory: ") + name);
+	}
+
+	uint32_t heap = memoryProperties.memoryTypes[allocInfo.memoryTypeIndex].heapIndex;
+	memoryAllocations[*pMemory] = { category, name, allocInfo.allocationSize, heap };
+
+	for (MemoryUsage* pUsage : { &categoryMemoryUsage[static_cast<size_t>(category)], &heapMemoryUsage[heap], &totalMemoryUsage })
+	{
+		pUsage->currentBytes += allocInfo.allocationSize;
+		pUsage->peakBytes = max(pUsage->peakBytes, pUsage->currentBytes);
+		pUsage->allocationCount++;
+	}
+}
+
+void Vulkan::freeMemory(VkDeviceMemory memory)
+{
+	if (memory == VK_NULL_HANDLE)
+	{
+		return;
+	}
+	auto it = memoryAllocations.find(memory);
+	if (it != memoryAllocations.end())
+	{
+		const MemoryAllocation& allocation = it->second;
+		for (MemoryUsage* pUsage : { &categoryMemoryUsage[static_cast<size_t>(allocation.category)], &heapMemoryUsage[allocation.heap], &totalMemoryUsage })
+		{
+			pUsage->currentBytes -= allocation.size;
+			pUsage->allocationCount--;
+		}
+		memoryAllocations.erase(it);
+	}
+	vkFreeMemory(device, memory, nullptr);
+}
+
+// foCXj钼OɌĂԁBcĂ銄蓖Ă͉Y
+void Vulkan::reportLeakedMemory()
+{
+	for (const auto& entry : memoryAllocations)
+	{
+		const MemoryAllocation& allocation = entry.second;
+		cerr << "memory leak: " << allocation.name << " (" << memoryCategoryName(allocation.category) << ", "
+			<< allocation.size << " bytes, heap " << allocation.heap << ")" << endl;
+	}
+}
+
+void Vulkan::writeMemoryReport(ostream& out) const
+{
+	auto writeUsage = [&](const MemoryUsage& usage)
+	{
+		out << "{\"current_bytes\":" << usage.currentBytes << ",\"peak_bytes\":" << usage.peakBytes
+			<< ",\"allocations\":" << usage.allocationCount << "}";
+	};
+
+	out << "{\"total\":";
+	writeUsage(totalMemoryUsage);
+	out << ",\"categories\":{";
+	for (size_t i = 0; i < categoryMemoryUsage.size(); i++)
+	{
+		out << (i == 0 ? "" : ",");
+		writeJsonString(out, memoryCategoryName(static_cast<MemoryCategory>(i)));
+		out << ":";
+		writeUsage(categoryMemoryUsage[i]);
+	}
+	out << "},\"heaps\":[";
+	for (size_t i = 0; i < heapMemoryUsage.size(); i++)
+	{
+		out << (i == 0 ? "" : ",");
+		writeUsage(heapMemoryUsage[i]);
+	}
+	out << "],\"live\":[";
+	bool first = true;
+	for (const auto& entry : memoryAllocations)
+	{
+		const MemoryAllocation& allocation = entry.second;
+		out << (first ? "" : ",") << "{\"name\":";
+		writeJsonString(out, allocation.name);
+		out << ",\"category\":";
+		writeJsonString(out, memoryCategoryName(allocation.category));
+		out << ",\"bytes\":" << allocation.size << ",\"heap\":" << allocation.heap << "}";
+		first = false;
+	}
+	out << "]}" << endl;
+}
+
+//=================================================================
+// Deferred Destruction
+//=================================================================
+
+void Vulkan::destroyDeferredObject(const DeferredDestroy& object)
+{
+	switch (object.type)
+	{
+	case DeferredObject::Buffer:
+		vkDestroyBuffer(device, (VkBuffer)object.handle, nullptr);
+		break;
+	case DeferredObject::Memory:
+		freeMemory((VkDeviceMemory)object.handle);
+		break;
+	case DeferredObject::Image:
+		vkDestroyImage(device, (VkImage)object.handle, nullptr);
+		break;
+	case DeferredObject::ImageView:
+		vkDestroyImageView(device, (VkImageView)object.handle, nullptr);
+		break;
+	case DeferredObject::Sampler:
+		vkDestroySampler(device, (VkSampler)object.handle, nullptr);
+		break;
+	case DeferredObject::Framebuffer:
+		vkDestroyFramebuffer(device, (VkFramebuffer)object.handle, nullptr);
+		break;
+	case DeferredObject::Pipeline:
+		vkDestroyPipeline(device, (VkPipeline)object.handle, nullptr);
+		break;
+	case DeferredObject::PipelineLayout:
+		vkDestroyPipelineLayout(device, (VkPipelineLayout)object.handle, nullptr);
+		break;
+	case DeferredObject::DescriptorPool:
+		vkDestroyDescriptorPool(device, (VkDescriptorPool)object.handle, nullptr);
+		break;
+	case DeferredObject::QueryPool:
+		vkDestroyQueryPool(device, (VkQueryPool)object.handle, nullptr);
+		break;
+	case DeferredObject::SwapChain:
+		vkDestroySwapchainKHR(device, (VkSwapchainKHR)object.handle, nullptr);
+		break;
+	}
+}
+
+// t[AGPUǂẑj (l͐ς񂾏ɑ)
+void Vulkan::collectDeferredDestroys()
+{
+	while (!deferredDestroys.empty() && isTimelineValueComplete(deferredDestroys.front().timelineValue))
+	{
+		destroyDeferredObject(deferredDestroys.front());
+		deferredDestroys.pop_front();
+	}
+}
+
+// GPU󂢂Ă鎞ɑSj
+void Vulkan::flushDeferredDestroys()
+{
+	for (const auto& object : deferredDestroys)
+	{
+		destroyDeferredObject(object);
+	}
+	deferredDestroys.clear();
+}
+
+//=================================================================
+// Headless Benchmark
+//=================================================================
+
+void Vulkan::setBenchmarkSettings(const BenchmarkSettings& settings)
+{
+	benchmarkSettings = settings;
+	headless = settings.headless;
+	if (headless)
+	{
+		// Xbv`F[̊gfoCX (\tgEFAX^CUȂ) ł
+		deviceExtensions.erase(remove_if(deviceExtensions.begin(), deviceExtensions.end(),
+			[](const char* name) { return strcmp(name, VK_KHR_SWAPCHAIN_EXTENSION_NAME) == 0; }), deviceExtensions.end());
+	}
+}
+
+// ܂̃t[`AEH[Abṽt[ԂWv
+void Vulkan::benchmarkLoop()
+{
+	using clock = chrono::steady_clock;
+	const BenchmarkSettings& settings = benchmarkSettings;
+	vector<double> frameTimesMs;
+	frameTimesMs.reserve(settings.frames);
+
+	auto measureStart = clock::now();
+	auto previous = measureStart;
+	for (uint32_t i = 0; i < settings.warmupFrames + settings.frames; i++)
+	{
+		if (i == settings.warmupFrames)
+		{
+			measureStart = clock::now();
+			previous = measureStart;
+		}
+		{
+			setProfileFrame(frameNumber);
+			PROFILE_ZONE("frame");
+			drawFrame();
+		}
+		auto now = clock::now();
+		if (i >= settings.warmupFrames)
+		{
+			frameTimesMs.push_back(chrono::duration<double, milli>(now - previous).count());
+		}
+		previous = now;
+	}
+
+	vkDeviceWaitIdle(device); // Ō̃t[܂ŌvɊ܂߂
+	double seconds = chrono::duration<double>(clock::now() - measureStart).count();
+	finishFrames();
+	writeBenchmarkResults(frameTimesMs, seconds);
+}
+
+void Vulkan::writeBenchmarkResults(const vector<double>& frameTimesMs, double seconds)
+{
+	ofstream file;
+	if (!benchmarkSettings.statsPath.empty())
+	{
+		file.open(benchmarkSettings.statsPath, ios::trunc);
+		if (!file.is_open())
+		{
+			throw runtime_error("failed to create benchmark stats: " + benchmarkSettings.statsPath);
+		}
+	}
+	ostream& out = file.is_open() ? static_cast<ostream&>(file) : cout;
+
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+	double sum = 0.0;
+	for (double ms : frameTimesMs)
+	{
+		sum += ms;
+	}
+	size_t count = frameTimesMs.size();
+
+	out << "{\"device\":";
+	writeJsonString(out, properties.deviceName);
+	out << ",\"width\":" << swapChainExtent.width << ",\"height\":" << swapChainExtent.height
+		<< ",\"frames\":" << count << ",\"warmup_frames\":" << benchmarkSettings.warmupFrames
+		<< ",\"frames_in_flight\":" << framesInFlight << ",\"async_compute\":" << (asyncComputeEnabled ? "true" : "false")
+		<< ",\"dynamic_rendering\":" << (dynamicRenderingSupported ? "true" : "false")
+		<< ",\"model\":";
+	writeJsonString(out, modelPath.c_str());
+	out << ",\"triangles\":" << (meshLods.empty() ? 0 : meshLods[0].indexCount / 3)
+		<< ",\"seconds\":" << seconds
+		<< ",\"fps\":" << (seconds > 0.0 ? count / seconds : 0.0)
+		<< ",\"frame_ms\":{\"avg\":" << (count > 0 ? sum / count : 0.0)
+		<< ",\"p50\":" << profilePercentile(frameTimesMs, 0.50)
+		<< ",\"p95\":" << profilePercentile(frameTimesMs, 0.95)
+		<< ",\"p99\":" << profilePercentile(frameTimesMs, 0.99) << "}";
+
+	// GPU1t[͒PROFILER_HISTORYt[
+	auto gpuFrame = find_if(gpuScopeStats.begin(), gpuScopeStats.end(), [](const ProfileScopeStats& stats) { return strcmp(stats.name, "frame") == 0; });
+	if (gpuFrame != gpuScopeStats.end())
+	{
+		vector<double> samples(gpuFrame->samples.begin(), gpuFrame->samples.end());
+		out << ",\"gpu_frame_ms\":{\"p50\":" << profilePercentile(samples, 0.50)
+			<< ",\"p99\":" << profilePercentile(samples, 0.99) << "}";
+	}
+
+	// pXƂ1t[̕ (EH[Abv܂ޑSt[)
+	if (!pipelineStats.empty())
+	{
+		out << ",\"pipeline_statistics\":{";
+		for (size_t i = 0; i < pipelineStats.size(); i++)
+		{
+			const PipelineStatsPass& pass = pipelineStats[i];
+			const PipelineStatistics& total = pass.total;
+			double frames = static_cast<double>(max(pass.totalFrames, uint64_t(1)));
+			out << (i == 0 ? "" : ",");
+			writeJsonString(out, pass.name);
+			out << ":{\"ia_vertices\":" << total.inputVertices / frames
+				<< ",\"ia_primitives\":" << total.inputPrimitives / frames
+				<< ",\"vs_invocations\":" << total.vertexInvocations / frames
+				<< ",\"clipping_primitives\":" << total.clippingPrimitives / frames
+				<< ",\"fs_invocations\":" << total.fragmentInvocations / frames << "}";
+		}
+		out << "}";
+	}
+	out << "}" << endl;
+
+	if (file.is_open() && !file)
+	{
+		throw runtime_error("failed to write benchmark stats: " + benchmarkSettings.statsPath);
+	}
+}
+
+//=================================================================
+// Readback
+//=================================================================
+
+void Vulkan::setReadbackCallback(function<void(const ReadbackFrame&)> callback)
+{
+	readbackCallback = move(callback);
+	readbackEnabled = readbackCallback != nullptr;
+}
+
+// ̑傫Ńt[Ƃ̃obt@B蒼̎Aݑ҂̃t[͎̂Ă
+void Vulkan::createReadbackBuffers()
+{
+	if (!readbackEnabled)
+	{
+		return;
+	}
+	if (swapChainImageFormat != VK_FORMAT_B8G8R8A8_SRGB && swapChainImageFormat != VK_FORMAT_B8G8R8A8_UNORM &&
+		swapChainImageFormat != VK_FORMAT_R8G8B8A8_SRGB && swapChainImageFormat != VK_FORMAT_R8G8B8A8_UNORM)
+	{
+		throw runtime_error("failed to enable readback: unsupported swapchain format");
+	}
+
+	for (size_t i = 0; i < readbackBuffers.size(); i++)
+	{
+		destroyLater(DeferredObject::Buffer, readbackBuffers[i]);
+		destroyLater(DeferredObject::Memory, readbackBuffersMemory[i]);
+	}
+
+	// CPUǂނ̂ŃLbV郁D悷 (݌̃̓ǂݏo͔ɒx)
+	VkMemoryPropertyFlags cached = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+	readbackCached = false;
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		readbackCached |= (memoryProperties.memoryTypes[i].propertyFlags & cached) == cached;
+	}
+
+	readbackExtent = swapChainExtent;
+	size_t size = static_cast<size_t>(readbackExtent.width) * readbackExtent.height * 4;
+	readbackBuffers.resize(framesInFlight);
+	readbackBuffersMemory.resize(framesInFlight);
+	readbackBuffersMapped.resize(framesInFlight);
+	readbackFrames.assign(framesInFlight, UINT64_MAX);
+	readbackPixels.resize(size);
+	for (uint32_t i = 0; i < framesInFlight; i++)
+	{
+		createBuffer(size, &readbackBuffers[i], &readbackBuffersMemory[i], VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			readbackCached ? cached : VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			MemoryCategory::Staging, "readback buffer");
+		vkMapMemory(device, readbackBuffersMemory[i], 0, size, 0, &readbackBuffersMapped[i]);
+	}
+}
+
+// 2ڂ̃_[pX̌ɁA`摜̃t[̃obt@փRs[
+// 摜TRANSFER_SRCւ̑JڂƁACPUǂނ߂̃oA̓t[Ots
+void Vulkan::recordReadback(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+	VkBufferImageCopy region{};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0; // l߂ĕׂ
+	region.bufferImageHeight = 0;
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { readbackExtent.width, readbackExtent.height, 1 };
+	vkCmdCopyImageToBuffer(commandBuffer, swapChainImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		readbackBuffers[currentFrame], 1, &region);
+
+	readbackFrames[currentFrame] = frameNumber;
+}
+
+// framẽR}hobt@ɌĂ (҂Ȃ)
+void Vulkan::deliverReadback(uint32_t frame)
+{
+	if (!readbackEnabled || readbackFrames[frame] == UINT64_MAX)
+	{
+		return;
+	}
+	PROFILE_ZONE("readback");
+	auto start = chrono::steady_clock::now();
+
+	size_t pixelCount = static_cast<size_t>(readbackExtent.width) * readbackExtent.height;
+	if (readbackCached)
+	{
+		VkMappedMemoryRange range{};
+		range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range.memory = readbackBuffersMemory[frame];
+		range.offset = 0;
+		range.size = VK_WHOLE_SIZE;
+		vkInvalidateMappedMemoryRanges(device, 1, &range);
+	}
+	const uint8_t* pMapped = static_cast<const uint8_t*>(readbackBuffersMapped[frame]);
+	if (swapChainImageFormat == VK_FORMAT_B8G8R8A8_SRGB || swapChainImageFormat == VK_FORMAT_B8G8R8A8_UNORM)
+	{
+		swizzleBgraToRgba(pMapped, readbackPixels.data(), pixelCount);
+	}
+	else
+	{
+		memcpy(readbackPixels.data(), pMapped, pixelCount * 4);
+	}
+
+	ReadbackFrame result{};
+	result.frame = readbackFrames[frame];
+	result.width = readbackExtent.width;
+	result.height = readbackExtent.height;
+	result.pRgba = readbackPixels.data();
+	readbackFrames[frame] = UINT64_MAX;
+	readbackCallback(result);
+
+	readbackCount++;
+	readbackMsSum += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+//=================================================================
+// GPU Profiler
+//=================================================================
+
+void Vulkan::setProfilerSettings(const ProfilerSettings& settings)
+{
+	profilerSettings = settings;
+}
+
+void Vulkan::createGpuProfiler()
+{
+	gpuScopes.resize(framesInFlight);
+	gpuScopeFrames.assign(framesInFlight, 0);
+	statsPasses.resize(framesInFlight);
+	if (pipelineStatisticsSupported)
+	{
+		statsQueryPools.resize(framesInFlight);
+		for (auto& queryPool : statsQueryPools)
+		{
+			VkQueryPoolCreateInfo queryPoolInfo{};
+			queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			queryPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+			queryPoolInfo.queryCount = PIPELINE_STATS_MAX_PASSES;
+			queryPoolInfo.pipelineStatistics = pipelineStatisticsFlags;
+
+			if (vkCreateQueryPool(device, &queryPoolInfo, nullptr, &queryPool) != VK_SUCCESS)
+			{
+				throw runtime_error("failed to create pipeline statistics query pool!");
+			}
+		}
+	}
+	if (!enableGpuProfiler || !timestampsSupported)
+	{
+		return;
+	}
+
+	gpuQueryPools.resize(framesInFlight);
+	for (auto& queryPool : gpuQueryPools)
+	{
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = GPU_PROFILER_MAX_SCOPES * 2;
+
+		if (vkCreateQueryPool(device, &queryPoolInfo, nullptr, &queryPool) != VK_SUCCESS)
+		{
+			throw runtime_error("failed to create profiler query pool!");
+		}
+	}
+	calibrateGpuClock();
+}
+
+// GPŨ^CX^vCPU̎Ԏɍ킹
+// oĊ҂CPU̎ĝŁA҂̒x(\usx)GPŰԂxČ
+void Vulkan::calibrateGpuClock()
+{
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	vkCmdResetQueryPool(commandBuffer, gpuQueryPools[0], 0, 1);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, gpuQueryPools[0], 0);
+	endSingleTimeCommands(commandBuffer);
+	double cpuUs = profileClockUs();
+
+	uint64_t ticks = 0;
+	if (vkGetQueryPoolResults(device, gpuQueryPools[0], 0, 1, sizeof(ticks), &ticks, sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to read calibration timestamp!");
+	}
+	gpuClockOffsetUs = cpuUs - static_cast<double>(ticks & timestampMask) * timestampPeriod / 1000.0;
+}
+
+// Ԃ̔ԍԂBȂUINT32_MAX (endGpuScope͉Ȃ)
+uint32_t Vulkan::beginGpuScope(VkCommandBuffer commandBuffer, const char* name)
+{
+	vector<GpuScope>& scopes = gpuScopes[currentFrame];
+	bool compute = !computeCommandBuffers.empty() && commandBuffer == computeCommandBuffers[currentFrame];
+	if (gpuQueryPools.empty() || scopes.size() >= GPU_PROFILER_MAX_SCOPES || (compute && !computeTimestampsSupported))
+	{
+		return UINT32_MAX;
+	}
+	uint32_t scope = static_cast<uint32_t>(scopes.size());
+	scopes.push_back({ name, false, compute ? PROFILE_TRACK_GPU_COMPUTE : PROFILE_TRACK_GPU });
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, gpuQueryPools[currentFrame], scope * 2);
+	return scope;
+}
+
+void Vulkan::endGpuScope(VkCommandBuffer commandBuffer, uint32_t scope)
+{
+	if (scope == UINT32_MAX)
+	{
+		return;
+	}
+	gpuScopes[currentFrame][scope].ended = true;
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, gpuQueryPools[currentFrame], scope * 2 + 1);
+}
+
+// framẽR}hobt@ɌĂԁB҂ɓǂ݁AĂȂΎ̂Ă
+void Vulkan::readGpuProfiler(uint32_t frame)
+{
+	vector<GpuScope>& scopes = gpuScopes[frame];
+	if (gpuQueryPools.empty() || scopes.empty())
+	{
+		return;
+	}
+
+	uint32_t queryCount = static_cast<uint32_t>(scopes.size()) * 2;
+	vector<uint64_t> timestamps(queryCount);
+	VkResult result = vkGetQueryPoolResults(device, gpuQueryPools[frame], 0, queryCount, sizeof(uint64_t) * queryCount,
+		timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+	if (result == VK_SUCCESS)
+	{
+		double usPerTick = timestampPeriod / 1000.0;
+		for (size_t i = 0; i < scopes.size(); i++)
+		{
+			if (!scopes[i].ended)
+			{
+				continue;
+			}
+			uint64_t begin = timestamps[i * 2] & timestampMask;
+			uint64_t ticks = (timestamps[i * 2 + 1] - begin) & timestampMask; // Ă͐
+			double durationUs = static_cast<double>(ticks) * usPerTick;
+			addProfileSample(&gpuScopeStats, scopes[i].name, durationUs / 1000.0, PROFILER_HISTORY);
+
+			ProfileEvent event{};
+			event.name = scopes[i].name;
+			event.frame = gpuScopeFrames[frame];
+			event.startUs = static_cast<double>(begin) * usPerTick + gpuClockOffsetUs;
+			event.durationUs = durationUs;
+			event.track = scopes[i].track;
+			addTraceEvent(event);
+		}
+	}
+	scopes.clear();
+}
+
+// pX̔ԍԂBȂUINT32_MAXBނ̃NG͓qɂłȂ̂ŃpX͏d˂Ȃ
+uint32_t Vulkan::beginPipelineStats(VkCommandBuffer commandBuffer, const char* name)
+{
+	vector<GpuScope>& passes = statsPasses[currentFrame];
+	if (statsQueryPools.empty() || passes.size() >= PIPELINE_STATS_MAX_PASSES)
+	{
+		return UINT32_MAX;
+	}
+	uint32_t pass = static_cast<uint32_t>(passes.size());
+	passes.push_back({ name, false, PROFILE_TRACK_GPU });
+	vkCmdBeginQuery(commandBuffer, statsQueryPools[currentFrame], pass, 0);
+	return pass;
+}
+
+void Vulkan::endPipelineStats(VkCommandBuffer commandBuffer, uint32_t pass)
+{
+	if (pass == UINT32_MAX)
+	{
+		return;
+	}
+	statsPasses[currentFrame][pass].ended = true;
+	vkCmdEndQuery(commandBuffer, statsQueryPools[currentFrame], pass);
+}
+
+// readGpuProfilerƓAframe̊ɑ҂ɓǂ
+void Vulkan::readPipelineStats(uint32_t frame)
+{
+	vector<GpuScope>& passes = statsPasses[frame];
+	if (statsQueryPools.empty() || passes.empty())
+	{
+		return;
+	}
+
+	vector<PipelineStatistics> results(passes.size());
+	VkResult result = vkGetQueryPoolResults(device, statsQueryPools[frame], 0, static_cast<uint32_t>(passes.size()),
+		sizeof(PipelineStatistics) * results.size(), results.data(), sizeof(PipelineStatistics), VK_QUERY_RESULT_64_BIT);
+	if (result == VK_SUCCESS)
+	{
+		for (size_t i = 0; i < passes.size(); i++)
+		{
+			if (!passes[i].ended)
+			{
+				continue;
+			}
+			auto it = find_if(pipelineStats.begin(), pipelineStats.end(), [&](const PipelineStatsPass& pass) { return strcmp(pass.name, passes[i].name) == 0; });
+			if (it == pipelineStats.end())
+			{
+				it = pipelineStats.insert(pipelineStats.end(), PipelineStatsPass{ passes[i].name, {}, 0, {}, 0 });
+			}
+			for (PipelineStatistics* pSum : { &it->window, &it->total })
+			{
+				pSum->inputVertices += results[i].inputVertices;
+				pSum->inputPrimitives += results[i].inputPrimitives;
+				pSum->vertexInvocations += results[i].vertexInvocations;
+				pSum->clippingPrimitives += results[i].clippingPrimitives;
+				pSum->fragmentInvocations += results[i].fragmentInvocations;
+			}
+			it->windowFrames++;
+			it->totalFrames++;
+		}
+	}
+	passes.clear();
+}
+
+// SXbhCPŰԂ𓝌vƃg[XɈڂ (t[)
+void Vulkan::collectCpuProfile()
+{
+	cpuZoneEvents.clear();
+	collectCpuZones(&cpuZoneEvents);
+	for (const auto& event : cpuZoneEvents)
+	{
+		addProfileSample(&cpuZoneStats, event.name, event.durationUs / 1000.0, PROFILER_HISTORY);
+		addTraceEvent(event);
+	}
+}
+
+void Vulkan::addTraceEvent(const ProfileEvent& event)
+{
+	if (profilerSettings.tracePath.empty() || event.frame < profilerSettings.firstFrame || event.frame > profilerSettings.lastFrame)
+	{
+		return;
+	}
+	traceEvents.push_back(event);
+	if (traceEvents.size() > PROFILER_MAX_TRACE_EVENTS)
+	{
+		traceEvents.pop_front();
+	}
+}
+
+void Vulkan::writeTrace()
+{
+	if (profilerSettings.tracePath.empty())
+	{
+		return;
+	}
+	vector<ProfileEvent> events(traceEvents.begin(), traceEvents.end());
+	vector<pair<uint32_t, string>> tracks = { { PROFILE_TRACK_GPU, "GPU graphics queue" } };
+	if (asyncComputeEnabled)
+	{
+		tracks.push_back({ PROFILE_TRACK_GPU_COMPUTE, "GPU async compute queue" });
+	}
+	for (const auto& track : cpuProfileTracks())
+	{
+		tracks.push_back(track);
+	}
+	writeChromeTrace(profilerSettings.tracePath, events, tracks);
+	cout << "trace: " << events.size() << " events written to " << profilerSettings.tracePath << endl;
+}
+
+//=================================================================
+// Frame Pacing
+//=================================================================
+
+void Vulkan::setDeviceOverride(const string& device)
+{
+	deviceOverride = device;
+}
+
+void Vulkan::setPresentSettings(const PresentSettings& settings)
+{
+	presentSettings = settings;
+	framesInFlight = max(settings.framesInFlight, 1u);
+}
+
+static const char* presentModeName(VkPresentModeKHR mode)
+{
+	switch (mode)
+	{
+	case VK_PRESENT_MODE_IMMEDIATE_KHR: return "immediate";
+	case VK_PRESENT_MODE_MAILBOX_KHR: return "mailbox";
+	case VK_PRESENT_MODE_FIFO_KHR: return "fifo";
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo-relaxed";
+	default: return "other";
+	}
+}
+
+// t[̓͂ǂޑOɌĂԁB̃t[[gƒx[h̑҂ł܂Ƃ߂čs
+void Vulkan::paceFrame()
+{
+	using clock = chrono::steady_clock;
+
+	if (refreshInterval <= 0.0)
+	{
+		const GLFWvidmode* pMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+		refreshInterval = 1.0 / (pMode != nullptr && pMode->refreshRate > 0 ? pMode->refreshRate : 60);
+		cout << "present: " << presentModeName(presentMode) << ", " << swapChainImages.size() << " images, "
+			<< framesInFlight << " frames in flight, " << 1.0 / refreshInterval << " Hz"
+			<< (presentSettings.lowLatency ? ", low latency" : "") << (presentWaitSupported ? ", present wait" : "") << endl;
+	}
+
+	// x: Õt[\(ȂGPUI)܂Ŏ̃t[CPUƂn߂Ȃ
+	if (presentSettings.lowLatency)
+	{
+		uint32_t previousFrame = (currentFrame + framesInFlight - 1) % framesInFlight;
+		if (presentWaitSupported && framePresentIds[previousFrame] != 0)
+		{
+			uint64_t timeout = static_cast<uint64_t>(4 * refreshInterval * 1e9); // \Ȃ(ŏȂ)Ɏ~܂Ȃ
+			if (pfnWaitForPresent(device, swapChain, framePresentIds[previousFrame], timeout) == VK_SUCCESS)
+			{
+				addLatencySample(chrono::duration<double, milli>(clock::now() - frameInputTimes[previousFrame]).count());
+				framePresentIds[previousFrame] = 0; // vς
+			}
+		}
+		else
+		{
+			waitTimelineValue(frameTimelineValues[previousFrame]);
+		}
+	}
+
+	// t[[g̏Bsleep͑êōŌ̏񂵂đ҂
+	double targetFps = presentSettings.targetFps < 0.0 ? 1.0 / refreshInterval : presentSettings.targetFps;
+	if (targetFps > 0.0)
+	{
+		auto interval = chrono::duration_cast<clock::duration>(chrono::duration<double>(1.0 / targetFps));
+		auto now = clock::now();
+		if (now < nextFrameTime)
+		{
+			this_thread::sleep_until(nextFrameTime - chrono::milliseconds(2));
+			while (clock::now() < nextFrameTime)
+			{
+				this_thread::yield();
+			}
+		}
+		// xꂽ͎߂Ȃ
+		nextFrameTime = max(nextFrameTime + interval, clock::now());
+	}
+
+	frameInputTime = clock::now();
+}
+
+// Xbg̑Õt[IɌĂсA͂\܂ł̎Ԃς
+// present_waitΕ\ς݂𒲂ׁAȂGPŮɎvblank܂ł̍ől𑫂
+void Vulkan::measureFrameLatency(uint32_t frame)
+{
+	if (frameInputTimes[frame] == chrono::steady_clock::time_point{})
+	{
+		return;
+	}
+	double elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - frameInputTimes[frame]).count();
+	if (presentWaitSupported)
+	{
+		if (framePresentIds[frame] != 0 && pfnWaitForPresent(device, swapChain, framePresentIds[frame], 0) == VK_SUCCESS)
+		{
+			addLatencySample(elapsedMs);
+		}
+	}
+	else
+	{
+		addLatencySample(elapsedMs + refreshInterval * 1000.0);
+	}
+	frameInputTimes[frame] = chrono::steady_clock::time_point{};
+}
+
+void Vulkan::addLatencySample(double ms)
+{
+	latencyMsSum += ms;
+	latencyMsMax = max(latencyMsMax, ms);
+	latencySamples++;
+}
+
+// GPU~߂ɍ蒼BÂXbv`F[oldSwapchainɓnA
+// gĂt[IĂj
+void Vulkan::recreateSwapChain()
+{
+	int width = 0, height = 0;
+	glfwGetFramebufferSize(window, &width, &height);
+	if (width == 0 || height == 0)
+	{
+		framebufferResized = true; // ŏB߂ɍ蒼
+		return;
+	}
+
+	cleanupSwapChain();
+	createSwapChain();
+	createImageViews();
+	createDepthResources();
+	createFrameBuffers();
+	createDepthPyramid();
+	createReadbackBuffers();
+	framebufferResized = false;
+
+	// present_id͐VXbv`F[Ő
+	lastPresentId = 0;
+	framePresentIds.assign(framesInFlight, 0);
+}
+
+void Vulkan::createMeshBuffers()
+{
+	vector<uint8_t> vertexData;
+	vector<uint8_t> indexData;
+	packMesh(&vertexData, &indexData);
+
+	modelGeometry = uploadGeometry(vertexData.data(), static_cast<uint32_t>(vertices.size()), indexData.data(),
+		static_cast<uint32_t>(indices.size()), indexType);
+
+	size_t vertexStride = VERTEX_FORMAT == VertexFormat::Float ? sizeof(Vertex) : sizeof(PackedVertex);
+	cout << "mesh buffers: vertex " << vertexData.size() << " bytes (" << vertexStride
+		<< " B/vertex, was " << sizeof(Vertex) << "), index " << indexData.size() << " bytes ("
+		<< (indexType == VK_INDEX_TYPE_UINT16 ? "uint16" : "uint32") << ")" << endl;
+
+	// LbVȂĂ`͑
+	if (enableMeshCache && !modelPath.empty())
+	{
+		try
+		{
+			writeModelCache(vertexData, indexData);
+		}
+		catch (const exception& e)
+		{
+			cerr << e.what() << endl;
+		}
+	}
+}
+
+// _ƃCfbNXGPUɑ`ɋl߂BmeshDequantize, indexType, meshBoundsŌ܂
+void Vulkan::packMesh(vector<uint8_t>* pVertexData, vector<uint8_t>* pIndexData)
+{
+	glm::vec3 minPos(numeric_limits<float>::max());
+	glm::vec3 maxPos(-numeric_limits<float>::max());
+	for (const auto& v : vertices)
+	{
+		minPos = glm::min(minPos, v.pos);
+		maxPos = glm::max(maxPos, v.pos);
+	}
+	glm::vec3 center = (minPos + maxPos) * 0.5f;
+	float radius = 0.0f;
+	for (const auto& v : vertices)
+	{
+		radius = max(radius, glm::length(v.pos - center));
+	}
+	meshBounds = glm::vec4(center, radius);
+
+	meshDequantize = glm::mat4(1.0f);
+	if (VERTEX_FORMAT == VertexFormat::Float)
+	{
+		pVertexData->resize(sizeof(Vertex) * vertices.size());
+		memcpy(pVertexData->data(), vertices.data(), pVertexData->size());
+	}
+	else
+	{
+		// snorm16̓bVAABB[-1,1]Ɏ߁A߂ϊ̓IuWFNg̍sɊ|
+		glm::vec3 halfExtent = (maxPos - minPos) * 0.5f;
+		float scale = max(max(halfExtent.x, halfExtent.y), max(halfExtent.z, 1e-6f)); // ɂċEۂ
+		if (VERTEX_FORMAT == VertexFormat::Snorm16)
+		{
+			meshDequantize = glm::translate(glm::mat4(1.0f), center) * glm::scale(glm::mat4(1.0f), glm::vec3(scale));
+		}
+
+		vector<PackedVertex> packed(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			const Vertex& v = vertices[i];
+			glm::vec3 pos = VERTEX_FORMAT == VertexFormat::Snorm16 ? (v.pos - center) / scale : v.pos;
+			for (int k = 0; k < 3; k++)
+			{
+				packed[i].pos[k] = VERTEX_FORMAT == VertexFormat::Half ? glm::packHalf1x16(pos[k]) : glm::packSnorm1x16(pos[k]);
+			}
+			packed[i].pos[3] = VERTEX_FORMAT == VertexFormat::Half ? glm::packHalf1x16(1.0f) : glm::packSnorm1x16(1.0f);
+			uint32_t color = glm::packUnorm4x8(glm::vec4(v.color, 1.0f));
+			memcpy(packed[i].color, &color, sizeof(color));
+			packed[i].texCoord[0] = glm::packUnorm1x16(v.texCoord.x);
+			packed[i].texCoord[1] = glm::packUnorm1x16(v.texCoord.y);
+		}
+
+		pVertexData->resize(sizeof(PackedVertex) * packed.size());
+		memcpy(pVertexData->data(), packed.data(), pVertexData->size());
+	}
+
+	// 65536_ȉȂ16bitCfbNXő
+	if (vertices.size() <= 65536)
+	{
+		vector<uint16_t> indices16(indices.begin(), indices.end());
+		pIndexData->resize(sizeof(uint16_t) * indices16.size());
+		memcpy(pIndexData->data(), indices16.data(), pIndexData->size());
+		indexType = VK_INDEX_TYPE_UINT16;
+	}
+	else
+	{
+		pIndexData->resize(sizeof(uint32_t) * indices.size());
+		memcpy(pIndexData->data(), indices.data(), pIndexData->size());
+		indexType = VK_INDEX_TYPE_UINT32;
+	}
+}
+
+// Xe[WOobt@oRDEVICE_LOCALȃobt@
+void Vulkan::createDeviceLocalBuffer(void* pData, size_t size, VkBufferUsageFlags usage, VkBuffer* pBuffer, VkDeviceMemory* pDeviceMemory,
+	MemoryCategory category, const char* name)
+{
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	createBuffer(size, &stagingBuffer, &stagingBufferMemory, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::Staging, "upload staging");
+	void* pointer;
+	vkMapMemory(device, stagingBufferMemory, 0, size, 0, &pointer);
+	memcpy(pointer, pData, size);
+	vkUnmapMemory(device, stagingBufferMemory);
+
+	createBuffer(size, pBuffer, pDeviceMemory, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, category, name);
+
+	copyBuffer(stagingBuffer, *pBuffer, size);
+
+	vkDestroyBuffer(device, stagingBuffer, nullptr);
+	freeMemory(stagingBufferMemory);
+}
+
+// 쐬ς݂DEVICE_LOCALȃobt@̐擪sizeoCg
+void Vulkan::updateDeviceLocalBuffer(VkBuffer buffer, const void* pData, size_t size)
+{
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	createBuffer(size, &stagingBuffer, &stagingBufferMemory, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::Staging, "update staging");
+	void* pointer;
+	vkMapMemory(device, stagingBufferMemory, 0, size, 0, &pointer);
+	memcpy(pointer, pData, size);
+	vkUnmapMemory(device, stagingBufferMemory);
+
+	copyBuffer(stagingBuffer, buffer, size);
+
+	vkDestroyBuffer(device, stagingBuffer, nullptr);
+	freeMemory(stagingBufferMemory);
+}
+
+void Vulkan::createUniformBuffers()
+{
+	size_t size = sizeof(UniformBufferObject);
+	uniformBuffers.resize(framesInFlight);
+	uniformBuffersMemory.resize(framesInFlight);
+	uniformBuffersMapped.resize(framesInFlight);
+
+	for (size_t i = 0; i < framesInFlight; i++)
+	{
+		createBuffer(size, &uniformBuffers[i], &uniformBuffersMemory[i], VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 
+					 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::Uniform, "uniform buffer");
+
+		vkMapMemory(device, uniformBuffersMemory[i], 0, size, 0, &uniformBuffersMapped[i]);
+	}
+}
+
+uint32_t Vulkan::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+{
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		if (typeFilter & (1 << i) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+		{
+			return i;
+		}
+	}
+	throw runtime_error("failed to find suitable memory type!");
+}
+
+void Vulkan::createDescriptorSetLayout()
+{
+	VkDescriptorSetLayoutBinding uboLayoutBinding{};
+	uboLayoutBinding.binding = 0;
+	uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uboLayoutBinding.descriptorCount = 1;
+	uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	uboLayoutBinding.pImmutableSamplers = nullptr;
+
+	VkDescriptorSetLayoutBinding samplerLayoutBinding{};
+	samplerLayoutBinding.binding = 1;
+	samplerLayoutBinding.descriptorCount = 1;
+	samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	samplerLayoutBinding.pImmutableSamplers = nullptr;
+	samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	VkDescriptorSetLayoutBinding objectLayoutBinding{};
+	objectLayoutBinding.binding = 2;
+	objectLayoutBinding.descriptorCount = 1;
+	objectLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	objectLayoutBinding.pImmutableSamplers = nullptr;
+	objectLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+	VkDescriptorSetLayoutBinding visibleLayoutBinding = objectLayoutBinding;
+	visibleLayoutBinding.binding = 3;
+
+	array<VkDescriptorSetLayoutBinding, 4> bindings = { uboLayoutBinding, samplerLayoutBinding, objectLayoutBinding, visibleLayoutBinding };
+	
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to create descriptor set layout!");
+	}
+
+	// JOp 0:UBO 1:objects 2:meshes 3:drawCommands 4:visibleInstances 5:stats 6:depthPyramid 7:objectState 8:objectLod
+	// 9:meshlets 10:clusterObjects 11:clusterState 12:clusterDraws (bVbg̃JOƋL)
+	array<VkDescriptorSetLayoutBinding, 13> cullBindings{};
+	for (uint32_t i = 0; i < cullBindings.size(); i++)
+	{
+		cullBindings[i].binding = i;
+		cullBindings[i].descriptorCount = 1;
+		cullBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		cullBindings[i].pImmutableSamplers = nullptr;
+		cullBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+	cullBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	cullBindings[6].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+	VkDescriptorSetLayoutCreateInfo cullLayoutInfo{};
+	cullLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	cullLayoutInfo.bindingCount = static_cast<uint32_t>(cullBindings.size());
+	cullLayoutInfo.pBindings = cullBindings.data();
+
+	if (vkCreateDescriptorSetLayout(device, &cullLayoutInfo, nullptr, &cullDescriptorSetLayout) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to create culling descriptor set layout!");
+	}
+}
+
+void Vulkan::createDescriptorPool()
+{
+	array<VkDescriptorPoolSize, 3> poolSizes{};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[0].descriptorCount = static_cast<uint32_t>(framesInFlight * 2);
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[1].descriptorCount = static_cast<uint32_t>(framesInFlight * 2);
+	poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[2].descriptorCount = static_cast<uint32_t>(framesInFlight * 13);
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = static_cast<uint32_t>(framesInFlight * 2);
+
+	if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to create descriptor pool!");
+	}
+}
+
+void Vulkan::createDescriptorSets()
+{
+	vector<VkDescriptorSetLayout> layouts(framesInFlight, descriptorSetLayout);
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = static_cast<uint32_t>(framesInFlight);
+	allocInfo.pSetLayouts = layouts.data();
+
+	descriptorSets.resize(framesInFlight);
+
+	if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to allocate descriptor sets!");
+	}
+
+	vector<VkDescriptorSetLayout> cullLayouts(framesInFlight, cullDescriptorSetLayout);
+	allocInfo.pSetLayouts = cullLayouts.data();
+	cullDescriptorSets.resize(framesInFlight);
+
+	if (vkAllocateDescriptorSets(device, &allocInfo, cullDescriptorSets.data()) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to allocate culling descriptor sets!");
+	}
+
+	for (size_t i = 0; i < framesInFlight; i++)
+	{
+		VkDescriptorBufferInfo bufferInfo{};
+		bufferInfo.buffer = uniformBuffers[i];
+		bufferInfo.offset = 0;
+		bufferInfo.range = sizeof(UniformBufferObject);
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = textureImageView;
+		imageInfo.sampler = textureSampler;
+
+		array<VkDescriptorBufferInfo, 11> storageInfos{};
+		storageInfos[0] = { objectBuffer, 0, VK_WHOLE_SIZE };
+		storageInfos[1] = { meshBuffer, 0, VK_WHOLE_SIZE };
+		storageInfos[2] = { drawCommandBuffers[i], 0, VK_WHOLE_SIZE };
+		storageInfos[3] = { visibleBuffers[i], 0, VK_WHOLE_SIZE };
+		storageInfos[4] = { cullStatsBuffers[i], 0, VK_WHOLE_SIZE };
+		storageInfos[5] = { cullStateBuffers[i], 0, VK_WHOLE_SIZE };
+		storageInfos[6] = { objectLodBuffer, 0, VK_WHOLE_SIZE };
+		storageInfos[7] = { meshletBuffer, 0, VK_WHOLE_SIZE };
+		storageInfos[8] = { clusterObjectBuffers[i], 0, VK_WHOLE_SIZE };
+		storageInfos[9] = { clusterStateBuffers[i], 0, VK_WHOLE_SIZE };
+		storageInfos[10] = { clusterDrawBuffers[i], 0, VK_WHOLE_SIZE };
+
+		array<VkWriteDescriptorSet, 4> descriptorWrites{};
+		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[0].dstSet = descriptorSets[i];
+		descriptorWrites[0].dstBinding = 0;
+		descriptorWrites[0].dstArrayElement = 0;
+		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		descriptorWrites[0].descriptorCount = 1;
+		descriptorWrites[0].pBufferInfo = &bufferInfo;
+
+		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[1].dstSet = descriptorSets[i];
+		descriptorWrites[1].dstBinding = 1;
+		descriptorWrites[1].dstArrayElement = 0;
+		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrites[1].descriptorCount = 1;
+		descriptorWrites[1].pImageInfo = &imageInfo;
+
+		descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[2].dstSet = descriptorSets[i];
+		descriptorWrites[2].dstBinding = 2;
+		descriptorWrites[2].dstArrayElement = 0;
+		descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		descriptorWrites[2].descriptorCount = 1;
+		descriptorWrites[2].pBufferInfo = &storageInfos[0];
+
+		descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[3].dstSet = descriptorSets[i];
+		descriptorWrites[3].dstBinding = 3;
+		descriptorWrites[3].dstArrayElement = 0;
+		descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		descriptorWrites[3].descriptorCount = 1;
+		descriptorWrites[3].pBufferInfo = &storageInfos[3];
+
+		vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+		// JOp (6:depthPyramidcreateDepthPyramidŏ)
+		array<VkWriteDescriptorSet, 12> cullWrites{};
+		for (uint32_t b = 0; b < cullWrites.size(); b++)
+		{
+			uint32_t binding = b < 6 ? b : b + 1;
+			cullWrites[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			cullWrites[b].dstSet = cullDescriptorSets[i];
+			cullWrites[b].dstBinding = binding;
+			cullWrites[b].dstArrayElement = 0;
+			cullWrites[b].descriptorCount = 1;
+			cullWrites[b].descriptorType = binding == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			cullWrites[b].pBufferInfo = binding == 0 ? &bufferInfo : &storageInfos[b - 1];
+		}
+
+		vkUpdateDescriptorSets(device, static_cast<uint32_t>(cullWrites.size()), cullWrites.data(), 0, nullptr);
+	}
+}
+
+// foCXvȂ̂ŏ̍ŏɃ[J[ŌĂ
+void Vulkan::loadTexturePixels()
+{
+	const char* fileName = "textures/texture.png";
+	int texChannels;
+	pTexturePixels = stbi_load(fileName, &textureWidth, &textureHeight, &texChannels, STBI_rgb_alpha);
+	if (!pTexturePixels)
+	{
+		throw runtime_error("failed to load texture image!");
+	}
+}
+
+// loadTexturePixelsœǂ񂾉f𑗂
+void Vulkan::createTextureImage()
+{
+	int texWidth = textureWidth;
+	int texHeight = textureHeight;
+	stbi_uc* pixels = pTexturePixels;
+	VkDeviceSize imageSize = texWidth * texHeight * 4;
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	createBuffer(imageSize, &stagingBuffer, &stagingBufferMemory, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::Staging, "texture staging");
+	void* data;
+	vkMapMemory(device, stagingBufferMemory, 0, imageSize, 0, &data);
+	memcpy(data, pixels, imageSize);
+	vkUnmapMemory(device, stagingBufferMemory);
+	stbi_image_free(pixels);
+	pTexturePixels = nullptr;
+	createImage(texWidth, texHeight, 1, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &textureImage, &textureImageMemory, MemoryCategory::Texture, "texture");
+	transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
+	transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	vkDestroyBuffer(device, stagingBuffer, nullptr);
+	freeMemory(stagingBufferMemory);
+}
+
+void Vulkan::createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, 
+	VkMemoryPropertyFlagBits properties, VkImage *image, VkDeviceMemory *imageMemory, MemoryCategory category, const char* name)
+{
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.extent.width = width;
+	imageInfo.extent.height = height;
+	imageInfo.extent.depth = 1;
+	imageInfo.mipLevels = mipLevels;
+	imageInfo.arrayLayers = 1;
+	imageInfo.format = format;
+	imageInfo.tiling = tiling;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.usage = usage;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	// vZL[ǂHi-Z (Xg[WC[W) LɂB`͈kȂȂ邱Ƃ̂Ŕr̂܂
+	if (!sharedQueueFamilies.empty() && (usage & VK_IMAGE_USAGE_STORAGE_BIT))
+	{
+		imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		imageInfo.queueFamilyIndexCount = static_cast<uint32_t>(sharedQueueFamilies.size());
+		imageInfo.pQueueFamilyIndices = sharedQueueFamilies.data();
+	}
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	//imageInfo.flags = 0;
+
+	if (vkCreateImage(device, &imageInfo, nullptr, image) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create image!");
+	}
+
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(device, *image, &memRequirements);
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memRequirements.size;
+	allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+
+	allocateMemory(allocInfo, category, name, imageMemory);
+
+	vkBindImageMemory(device, *image, *imageMemory, 0);
+}
+
+VkImageView Vulkan::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t baseMipLevel, uint32_t levelCount)
+{
+	VkImageView imageView;
+	VkImageViewCreateInfo imageViewInfo{};
+	imageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	imageViewInfo.image = image;
+	imageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	imageViewInfo.format = format;
+	imageViewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+	imageViewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+	imageViewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+	imageViewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+	imageViewInfo.subresourceRange.aspectMask = aspectFlags;
+	imageViewInfo.subresourceRange.baseMipLevel = baseMipLevel;
+	imageViewInfo.subresourceRange.levelCount = levelCount;
+	imageViewInfo.subresourceRange.baseArrayLayer = 0;
+	imageViewInfo.subresourceRange.layerCount = 1;
+
+	if (vkCreateImageView(device, &imageViewInfo, nullptr, &imageView) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create texture image view!");
+	}
+
+	return imageView;
+}
+
+void::Vulkan::createTextureImageView()
+{
+	textureImageView = createImageView(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, 0, 1);
+}
+
+void Vulkan::createTextureSampler()
+{
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.anisotropyEnable = VK_TRUE;
+	samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+	samplerInfo.compareEnable = VK_FALSE;
+	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.mipLodBias = 0.0f;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = 0.0f;
+
+	if (vkCreateSampler(device, &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to create texture sampler!");
+	}
+}
+
+//=================================================================
+// Mesh Loading
+//=================================================================
+
+void Vulkan::setModelPath(const string& path)
+{
+	modelPath = path;
+}
+
+void Vulkan::loadModel()
+{
+	if (modelPath.empty())
+	{
+		return; // gݍ݂̎lp`g
+	}
+
+	MeshLoadStats stats{};
+	loadMesh(modelPath, &vertices, &indices, &stats);
+	if (indices.empty())
+	{
+		throw runtime_error("mesh has no triangles: " + modelPath);
+	}
+
+	// V[̊iqɎ܂悤A_SEa0.5ɐK
+	glm::vec3 minPos(numeric_limits<float>::max());
+	glm::vec3 maxPos(-numeric_limits<float>::max());
+	for (const auto& v : vertices)
+	{
+		minPos = glm::min(minPos, v.pos);
+		maxPos = glm::max(maxPos, v.pos);
+	}
+	glm::vec3 center = (minPos + maxPos) * 0.5f;
+	float radius = 0.0f;
+	for (const auto& v : vertices)
+	{
+		radius = max(radius, glm::length(v.pos - center));
+	}
+	float scale = radius > 0.0f ? 0.5f / radius : 1.0f;
+	for (auto& v : vertices)
+	{
+		v.pos = (v.pos - center) * scale;
+	}
+
+	double seconds = stats.totalMs / 1000.0;
+	cout << "mesh: " << modelPath << ": " << stats.triangleCount << " tris, " << stats.vertexCount << " verts ("
+		<< stats.inputVertexCount << " before dedup)" << endl;
+	cout << "mesh: read " << stats.readMs << " ms, parse " << stats.parseMs << " ms, merge " << stats.mergeMs
+		<< " ms on " << stats.threadCount << " threads, " << (seconds > 0.0 ? stats.triangleCount / seconds / 1000000.0 : 0.0)
+		<< " Mtris/s" << endl;
+
+	if (enableMeshOptimization)
+	{
+		optimizeMesh();
+	}
+}
+
+void Vulkan::optimizeMesh()
+{
+	auto start = chrono::steady_clock::now();
+	VertexCacheStats before = analyzeVertexCache(indices, vertices.size(), VERTEX_CACHE_SIZE);
+
+	vector<uint32_t> clusters;
+	optimizeVertexCache(&indices, vertices.size(), VERTEX_CACHE_SIZE, &clusters);
+	VertexCacheStats afterCache = analyzeVertexCache(indices, vertices.size(), VERTEX_CACHE_SIZE);
+
+	optimizeOverdraw(&indices, vertices, clusters, VERTEX_CACHE_SIZE, OVERDRAW_THRESHOLD);
+	optimizeVertexFetch(&vertices, &indices);
+	VertexCacheStats after = analyzeVertexCache(indices, vertices.size(), VERTEX_CACHE_SIZE);
+
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	cout << "mesh optimize (cache " << VERTEX_CACHE_SIZE << "): ACMR " << before.acmr << " -> " << afterCache.acmr
+		<< " (tipsify) -> " << after.acmr << " (overdraw, " << clusters.size() << " clusters), ATVR " << before.atvr
+		<< " -> " << after.atvr << ", " << ms << " ms" << endl;
+}
+
+void Vulkan::createMeshLods()
+{
+	// LOD0͌̃bVBȍ~͎Op`LOD_REDUCTION{炵ACfbNXobt@̌ɕׂ
+	auto start = chrono::steady_clock::now();
+	vector<vector<uint32_t>> lodIndices{ indices };
+	vector<float> lodErrors{ 0.0f };
+	while (lodIndices.size() < MAX_MESH_LODS)
+	{
+		const vector<uint32_t>& source = lodIndices.back();
+		size_t target = static_cast<size_t>(source.size() / 3 * LOD_REDUCTION) * 3;
+		float error = 0.0f;
+		vector<uint32_t> lod = simplifyMesh(vertices, source, target, LOD_TARGET_ERROR, &error);
+
+		// 덷̏Ŏ~܂ĂقƂǌȂΑł؂
+		if (lod.empty() || lod.size() > source.size() * 9 / 10)
+		{
+			break;
+		}
+		if (enableMeshOptimization)
+		{
+			vector<uint32_t> clusters;
+			optimizeVertexCache(&lod, vertices.size(), VERTEX_CACHE_SIZE, &clusters);
+		}
+		lodIndices.push_back(move(lod));
+		lodErrors.push_back(max(error, lodErrors.back()));
+	}
+
+	// LOD0̓bVbgɕבւAebVbgACfbNX͈̔͂ɂ
+	// bVbg͍œKς݂̏Ɏ̂ŃI[o[h[̓bVbgPʂŎcB̏Tipsifyō蒼
+	meshlets.clear();
+	if (enableClusterCulling)
+	{
+		vector<Meshlet> clusters;
+		buildMeshlets(vertices, &lodIndices[0], MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES, &clusters);
+		if (enableMeshOptimization)
+		{
+			VertexCacheStats before = analyzeVertexCache(lodIndices[0], vertices.size(), VERTEX_CACHE_SIZE);
+			optimizeMeshletVertexCache(&lodIndices[0], vertices.size(), clusters, VERTEX_CACHE_SIZE);
+			VertexCacheStats after = analyzeVertexCache(lodIndices[0], vertices.size(), VERTEX_CACHE_SIZE);
+			cout << "meshlet optimize: ACMR " << before.acmr << " -> " << after.acmr << endl;
+		}
+		size_t coneCount = 0;
+		for (const auto& cluster : clusters)
+		{
+			MeshletData meshlet{};
+			meshlet.boundingSphere = glm::vec4(cluster.center, cluster.radius);
+			meshlet.coneApex = glm::vec4(cluster.coneApex, 1.0f);
+			meshlet.coneAxis = glm::vec4(cluster.coneAxis, cluster.coneCutoff);
+			meshlet.firstIndex = cluster.firstIndex;
+			meshlet.indexCount = cluster.indexCount;
+			meshlets.push_back(meshlet);
+			coneCount += cluster.coneCutoff < 1.0f ? 1 : 0;
+		}
+		cout << "meshlets: " << meshlets.size() << " (" << MESHLET_MAX_VERTICES << " verts / " << MESHLET_MAX_TRIANGLES
+			<< " tris max, avg " << (clusters.empty() ? 0.0 : lodIndices[0].size() / 3.0 / clusters.size()) << " tris), "
+			<< coneCount << " with a usable normal cone" << endl;
+	}
+
+	indices.clear();
+	meshLods.clear();
+	for (size_t i = 0; i < lodIndices.size(); i++)
+	{
+		MeshLod lod{};
+		lod.firstIndex = static_cast<uint32_t>(indices.size());
+		lod.indexCount = static_cast<uint32_t>(lodIndices[i].size());
+		lod.error = lodErrors[i];
+		meshLods.push_back(lod);
+		indices.insert(indices.end(), lodIndices[i].begin(), lodIndices[i].end());
+	}
+
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	cout << "mesh lods:";
+	for (const auto& lod : meshLods)
+	{
+		cout << " " << lod.indexCount / 3 << " (err " << lod.error << ")";
+	}
+	cout << ", " << ms << " ms" << endl;
+}
+
+// f̃t@CςĂΓǂݒBׂ̂1b1
+void Vulkan::checkModelReload()
+{
+	if (!enableModelReload || modelPath.empty())
+	{
+		return;
+	}
+	auto now = chrono::steady_clock::now();
+	if (now - lastModelCheck < chrono::seconds(1))
+	{
+		return;
+	}
+	lastModelCheck = now;
+
+	uint64_t sourceSize = 0;
+	int64_t sourceTime = 0;
+	if (!getSourceStamp(modelPath, &sourceSize, &sourceTime) || (sourceSize == modelSourceSize && sourceTime == modelSourceTime))
+	{
+		return;
+	}
+	modelSourceSize = sourceSize;
+	modelSourceTime = sourceTime;
+
+	// Ȃǂœǂ߂Ȃ΁Ãf̂܂܎̕ύX҂ (GPÛ̂͂܂ςĂȂ)
+	try
+	{
+		loadModel();
+	}
+	catch (const exception& e)
+	{
+		cerr << "model reload: " << e.what() << endl;
+		return;
+	}
+	reloadModel();
+}
+
+// loadModeľɌĂԁBÂbVA[iOĐVbVɒuAV[̃obt@ƃfBXNv^蒼
+void Vulkan::reloadModel()
+{
+	auto start = chrono::steady_clock::now();
+
+	// fBXNv^wobt@蒼̂ŁAoς݂̃t[Î҂ (܂Ȃ̂Ŏ~߂Ă悢)
+	vkDeviceWaitIdle(device);
+	destroySceneResources();
+	cullResultsPending.assign(framesInFlight, false);
+	objects.clear();
+	meshes.clear();
+	meshGeometry.clear();
+	drawTemplates.clear();
+	freeGeometry(modelGeometry);
+
+	// 󂢂̈ɒuBfЉēȂ΋lߒA32bit̃CfbNX΃A[iL
+	createMeshLods();
+	createMeshBuffers();
+	createScene();
+	createSceneBuffers();
+	createCullingResources();
+	vkResetDescriptorPool(device, descriptorPool, 0);
+	createDescriptorSets();
+	depthPyramidBindingStale.assign(framesInFlight, true);
+	depthPyramidNeedsClear = true; // Õf̐[xŉBȂ
+
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	cout << "model reload: " << modelPath << " in " << ms << " ms" << endl;
+}
+
+//=================================================================
+// Mesh Cache
+//=================================================================
+
+static MeshCacheSettings currentMeshCacheSettings()
+{
+	MeshCacheSettings settings{};
+	settings.vertexFormat = static_cast<uint32_t>(VERTEX_FORMAT);
+	settings.optimized = enableMeshOptimization ? 1 : 0;
+	settings.meshlets = enableClusterCulling ? 1 : 0;
+	settings.maxMeshLods = MAX_MESH_LODS;
+	settings.lodReduction = LOD_REDUCTION;
+	settings.lodTargetError = LOD_TARGET_ERROR;
+	settings.meshletMaxVertices = MESHLET_MAX_VERTICES;
+	settings.meshletMaxTriangles = MESHLET_MAX_TRIANGLES;
+	return settings;
+}
+
+// modelPath̃LbV}bvČ؂BgȂΗRofalse (t@C͖قloadModel̃G[ɂ)
+static bool openModelCache(const string& modelPath, const MeshCacheSettings& settings, MappedFile* pFile, MeshCacheData* pCache)
+{
+	uint64_t sourceSize = 0;
+	int64_t sourceTime = 0;
+	if (!getSourceStamp(modelPath, &sourceSize, &sourceTime))
+	{
+		return false;
+	}
+
+	string cachePath = modelPath + MESH_CACHE_EXTENSION;
+	string reason;
+	if (!openMeshCache(cachePath, settings, sourceSize, sourceTime, pFile, pCache, &reason))
+	{
+		cout << "mesh cache: " << cachePath << ": " << reason << ", rebuilding" << endl;
+		return false;
+	}
+	return true;
+}
+
+// LbVg邩𒲂ׂBfoCXvȂ̂ŁA̍ŏɃ[J[ŌĂŃf̓ǂݍ݂𑁂n߂
+bool Vulkan::probeMeshCache()
+{
+	if (!enableMeshCache || modelPath.empty())
+	{
+		return false;
+	}
+	MappedFile file{};
+	MeshCacheData cache{};
+	if (!openModelCache(modelPath, currentMeshCacheSettings(), &file, &cache))
+	{
+		return false;
+	}
+	unmapFile(&file);
+	return true;
+}
+
+// modelPath̃LbVV΁A}bv_ƃCfbNX̂܂܃Xe[WOobt@oRGPU֑
+// loadModel, createMeshLods, createMeshBuffers̑ɂȂ
+bool Vulkan::loadMeshCache()
+{
+	if (!enableMeshCache || modelPath.empty())
+	{
+		return false;
+	}
+
+	auto start = chrono::steady_clock::now();
+	string cachePath = modelPath + MESH_CACHE_EXTENSION;
+	MappedFile file{};
+	MeshCacheData cache{};
+	if (!openModelCache(modelPath, currentMeshCacheSettings(), &file, &cache))
+	{
+		return false;
+	}
+
+	const MeshCacheHeader& header = cache.header;
+	size_t vertexBytes = static_cast<size_t>(header.vertexCount * header.vertexStride);
+	size_t indexBytes = static_cast<size_t>(header.indexCount * header.indexSize);
+	indexType = header.indexSize == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+	modelGeometry = uploadGeometry(cache.pVertices, static_cast<uint32_t>(header.vertexCount), cache.pIndices,
+		static_cast<uint32_t>(header.indexCount), indexType);
+	memcpy(&meshDequantize, header.dequantize, sizeof(header.dequantize));
+	meshBounds = glm::vec4(header.bounds[0], header.bounds[1], header.bounds[2], header.bounds[3]);
+	meshLods.assign(cache.pLods, cache.pLods + header.lodCount);
+	meshlets.assign(cache.pMeshlets, cache.pMeshlets + header.meshletCount);
+	unmapFile(&file);
+
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	cout << "mesh cache: " << cachePath << ": " << meshLods[0].indexCount / 3 << " tris, " << meshLods.size() << " lods, "
+		<< meshlets.size() << " meshlets, " << (vertexBytes + indexBytes) / (1024.0 * 1024.0) << " MB uploaded in " << ms << " ms" << endl;
+	return true;
+}
+
+// packMesȟʂƍLODEbVbgmodelPath̃LbVɏ
+void Vulkan::writeModelCache(const vector<uint8_t>& vertexData, const vector<uint8_t>& indexData)
+{
+	MeshCacheData cache{};
+	MeshCacheHeader& header = cache.header;
+	if (!getSourceStamp(modelPath, &header.sourceSize, &header.sourceTime))
+	{
+		throw runtime_error("failed to open mesh: " + modelPath);
+	}
+	header.settings = currentMeshCacheSettings();
+	header.vertexStride = static_cast<uint32_t>(VERTEX_FORMAT == VertexFormat::Float ? sizeof(Vertex) : sizeof(PackedVertex));
+	header.indexSize = indexType == VK_INDEX_TYPE_UINT16 ? 2 : 4;
+	header.vertexCount = vertexData.size() / header.vertexStride;
+	header.indexCount = indexData.size() / header.indexSize;
+	header.lodCount = static_cast<uint32_t>(meshLods.size());
+	header.meshletCount = static_cast<uint32_t>(meshlets.size());
+	memcpy(header.dequantize, &meshDequantize, sizeof(header.dequantize));
+	memcpy(header.bounds, &meshBounds, sizeof(header.bounds));
+	cache.pVertices = vertexData.data();
+	cache.pIndices = indexData.data();
+	cache.pLods = meshLods.data();
+	cache.pMeshlets = meshlets.data();
+
+	string cachePath = modelPath + MESH_CACHE_EXTENSION;
+	writeMeshCache(cachePath, cache);
+	cout << "mesh cache: wrote " << cachePath << endl;
+}
+
+void Vulkan::convertMesh(const string& sourcePath)
+{
+	if (sourcePath.empty())
+	{
+		throw runtime_error("no source mesh to convert!");
+	}
+	modelPath = sourcePath;
+	loadModel();
+	createMeshLods();
+
+	vector<uint8_t> vertexData;
+	vector<uint8_t> indexData;
+	packMesh(&vertexData, &indexData);
+	writeModelCache(vertexData, indexData);
+}
+
+// t@C̉+ϊƁALbṼ}bv+Xe[WOpւ̃Rs[ꂼꐔsAŒZԂׂ
+// 2ڈȍ~͂ǂ̃t@COS̃LbVɍڂĂ
+void Vulkan::benchmarkMeshCache(const string& sourcePath)
+{
+	const int iterations = 3;
+	modelPath = sourcePath;
+	uint64_t sourceSize = 0;
+	int64_t sourceTime = 0;
+	if (!getSourceStamp(modelPath, &sourceSize, &sourceTime))
+	{
+		throw runtime_error("failed to open mesh: " + modelPath);
+	}
+
+	double sourceMs = numeric_limits<double>::max();
+	vector<uint8_t> vertexData;
+	vector<uint8_t> indexData;
+	for (int i = 0; i < iterations; i++)
+	{
+		auto start = chrono::steady_clock::now();
+		loadModel();
+		createMeshLods();
+		packMesh(&vertexData, &indexData);
+		sourceMs = min(sourceMs, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+	}
+	writeModelCache(vertexData, indexData);
+
+	string cachePath = modelPath + MESH_CACHE_EXTENSION;
+	double cacheMs = numeric_limits<double>::max();
+	size_t cacheSize = 0;
+	vector<uint8_t> staging;
+	for (int i = 0; i < iterations; i++)
+	{
+		auto start = chrono::steady_clock::now();
+		MappedFile file{};
+		MeshCacheData cache{};
+		string reason;
+		if (!openMeshCache(cachePath, currentMeshCacheSettings(), sourceSize, sourceTime, &file, &cache, &reason))
+		{
+			throw runtime_error("mesh cache: " + cachePath + ": " + reason);
+		}
+		size_t vertexBytes = static_cast<size_t>(cache.header.vertexCount * cache.header.vertexStride);
+		size_t indexBytes = static_cast<size_t>(cache.header.indexCount * cache.header.indexSize);
+		staging.resize(vertexBytes + indexBytes);
+		memcpy(staging.data(), cache.pVertices, vertexBytes);
+		memcpy(staging.data() + vertexBytes, cache.pIndices, indexBytes);
+		meshLods.assign(cache.pLods, cache.pLods + cache.header.lodCount);
+		meshlets.assign(cache.pMeshlets, cache.pMeshlets + cache.header.meshletCount);
+		cacheSize = file.size;
+		unmapFile(&file);
+		cacheMs = min(cacheMs, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+	}
+
+	double sourceMB = sourceSize / (1024.0 * 1024.0);
+	double cacheMB = cacheSize / (1024.0 * 1024.0);
+	cout << "mesh cache benchmark: " << sourcePath << " (best of " << iterations << ")" << endl;
+	cout << "  source: " << sourceMB << " MB, parse + process " << sourceMs << " ms (" << sourceMs / sourceMB << " ms/MB)" << endl;
+	cout << "  cache:  " << cacheMB << " MB, map + copy " << cacheMs << " ms (" << cacheMs / cacheMB << " ms/MB)" << endl;
+	cout << "  saved " << (sourceMs - cacheMs) / sourceMB << " ms per source MB (" << sourceMs / cacheMs << "x faster)" << endl;
+}
+
+//=================================================================
+// Geometry Arena
+//=================================================================
+
+// A[iւ̃Rs[`Ət
+// O: ̈ǂłÕt[̕`҂  : _ECfbNX𒸓_͂猩悤ɂ
+static void recordGeometryCopyBarrier(VkCommandBuffer commandBuffer, bool afterCopy)
+{
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	if (afterCopy)
+	{
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+	else
+	{
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 0, nullptr);
+	}
+}
+
+// bVA[iɒuăAP[V̔ԍԂ
+// 󂫂fЉĂ΋lߒAvłȂΗeʂ{XɍL
+uint32_t Vulkan::uploadGeometry(const void* pVertices, uint32_t vertexCount, const void* pIndices, uint32_t indexCount, VkIndexType meshIndexType)
+{
+	if (vertexCount == 0 || indexCount == 0)
+	{
+		throw runtime_error("failed to upload empty geometry");
+	}
+
+	if (vertexBuffer == VK_NULL_HANDLE)
+	{
+		geometryIndexType = meshIndexType;
+		vertexStride = static_cast<uint32_t>(VERTEX_FORMAT == VertexFormat::Float ? sizeof(Vertex) : sizeof(PackedVertex));
+		rebuildGeometryArena(max(GEOMETRY_ARENA_VERTICES, vertexCount), max(GEOMETRY_ARENA_INDICES, indexCount), meshIndexType);
+	}
+
+	// 16bit̃A[i32bit̃bVAuĂ郁bVƃA[i32bitɂB32bit̃A[iɂ͍Lē
+	if (geometryIndexType == VK_INDEX_TYPE_UINT16 && meshIndexType == VK_INDEX_TYPE_UINT32)
+	{
+		rebuildGeometryArena(vertexCapacity, indexCapacity, VK_INDEX_TYPE_UINT32);
+	}
+	vector<uint32_t> widenedIndices;
+	if (geometryIndexType == VK_INDEX_TYPE_UINT32 && meshIndexType == VK_INDEX_TYPE_UINT16)
+	{
+		const uint16_t* pIndices16 = static_cast<const uint16_t*>(pIndices);
+		widenedIndices.assign(pIndices16, pIndices16 + indexCount);
+		pIndices = widenedIndices.data();
+	}
+
+	uint64_t vertexOffset = 0;
+	uint64_t firstIndex = 0;
+	auto allocate = [&]()
+	{
+		if (!allocateRange(&freeVertexRanges, vertexCount, &vertexOffset))
+		{
+			return false;
+		}
+		if (!allocateRange(&freeIndexRanges, indexCount, &firstIndex))
+		{
+			freeRange(&freeVertexRanges, vertexOffset, vertexCount);
+			return false;
+		}
+		return true;
+	};
+	if (!allocate())
+	{
+		uint64_t freeVertices = totalFreeRange(freeVertexRanges);
+		uint64_t freeIndices = totalFreeRange(freeIndexRanges);
+		if (freeVertices >= vertexCount && freeIndices >= indexCount)
+		{
+			compactGeometry();
+		}
+		else
+		{
+			uint64_t usedVertices = vertexCapacity - freeVertices;
+			uint64_t usedIndices = indexCapacity - freeIndices;
+			uint64_t newVertexCapacity = vertexCapacity;
+			uint64_t newIndexCapacity = indexCapacity;
+			while (newVertexCapacity < usedVertices + vertexCount)
+			{
+				newVertexCapacity *= 2;
+			}
+			while (newIndexCapacity < usedIndices + indexCount)
+			{
+				newIndexCapacity *= 2;
+			}
+			if (newVertexCapacity > numeric_limits<uint32_t>::max() || newIndexCapacity > numeric_limits<uint32_t>::max())
+			{
+				throw runtime_error("failed to grow geometry arena!");
+			}
+			rebuildGeometryArena(static_cast<uint32_t>(newVertexCapacity), static_cast<uint32_t>(newIndexCapacity), geometryIndexType);
+		}
+		if (!allocate())
+		{
+			throw runtime_error("failed to allocate geometry!");
+		}
+	}
+
+	size_t indexSize = geometryIndexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	size_t vertexBytes = static_cast<size_t>(vertexCount) * vertexStride;
+	size_t indexBytes = static_cast<size_t>(indexCount) * indexSize;
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	createBuffer(vertexBytes + indexBytes, &stagingBuffer, &stagingBufferMemory, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::Staging, "geometry staging");
+	void* pointer;
+	vkMapMemory(device, stagingBufferMemory, 0, vertexBytes + indexBytes, 0, &pointer);
+	memcpy(pointer, pVertices, vertexBytes);
+	memcpy(static_cast<uint8_t*>(pointer) + vertexBytes, pIndices, indexBytes);
+	vkUnmapMemory(device, stagingBufferMemory);
+
+	VkBufferCopy vertexCopy{};
+	vertexCopy.srcOffset = 0;
+	vertexCopy.dstOffset = vertexOffset * vertexStride;
+	vertexCopy.size = vertexBytes;
+	VkBufferCopy indexCopy{};
+	indexCopy.srcOffset = vertexBytes;
+	indexCopy.dstOffset = firstIndex * indexSize;
+	indexCopy.size = indexBytes;
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	recordGeometryCopyBarrier(commandBuffer, false);
+	vkCmdCopyBuffer(commandBuffer, stagingBuffer, vertexBuffer, 1, &vertexCopy);
+	vkCmdCopyBuffer(commandBuffer, stagingBuffer, indexBuffer, 1, &indexCopy);
+	recordGeometryCopyBarrier(commandBuffer, true);
+	endSingleTimeCommands(commandBuffer);
+
+	vkDestroyBuffer(device, stagingBuffer, nullptr);
+	freeMemory(stagingBufferMemory);
+
+	GeometryAllocation allocation{};
+	allocation.vertexOffset = static_cast<uint32_t>(vertexOffset);
+	allocation.vertexCount = vertexCount;
+	allocation.firstIndex = static_cast<uint32_t>(firstIndex);
+	allocation.indexCount = indexCount;
+	allocation.live = true;
+	geometryAllocations.push_back(allocation);
+	return static_cast<uint32_t>(geometryAllocations.size() - 1);
+}
+
+// ͎̈̃Abv[hōėp (㏑Rs[͑Õt[̕`҂)
+void Vulkan::freeGeometry(uint32_t allocation)
+{
+	GeometryAllocation& geometry = geometryAllocations[allocation];
+	if (!geometry.live)
+	{
+		return;
+	}
+	freeRange(&freeVertexRanges, geometry.vertexOffset, geometry.vertexCount);
+	freeRange(&freeIndexRanges, geometry.firstIndex, geometry.indexCount);
+	geometry.live = false;
+}
+
+void Vulkan::compactGeometry()
+{
+	rebuildGeometryArena(vertexCapacity, indexCapacity, geometryIndexType);
+}
+
+// VeʂƃCfbNX̌^Ńobt@蒼AĂ郁bV擪猄ԂȂRs[
+void Vulkan::rebuildGeometryArena(uint32_t newVertexCapacity, uint32_t newIndexCapacity, VkIndexType newIndexType)
+{
+	size_t oldIndexSize = geometryIndexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	size_t indexSize = newIndexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	bool widen = indexSize != oldIndexSize;
+	VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	VkBuffer newVertexBuffer;
+	VkDeviceMemory newVertexBufferMemory;
+	VkBuffer newIndexBuffer;
+	VkDeviceMemory newIndexBufferMemory;
+	createBuffer(static_cast<size_t>(newVertexCapacity) * vertexStride, &newVertexBuffer, &newVertexBufferMemory,
+		usage | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Vertex, "geometry arena vertices");
+	createBuffer(static_cast<size_t>(newIndexCapacity) * indexSize, &newIndexBuffer, &newIndexBufferMemory,
+		usage | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Index, "geometry arena indices");
+
+	vector<GeometryAllocation> oldAllocations = geometryAllocations;
+	vector<VkBufferCopy> vertexCopies;
+	vector<VkBufferCopy> indexCopies;
+	uint32_t vertexEnd = 0;
+	uint32_t indexEnd = 0;
+	for (auto& allocation : geometryAllocations)
+	{
+		if (!allocation.live)
+		{
+			continue;
+		}
+		vertexCopies.push_back({ static_cast<VkDeviceSize>(allocation.vertexOffset) * vertexStride,
+			static_cast<VkDeviceSize>(vertexEnd) * vertexStride, static_cast<VkDeviceSize>(allocation.vertexCount) * vertexStride });
+		indexCopies.push_back({ allocation.firstIndex * oldIndexSize, indexEnd * oldIndexSize, allocation.indexCount * oldIndexSize });
+		allocation.vertexOffset = vertexEnd;
+		allocation.firstIndex = indexEnd;
+		vertexEnd += allocation.vertexCount;
+		indexEnd += allocation.indexCount;
+	}
+
+	if (!vertexCopies.empty())
+	{
+		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+		vkCmdCopyBuffer(commandBuffer, vertexBuffer, newVertexBuffer, static_cast<uint32_t>(vertexCopies.size()), vertexCopies.data());
+		if (!widen)
+		{
+			vkCmdCopyBuffer(commandBuffer, indexBuffer, newIndexBuffer, static_cast<uint32_t>(indexCopies.size()), indexCopies.data());
+		}
+		recordGeometryCopyBarrier(commandBuffer, true);
+		endSingleTimeCommands(commandBuffer);
+		if (widen)
+		{
+			widenGeometryIndices(newIndexBuffer, indexCopies, indexEnd);
+		}
+	}
+
+	// Âobt@͒oς݂̃t[ƃRs[IĂj
+	destroyLater(DeferredObject::Buffer, vertexBuffer);
+	destroyLater(DeferredObject::Memory, vertexBufferMemory);
+	destroyLater(DeferredObject::Buffer, indexBuffer);
+	destroyLater(DeferredObject::Memory, indexBufferMemory);
+	vertexBuffer = newVertexBuffer;
+	vertexBufferMemory = newVertexBufferMemory;
+	indexBuffer = newIndexBuffer;
+	indexBufferMemory = newIndexBufferMemory;
+	vertexCapacity = newVertexCapacity;
+	indexCapacity = newIndexCapacity;
+	geometryIndexType = newIndexType;
+
+	freeVertexRanges.clear();
+	freeIndexRanges.clear();
+	freeRange(&freeVertexRanges, vertexEnd, vertexCapacity - vertexEnd);
+	freeRange(&freeIndexRanges, indexEnd, indexCapacity - indexEnd);
+
+	cout << "geometry arena: " << vertexEnd << "/" << vertexCapacity << " vertices, " << indexEnd << "/" << indexCapacity
+		<< " indices (" << (indexSize * 8) << "-bit), " << vertexCopies.size() << " meshes moved" << endl;
+
+	relocateSceneGeometry(oldAllocations);
+}
+
+// 16bit̃CfbNX̓oCg̃Rs[ł32bitɂȂȂ̂ŁAl߂CPU֓ǂݖ߂čLAVobt@̐擪珑
+// (bVƂ̃CfbNXvertexOffset̑΂Ȃ̂Œl͂̂܂)
+void Vulkan::widenGeometryIndices(VkBuffer newIndexBuffer, const vector<VkBufferCopy>& copies, uint32_t indexCount)
+{
+	size_t narrowBytes = static_cast<size_t>(indexCount) * sizeof(uint16_t);
+	size_t wideBytes = static_cast<size_t>(indexCount) * sizeof(uint32_t);
+	VkBuffer readbackBuffer;
+	VkDeviceMemory readbackBufferMemory;
+	createBuffer(narrowBytes, &readbackBuffer, &readbackBufferMemory, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::Staging, "geometry index readback");
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	createBuffer(wideBytes, &stagingBuffer, &stagingBufferMemory, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::Staging, "geometry staging");
+
+	// ÕAbv[h݂̏ǂ݁Aǂݖ߂lzXg猩悤ɂ
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	vkCmdCopyBuffer(commandBuffer, indexBuffer, readbackBuffer, static_cast<uint32_t>(copies.size()), copies.data());
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	endSingleTimeCommands(commandBuffer);
+
+	void* pNarrow;
+	void* pWide;
+	vkMapMemory(device, readbackBufferMemory, 0, narrowBytes, 0, &pNarrow);
+	vkMapMemory(device, stagingBufferMemory, 0, wideBytes, 0, &pWide);
+	const uint16_t* pSource = static_cast<const uint16_t*>(pNarrow);
+	uint32_t* pDestination = static_cast<uint32_t*>(pWide);
+	for (uint32_t i = 0; i < indexCount; i++)
+	{
+		pDestination[i] = pSource[i];
+	}
+	vkUnmapMemory(device, stagingBufferMemory);
+	vkUnmapMemory(device, readbackBufferMemory);
+
+	VkBufferCopy copy{};
+	copy.size = wideBytes;
+	commandBuffer = beginSingleTimeCommands();
+	vkCmdCopyBuffer(commandBuffer, stagingBuffer, newIndexBuffer, 1, &copy);
+	recordGeometryCopyBarrier(commandBuffer, true);
+	endSingleTimeCommands(commandBuffer);
+
+	vkDestroyBuffer(device, stagingBuffer, nullptr);
+	freeMemory(stagingBufferMemory);
+	vkDestroyBuffer(device, readbackBuffer, nullptr);
+	freeMemory(readbackBufferMemory);
+}
+
+// lߒœbV̕`R}h̐`EbVEbVbgtւGPUɑ蒼
+void Vulkan::relocateSceneGeometry(const vector<GeometryAllocation>& oldAllocations)
+{
+	if (meshes.empty())
+	{
+		return; // V[OȂAcreateSceneVʒug
+	}
+
+	uint32_t drawCount = static_cast<uint32_t>(drawTemplates.size()) / 2;
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		const GeometryAllocation& before = oldAllocations[meshGeometry[i]];
+		const GeometryAllocation& after = geometryAllocations[meshGeometry[i]];
+		uint32_t indexDelta = after.firstIndex - before.firstIndex; // Ȃ̊߂ŌZ\
+
+		MeshData& mesh = meshes[i];
+		mesh.vertexOffset = static_cast<int32_t>(after.vertexOffset);
+		for (uint32_t pass = 0; pass < 2; pass++)
+		{
+			for (uint32_t lod = 0; lod < mesh.lodCount; lod++)
+			{
+				VkDrawIndexedIndirectCommand& draw = drawTemplates[pass * drawCount + mesh.firstDraw + lod];
+				draw.firstIndex += indexDelta;
+				draw.vertexOffset = mesh.vertexOffset;
+			}
+		}
+		for (uint32_t m = 0; m < mesh.meshletCount; m++)
+		{
+			meshlets[mesh.firstMeshlet + m].firstIndex += indexDelta;
+		}
+	}
+
+	updateDeviceLocalBuffer(meshBuffer, meshes.data(), sizeof(meshes[0]) * meshes.size());
+	updateDeviceLocalBuffer(drawTemplateBuffer, drawTemplates.data(), sizeof(drawTemplates[0]) * drawTemplates.size());
+	if (!meshlets.empty())
+	{
+		updateDeviceLocalBuffer(meshletBuffer, meshlets.data(), sizeof(meshlets[0]) * meshlets.size());
+	}
+}
+
+//=================================================================
+// GPU Culling
+//=================================================================
+
+void Vulkan::createScene()
+{
+	// bṼ[JE (packMeshLbVŌ܂)
+	glm::vec3 center(meshBounds);
+	float radius = meshBounds.w;
+
+	// E͒_obt@Ɠ(ʎqꂽ)ԂŎ
+	glm::mat4 quantize = glm::inverse(meshDequantize);
+	glm::vec4 boundingSphere(glm::vec3(quantize * glm::vec4(center, 1.0f)), radius * glm::length(glm::vec3(quantize[0])));
+
+	// LODƃbVbgfirstIndex̓bV̈ʒuȂ̂ŁAA[ïʒu𑫂
+	const GeometryAllocation& geometry = geometryAllocations[modelGeometry];
+
+	MeshData mesh{};
+	mesh.firstDraw = static_cast<uint32_t>(drawTemplates.size());
+	mesh.lodCount = static_cast<uint32_t>(meshLods.size());
+	mesh.firstMeshlet = 0;
+	mesh.meshletCount = static_cast<uint32_t>(meshlets.size());
+	mesh.vertexOffset = static_cast<int32_t>(geometry.vertexOffset);
+	meshes.push_back(mesh);
+	meshGeometry.push_back(modelGeometry);
+
+	// bVbg̋EʎqꂽԂɈڂ (Ȃ̂ŃR[̎cutoff͂̂܂)
+	float quantizeScale = glm::length(glm::vec3(quantize[0]));
+	for (auto& meshlet : meshlets)
+	{
+		meshlet.boundingSphere = glm::vec4(glm::vec3(quantize * glm::vec4(glm::vec3(meshlet.boundingSphere), 1.0f)),
+			meshlet.boundingSphere.w * quantizeScale);
+		meshlet.coneApex = quantize * glm::vec4(glm::vec3(meshlet.coneApex), 1.0f);
+		meshlet.firstIndex += geometry.firstIndex;
+	}
+
+	// LODƂɕ`Xbg1g
+	for (const auto& lod : meshLods)
+	{
+		VkDrawIndexedIndirectCommand draw{};
+		draw.indexCount = lod.indexCount;
+		draw.instanceCount = 0;
+		draw.firstIndex = geometry.firstIndex + lod.firstIndex;
+		draw.vertexOffset = mesh.vertexOffset;
+		drawTemplates.push_back(draw);
+	}
+
+	// xyʂɊiqɕׂ
+	const float spacing = 1.5f;
+	const float origin = -0.5f * spacing * (SCENE_GRID_SIZE - 1);
+	for (uint32_t y = 0; y < SCENE_GRID_SIZE; y++)
+	{
+		for (uint32_t x = 0; x < SCENE_GRID_SIZE; x++)
+		{
+			ObjectData object{};
+			object.model = glm::translate(glm::mat4(1.0f), glm::vec3(origin + x * spacing, origin + y * spacing, 0.0f)) * meshDequantize;
+			object.boundingSphere = boundingSphere;
+			object.meshIndex = 0;
+			objects.push_back(object);
+		}
+	}
+
+	// OpXpƌ㔼pXpɕ`Xbg2gׂ
+	size_t drawCount = drawTemplates.size();
+	for (size_t i = 0; i < drawCount; i++)
+	{
+		drawTemplates.push_back(drawTemplates[i]);
+	}
+
+	// visibleInstances͕`XbgƂobjects.size()̗̈
+	for (size_t i = 0; i < drawTemplates.size(); i++)
+	{
+		drawTemplates[i].firstInstance = static_cast<uint32_t>(i * objects.size());
+	}
+}
+
+void Vulkan::createSceneBuffers()
+{
+	createDeviceLocalBuffer(objects.data(), sizeof(objects[0]) * objects.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		&objectBuffer, &objectBufferMemory,
+		MemoryCategory::Storage, "object table");
+	createDeviceLocalBuffer(meshes.data(), sizeof(meshes[0]) * meshes.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		&meshBuffer, &meshBufferMemory,
+		MemoryCategory::Storage, "mesh table");
+	createDeviceLocalBuffer(drawTemplates.data(), sizeof(drawTemplates[0]) * drawTemplates.size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		&drawTemplateBuffer, &drawTemplateBufferMemory,
+		MemoryCategory::Storage, "draw templates");
+
+	// t[܂Ŏĝ1 (L[Ȃ̂őOt[݂̏̓oAő҂Ă)
+	vector<uint32_t> objectLods(objects.size(), 0);
+	createDeviceLocalBuffer(objectLods.data(), sizeof(objectLods[0]) * objectLods.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		&objectLodBuffer, &objectLodBufferMemory,
+		MemoryCategory::Storage, "object lods");
+
+	// bVbgȂĂfBXNv^ɓn悤Œ1u
+	vector<MeshletData> meshletData = meshlets;
+	if (meshletData.empty())
+	{
+		meshletData.push_back(MeshletData{});
+	}
+	createDeviceLocalBuffer(meshletData.data(), sizeof(meshletData[0]) * meshletData.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		&meshletBuffer, &meshletBufferMemory,
+		MemoryCategory::Storage, "meshlets");
+}
+
+void Vulkan::createCullingResources()
+{
+	// bVbg̕`1pXőőSIuWFNg̑SbVbg
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	clusterDrawCapacity = 0;
+	if (enableClusterCulling && multiDrawIndirectSupported)
+	{
+		size_t capacity = objects.size() * meshlets.size();
+		capacity = min<size_t>(capacity, MAX_CLUSTER_DRAWS);
+		capacity = min<size_t>(capacity, properties.limits.maxDrawIndirectCount);
+		clusterDrawCapacity = static_cast<uint32_t>(capacity);
+	}
+
+	size_t drawSize = sizeof(VkDrawIndexedIndirectCommand) * drawTemplates.size();
+	size_t visibleSize = sizeof(uint32_t) * (objects.size() * drawTemplates.size() + 2 * clusterDrawCapacity);
+	size_t clusterDrawSize = sizeof(VkDrawIndexedIndirectCommand) * max<size_t>(2 * clusterDrawCapacity, 1);
+
+	drawCommandBuffers.resize(framesInFlight);
+	drawCommandBuffersMemory.resize(framesInFlight);
+	visibleBuffers.resize(framesInFlight);
+	visibleBuffersMemory.resize(framesInFlight);
+	cullStatsBuffers.resize(framesInFlight);
+	cullStatsBuffersMemory.resize(framesInFlight);
+	cullStatsBuffersMapped.resize(framesInFlight);
+	cullStateBuffers.resize(framesInFlight);
+	cullStateBuffersMemory.resize(framesInFlight);
+	cullResultsPending.resize(framesInFlight, false);
+	clusterObjectBuffers.resize(framesInFlight);
+	clusterObjectBuffersMemory.resize(framesInFlight);
+	clusterStateBuffers.resize(framesInFlight);
+	clusterStateBuffersMemory.resize(framesInFlight);
+	clusterDrawBuffers.resize(framesInFlight);
+	clusterDrawBuffersMemory.resize(framesInFlight);
+
+	for (uint32_t i = 0; i < framesInFlight; i++)
+	{
+		createBuffer(drawSize, &drawCommandBuffers[i], &drawCommandBuffersMemory[i],
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Storage, "draw commands");
+		createBuffer(visibleSize, &visibleBuffers[i], &visibleBuffersMemory[i], VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Storage, "visible instances");
+		// v̓tFX҂̌CPU璼ړǂ
+		createBuffer(sizeof(CullingStats), &cullStatsBuffers[i], &cullStatsBuffersMemory[i],
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::Storage, "culling stats");
+		vkMapMemory(device, cullStatsBuffersMemory[i], 0, sizeof(CullingStats), 0, &cullStatsBuffersMapped[i]);
+		createBuffer(sizeof(uint32_t) * objects.size(), &cullStateBuffers[i], &cullStateBuffersMemory[i],
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Storage, "culling state");
+		createBuffer(sizeof(uint32_t) * 2 * objects.size(), &clusterObjectBuffers[i], &clusterObjectBuffersMemory[i],
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Storage, "cluster objects");
+		createBuffer(sizeof(ClusterCullState) * 2, &clusterStateBuffers[i], &clusterStateBuffersMemory[i],
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Storage, "cluster state");
+		createBuffer(clusterDrawSize, &clusterDrawBuffers[i], &clusterDrawBuffersMemory[i],
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Storage, "cluster draws");
+	}
+}
+
+// createSceneBufferscreateCullingResourcesō̂ (GPUgIĂĂ)
+void Vulkan::destroySceneResources()
+{
+	for (uint32_t i = 0; i < framesInFlight; i++)
+	{
+		vkDestroyBuffer(device, drawCommandBuffers[i], nullptr);
+		freeMemory(drawCommandBuffersMemory[i]);
+		vkDestroyBuffer(device, visibleBuffers[i], nullptr);
+		freeMemory(visibleBuffersMemory[i]);
+		vkDestroyBuffer(device, cullStatsBuffers[i], nullptr);
+		freeMemory(cullStatsBuffersMemory[i]);
+		vkDestroyBuffer(device, cullStateBuffers[i], nullptr);
+		freeMemory(cullStateBuffersMemory[i]);
+		vkDestroyBuffer(device, clusterObjectBuffers[i], nullptr);
+		freeMemory(clusterObjectBuffersMemory[i]);
+		vkDestroyBuffer(device, clusterStateBuffers[i], nullptr);
+		freeMemory(clusterStateBuffersMemory[i]);
+		vkDestroyBuffer(device, clusterDrawBuffers[i], nullptr);
+		freeMemory(clusterDrawBuffersMemory[i]);
+	}
+	vkDestroyBuffer(device, objectBuffer, nullptr);
+	freeMemory(objectBufferMemory);
+	vkDestroyBuffer(device, meshBuffer, nullptr);
+	freeMemory(meshBufferMemory);
+	vkDestroyBuffer(device, objectLodBuffer, nullptr);
+	freeMemory(objectLodBufferMemory);
+	vkDestroyBuffer(device, meshletBuffer, nullptr);
+	freeMemory(meshletBufferMemory);
+	vkDestroyBuffer(device, drawTemplateBuffer, nullptr);
+	freeMemory(drawTemplateBufferMemory);
+}
+
+void Vulkan::createCullingPipeline()
+{
+	auto compShaderCode = readFile("shaders/cull.spv");
+	VkShaderModule compShaderModule = createShaderModule(compShaderCode);
+
+	VkPipelineShaderStageCreateInfo compShaderStageInfo{};
+	compShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	compShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	compShaderStageInfo.module = compShaderModule;
+	compShaderStageInfo.pName = "main";
+
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(CullPushConstants);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &cullDescriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &cullPipelineLayout) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to create culling pipeline layout!");
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = compShaderStageInfo;
+	pipelineInfo.layout = cullPipelineLayout;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	pipelineInfo.basePipelineIndex = -1;
+
+	if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &cullPipeline) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to create culling pipeline!");
+	}
+
+	vkDestroyShaderModule(device, compShaderModule, nullptr);
+
+	// bVbg̃JO͓CAEgƃvbV萔g
+	auto clusterShaderCode = readFile("shaders/cluster_cull.spv");
+	VkShaderModule clusterShaderModule = createShaderModule(clusterShaderCode);
+	pipelineInfo.stage.module = clusterShaderModule;
+
+	if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &clusterCullPipeline) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to create cluster culling pipeline!");
+	}
+
+	vkDestroyShaderModule(device, clusterShaderModule, nullptr);
+}
+
+void Vulkan::recordCulling(VkCommandBuffer commandBuffer, uint32_t pass)
+{
+	uint32_t drawCount = static_cast<uint32_t>(drawTemplates.size()) / 2;
+
+	if (pass == 0)
+	{
+		// pXinstanceCountƓv0ɖ߂
+		VkBufferCopy copyRegion{};
+		copyRegion.size = sizeof(VkDrawIndexedIndirectCommand) * drawTemplates.size();
+		vkCmdCopyBuffer(commandBuffer, drawTemplateBuffer, drawCommandBuffers[currentFrame], 1, &copyRegion);
+		vkCmdFillBuffer(commandBuffer, cullStatsBuffers[currentFrame], 0, sizeof(CullingStats), 0);
+
+		// bVbg̃JE^ƊԐڃfBXpb` (y,z1)
+		array<ClusterCullState, 2> clusterStates{};
+		for (auto& state : clusterStates)
+		{
+			state.groupCountY = 1;
+			state.groupCountZ = 1;
+		}
+		vkCmdUpdateBuffer(commandBuffer, clusterStateBuffers[currentFrame], 0, sizeof(clusterStates), clusterStates.data());
+		if (clusterDrawCapacity > 0 && !drawIndirectCountSupported)
+		{
+			vkCmdFillBuffer(commandBuffer, clusterDrawBuffers[currentFrame], 0, VK_WHOLE_SIZE, 0);
+		}
 
-	createBuffer(size, &vertexBuffer, &vertexBufferMemory, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-				 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		// Zbg -> JO (Ot[Hi-ZȂǃpX̊OƂ̓̓t[Ots)
+		VkMemoryBarrier resetBarrier{};
+		resetBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		resetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		resetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+			1, &resetBarrier, 0, nullptr, 0, nullptr);
+	}
 
-	copyBuffer(stagingBuffer, vertexBuffer, size);
+	CullPushConstants pushConstants{};
+	pushConstants.objectCount = static_cast<uint32_t>(objects.size());
+	pushConstants.drawCapacity = static_cast<uint32_t>(objects.size());
+	pushConstants.lodPixelThreshold = LOD_PIXEL_THRESHOLD;
+	pushConstants.viewportHeight = static_cast<float>(swapChainExtent.height);
+	pushConstants.pass = pass;
+	pushConstants.drawOffset = pass * drawCount;
+	pushConstants.occlusionEnabled = enableOcclusionCulling ? 1 : 0;
+	pushConstants.lodHysteresis = LOD_HYSTERESIS;
+	pushConstants.clusterDrawCapacity = clusterDrawCapacity;
+	pushConstants.clusterInstanceBase = static_cast<uint32_t>(objects.size() * drawTemplates.size());
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout, 0, 1, &cullDescriptorSets[currentFrame], 0, nullptr);
+	vkCmdPushConstants(commandBuffer, cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+	vkCmdDispatch(commandBuffer, (pushConstants.objectCount + 63) / 64, 1, 1);
+
+	if (clusterDrawCapacity > 0)
+	{
+		recordClusterCulling(commandBuffer, pass);
+	}
 
-	vkDestroyBuffer(device, stagingBuffer, nullptr);
-	vkFreeMemory(device, stagingBufferMemory, nullptr);
+	// ʂԐڕ`E_VF[_[ECPU猩悤ɂoA̓t[Ot̃pX̑Oɓ
+	// (vZL[Ŏs̓OtBbNXL[̃Z}tH̑҂Ō悤ɂȂ)
+	cullResultsPending[currentFrame] = true;
 }
 
-void Vulkan::createIndexBuffer(void* pData, size_t size)
+// recordCullinǧɁAbVbgPʂɉ񂵂IuWFNg1IuWFNg1[NO[vŃJO
+// fBXNv^ZbgƃvbV萔̓CAEgȂ̂cullPipelinê̂p
+void Vulkan::recordClusterCulling(VkCommandBuffer commandBuffer, uint32_t pass)
 {
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-	createBuffer(size, &stagingBuffer, &stagingBufferMemory, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-	void* pointer;
-	vkMapMemory(device, stagingBufferMemory, 0, size, 0, &pointer);
-	memcpy(pointer, pData, size);
-	vkUnmapMemory(device, stagingBufferMemory);
-
-	createBuffer(size, &indexBuffer, &indexBufferMemory, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, clusterCullPipeline);
+	vkCmdDispatchIndirect(commandBuffer, clusterStateBuffers[currentFrame], pass * sizeof(ClusterCullState));
+}
 
-	copyBuffer(stagingBuffer, indexBuffer, size);
+// frameTimelineValues[frame]҂ɌĂԁBGPU~߂framesInFlightǑʂǂ
+void Vulkan::readCullingResults(uint32_t frame)
+{
+	if (!cullResultsPending[frame])
+	{
+		return;
+	}
+	cullResultsPending[frame] = false;
 
-	vkDestroyBuffer(device, stagingBuffer, nullptr);
-	vkFreeMemory(device, stagingBufferMemory, nullptr);
+	memcpy(&cullingStats, cullStatsBuffersMapped[frame], sizeof(CullingStats));
 }
 
-void Vulkan::createUniformBuffers()
+void Vulkan::reportStats()
 {
-	size_t size = sizeof(UniformBufferObject);
-	uniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
-	uniformBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
-	uniformBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
+	auto now = chrono::steady_clock::now();
+	if (now - lastStatsReport < chrono::seconds(1))
+	{
+		return;
+	}
+	lastStatsReport = now;
 
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	cout << "culling: visible " << cullingStats.visibleCount << "/" << objects.size()
+		<< ", frustum culled " << cullingStats.frustumCulledCount
+		<< ", occlusion culled " << cullingStats.occlusionCulledCount
+		<< ", disoccluded " << cullingStats.disoccludedCount << ", lod [";
+	for (uint32_t i = 0; i < MAX_MESH_LODS; i++)
 	{
-		createBuffer(size, &uniformBuffers[i], &uniformBuffersMemory[i], VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 
-					 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		cout << (i == 0 ? "" : " ") << cullingStats.lodVisibleCount[i];
+	}
+	cout << "], tris " << cullingStats.submittedTriangles << "/" << cullingStats.fullDetailTriangles;
+	if (cullingStats.fullDetailTriangles > 0)
+	{
+		cout << " (" << 100.0 * cullingStats.submittedTriangles / cullingStats.fullDetailTriangles << "%)";
+	}
+	if (clusterDrawCapacity > 0)
+	{
+		cout << ", meshlets " << cullingStats.meshletVisibleCount << " visible in " << cullingStats.clusterObjectCount
+			<< " objects, frustum culled " << cullingStats.meshletFrustumCulledCount
+			<< ", backface culled " << cullingStats.meshletBackfaceCulledCount;
+	}
+	if (readbackCount > 0)
+	{
+		cout << ", readback " << readbackCount << " frames, " << readbackMsSum / readbackCount << " ms each on cpu";
+		readbackCount = 0;
+		readbackMsSum = 0.0;
+	}
+	if (latencySamples > 0)
+	{
+		cout << ", latency " << latencyMsSum / latencySamples << " ms avg / " << latencyMsMax << " ms max"
+			<< (presentWaitSupported ? "" : " (est)");
+		latencyMsSum = 0.0;
+		latencyMsMax = 0.0;
+		latencySamples = 0;
+	}
+	cout << endl;
 
-		vkMapMemory(device, uniformBuffersMemory[i], 0, size, 0, &uniformBuffersMapped[i]);
+	for (const auto& profile : { make_pair("cpu", &cpuZoneStats), make_pair("gpu", &gpuScopeStats) })
+	{
+		if (profile.second->empty())
+		{
+			continue;
+		}
+		cout << profile.first << " (min/avg/p99 ms):";
+		for (const auto& stats : *profile.second)
+		{
+			double minMs, avgMs, p99Ms;
+			if (summarizeProfileScope(stats, &minMs, &avgMs, &p99Ms))
+			{
+				cout << " " << stats.name << " " << minMs << "/" << avgMs << "/" << p99Ms << ",";
+			}
+		}
+		cout << endl;
+	}
+
+	// 1t[̕ρBoverdraw̓tOgVF[_̋N / ʂ̉f
+	double pixels = static_cast<double>(swapChainExtent.width) * swapChainExtent.height;
+	for (auto& pass : pipelineStats)
+	{
+		if (pass.windowFrames == 0)
+		{
+			continue;
+		}
+		double frames = static_cast<double>(pass.windowFrames);
+		const PipelineStatistics& window = pass.window;
+		cout << "pipeline " << pass.name << " (per frame): ia verts " << window.inputVertices / frames
+			<< ", ia prims " << window.inputPrimitives / frames
+			<< ", vs " << window.vertexInvocations / frames
+			<< " (" << (window.inputVertices > 0 ? static_cast<double>(window.vertexInvocations) / window.inputVertices : 0.0) << " per vert)"
+			<< ", clip prims " << window.clippingPrimitives / frames
+			<< ", fs " << window.fragmentInvocations / frames
+			<< " (overdraw " << window.fragmentInvocations / frames / pixels << ")" << endl;
+		pass.window = PipelineStatistics{};
+		pass.windowFrames = 0;
 	}
 }
 
-uint32_t Vulkan::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+//=================================================================
+// Hi-Z Occlusion Culling
+//=================================================================
+
+// [x̓t[̒ŎĝŁAt[OẗꎞC[WƂč
+void Vulkan::createDepthResources()
+{
+	buildFrameGraph();
+	depthImage = frameGraph.resources[frameGraphDepth].handle;
+	depthImageView = createImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1);
+}
+
+VkFormat Vulkan::findDepthFormat()
 {
-	VkPhysicalDeviceMemoryProperties physMemProps;
-	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &physMemProps);
-	for (uint32_t i = 0; i < physMemProps.memoryTypeCount; i++)
+	const vector<VkFormat> candidates = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT };
+	VkFormatFeatureFlags features = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+
+	for (VkFormat format : candidates)
 	{
-		if (typeFilter & (1 << i) && (physMemProps.memoryTypes[i].propertyFlags & properties) == properties)
+		VkFormatProperties props;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+		if ((props.optimalTilingFeatures & features) == features)
 		{
-			return i;
+			return format;
 		}
 	}
-	throw runtime_error("failed to find suitable memory type!");
+
+	throw runtime_error("failed to find supported depth format!");
 }
 
-void Vulkan::createDescriptorSetLayout()
+void Vulkan::createDepthReducePipeline()
 {
-	VkDescriptorSetLayoutBinding uboLayoutBinding{};
-	uboLayoutBinding.binding = 0;
-	uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	uboLayoutBinding.descriptorCount = 1;
-	uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-	uboLayoutBinding.pImmutableSamplers = nullptr;
-
-	VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-	samplerLayoutBinding.binding = 1;
-	samplerLayoutBinding.descriptorCount = 1;
-	samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	samplerLayoutBinding.pImmutableSamplers = nullptr;
-	samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	// 0:k 1:k
+	array<VkDescriptorSetLayoutBinding, 2> bindings{};
+	bindings[0].binding = 0;
+	bindings[0].descriptorCount = 1;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings[1].binding = 1;
+	bindings[1].descriptorCount = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
-	array<VkDescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, samplerLayoutBinding };
-	
 	VkDescriptorSetLayoutCreateInfo layoutInfo{};
 	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
 	layoutInfo.pBindings = bindings.data();
 
-	if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+	if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &depthReduceSetLayout) != VK_SUCCESS)
 	{
-		throw runtime_error("failed to create descriptor set layout!");
+		throw runtime_error("failed to create depth reduce descriptor set layout!");
 	}
-}
-
-void Vulkan::createDescriptorPool()
-{
-	array<VkDescriptorPoolSize, 2> poolSizes{};
-	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	poolSizes[0].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	poolSizes[1].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
 
-	VkDescriptorPoolCreateInfo poolInfo{};
-	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-	poolInfo.pPoolSizes = poolSizes.data();
-	poolInfo.maxSets = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &depthReduceSetLayout;
 
-	if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+	if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &depthReducePipelineLayout) != VK_SUCCESS)
 	{
-		throw runtime_error("failed to create descriptor pool!");
+		throw runtime_error("failed to create depth reduce pipeline layout!");
 	}
-}
 
-void Vulkan::createDescriptorSets()
-{
-	vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
-	VkDescriptorSetAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	allocInfo.descriptorPool = descriptorPool;
-	allocInfo.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-	allocInfo.pSetLayouts = layouts.data();
+	auto compShaderCode = readFile("shaders/depth_reduce.spv");
+	VkShaderModule compShaderModule = createShaderModule(compShaderCode);
 
-	descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = compShaderModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = depthReducePipelineLayout;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	pipelineInfo.basePipelineIndex = -1;
 
-	if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) != VK_SUCCESS)
+	if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &depthReducePipeline) != VK_SUCCESS)
 	{
-		throw runtime_error("failed to allocate descriptor sets!");
+		throw runtime_error("failed to create depth reduce pipeline!");
 	}
 
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = uniformBuffers[i];
-		bufferInfo.offset = 0;
-		bufferInfo.range = sizeof(UniformBufferObject);
-
-		VkDescriptorImageInfo imageInfo{};
-		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imageInfo.imageView = textureImageView;
-		imageInfo.sampler = textureSampler;
-
-		array<VkWriteDescriptorSet, 2> descriptorWrites{};
-		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[0].dstSet = descriptorSets[i];
-		descriptorWrites[0].dstBinding = 0;
-		descriptorWrites[0].dstArrayElement = 0;
-		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorWrites[0].descriptorCount = 1;
-		descriptorWrites[0].pBufferInfo = &bufferInfo;
+	vkDestroyShaderModule(device, compShaderModule, nullptr);
 
-		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[1].dstSet = descriptorSets[i];
-		descriptorWrites[1].dstBinding = 1;
-		descriptorWrites[1].dstArrayElement = 0;
-		descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		descriptorWrites[1].descriptorCount = 1;
-		descriptorWrites[1].pImageInfo = &imageInfo;
+	// texelFetchœǂނ̂ŃtB^͂Ȃ
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
 
-		vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+	if (vkCreateSampler(device, &samplerInfo, nullptr, &depthPyramidSampler) != VK_SUCCESS)
+	{
+		throw runtime_error("failed to create depth pyramid sampler!");
 	}
 }
 
-void Vulkan::createTextureImage()
+void Vulkan::createDepthPyramid()
 {
-	const char* fileName = "textures/texture.png";
-	int texWidth, texHeight, texChannels;
-	stbi_uc* pixels = stbi_load(fileName, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-	VkDeviceSize imageSize = texWidth * texHeight * 4;
-	if (!pixels)
+	// ʃTCYȉ2ׂ̂ɂƊex傤ǔɂȂ
+	depthPyramidWidth = 1;
+	depthPyramidHeight = 1;
+	while (depthPyramidWidth * 2 <= swapChainExtent.width) depthPyramidWidth *= 2;
+	while (depthPyramidHeight * 2 <= swapChainExtent.height) depthPyramidHeight *= 2;
+	depthPyramidLevels = 1;
+	while ((max(depthPyramidWidth, depthPyramidHeight) >> depthPyramidLevels) > 0) depthPyramidLevels++;
+
+	createImage(depthPyramidWidth, depthPyramidHeight, depthPyramidLevels, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		&depthPyramid, &depthPyramidMemory, MemoryCategory::RenderTarget, "depth pyramid");
+	depthPyramidView = createImageView(depthPyramid, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, 0, depthPyramidLevels);
+	depthPyramidMips.resize(depthPyramidLevels);
+	for (uint32_t i = 0; i < depthPyramidLevels; i++)
 	{
-		throw runtime_error("failed to load texture image!");
+		depthPyramidMips[i] = createImageView(depthPyramid, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, i, 1);
 	}
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-	createBuffer(imageSize, &stagingBuffer, &stagingBufferMemory, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-	void* data;
-	vkMapMemory(device, stagingBufferMemory, 0, imageSize, 0, &data);
-	memcpy(data, pixels, imageSize);
-	vkUnmapMemory(device, stagingBufferMemory);
-	stbi_image_free(pixels);
-	createImage(texWidth, texHeight, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &textureImage, &textureImageMemory);
-	transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-	copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-	transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	// ŏ̃t[̃R}hobt@Ŗ߂ (Œođ҂GPU̍ƂS҂ƂɂȂ)
+	depthPyramidNeedsClear = true;
 
-	vkDestroyBuffer(device, stagingBuffer, nullptr);
-	vkFreeMemory(device, stagingBufferMemory, nullptr);
-}
+	// xƂ̏kpfBXNv^Zbg
+	array<VkDescriptorPoolSize, 2> poolSizes{};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[0].descriptorCount = depthPyramidLevels;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	poolSizes[1].descriptorCount = depthPyramidLevels;
 
-void Vulkan::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, 
-	VkMemoryPropertyFlagBits properties, VkImage *image, VkDeviceMemory *imageMemory)
-{
-	VkImageCreateInfo imageInfo{};
-	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-	imageInfo.imageType = VK_IMAGE_TYPE_2D;
-	imageInfo.extent.width = width;
-	imageInfo.extent.height = height;
-	imageInfo.extent.depth = 1;
-	imageInfo.mipLevels = 1;
-	imageInfo.arrayLayers = 1;
-	imageInfo.format = format;
-	imageInfo.tiling = tiling;
-	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	imageInfo.usage = usage;
-	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-	//imageInfo.flags = 0;
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = depthPyramidLevels;
 
-	if (vkCreateImage(device, &imageInfo, nullptr, image) != VK_SUCCESS)
+	if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &depthPyramidDescriptorPool) != VK_SUCCESS)
 	{
-		throw std::runtime_error("failed to create image!");
+		throw runtime_error("failed to create depth pyramid descriptor pool!");
 	}
 
-	VkMemoryRequirements memRequirements;
-	vkGetImageMemoryRequirements(device, *image, &memRequirements);
+	vector<VkDescriptorSetLayout> layouts(depthPyramidLevels, depthReduceSetLayout);
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = depthPyramidDescriptorPool;
+	allocInfo.descriptorSetCount = depthPyramidLevels;
+	allocInfo.pSetLayouts = layouts.data();
 
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+	depthReduceSets.resize(depthPyramidLevels);
 
-	if (vkAllocateMemory(device, &allocInfo, nullptr, imageMemory) != VK_SUCCESS)
+	if (vkAllocateDescriptorSets(device, &allocInfo, depthReduceSets.data()) != VK_SUCCESS)
 	{
-		throw std::runtime_error("failed to allocate image memory!");
+		throw runtime_error("failed to allocate depth reduce descriptor sets!");
 	}
 
-	vkBindImageMemory(device, *image, *imageMemory, 0);
+	for (uint32_t i = 0; i < depthPyramidLevels; i++)
+	{
+		// x0͐[xobt@Aȍ~1̃xk
+		VkDescriptorImageInfo srcInfo{};
+		srcInfo.sampler = depthPyramidSampler;
+		srcInfo.imageView = i == 0 ? depthImageView : depthPyramidMips[i - 1];
+		srcInfo.imageLayout = i == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo dstInfo{};
+		dstInfo.imageView = depthPyramidMips[i];
+		dstInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		array<VkWriteDescriptorSet, 2> writes{};
+		writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[0].dstSet = depthReduceSets[i];
+		writes[0].dstBinding = 0;
+		writes[0].descriptorCount = 1;
+		writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo = &srcInfo;
+		writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[1].dstSet = depthReduceSets[i];
+		writes[1].dstBinding = 1;
+		writes[1].descriptorCount = 1;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[1].pImageInfo = &dstInfo;
+
+		vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	// JÕfBXNv^Zbg͎gĂt[̂ŁAet[̔ԂĂ珑
+	depthPyramidBindingStale.assign(framesInFlight, true);
 }
 
-VkImageView Vulkan::createImageView(VkImage image, VkFormat format)
+// GENERALňBŏ̃t[͉ՕȂ悤1.0(ŉ)Ŗ߂
+void Vulkan::recordDepthPyramidClear(VkCommandBuffer commandBuffer)
 {
-	VkImageView imageView;
-	VkImageViewCreateInfo imageViewInfo{};
-	imageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-	imageViewInfo.image = image;
-	imageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-	imageViewInfo.format = format;
-	imageViewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-	imageViewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-	imageViewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-	imageViewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-	imageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	imageViewInfo.subresourceRange.baseMipLevel = 0;
-	imageViewInfo.subresourceRange.levelCount = 1;
-	imageViewInfo.subresourceRange.baseArrayLayer = 0;
-	imageViewInfo.subresourceRange.layerCount = 1;
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = depthPyramid;
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, depthPyramidLevels, 0, 1 };
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+		0, nullptr, 0, nullptr, 1, &barrier);
+
+	VkClearColorValue clearColor = { { 1.0f, 1.0f, 1.0f, 1.0f } };
+	vkCmdClearColorImage(commandBuffer, depthPyramid, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &barrier.subresourceRange);
+
+	barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+		0, nullptr, 0, nullptr, 1, &barrier);
+}
 
-	if (vkCreateImageView(device, &imageViewInfo, nullptr, &imageView) != VK_SUCCESS)
+// framẽR}hobt@GPUŏIɌĂ
+void Vulkan::updateDepthPyramidBinding(uint32_t frame)
+{
+	if (!depthPyramidBindingStale[frame])
 	{
-		throw std::runtime_error("failed to create texture image view!");
+		return;
 	}
 
-	return imageView;
-}
-
-void::Vulkan::createTextureImageView()
-{
-	textureImageView = createImageView(textureImage, VK_FORMAT_R8G8B8A8_SRGB);
+	VkDescriptorImageInfo pyramidInfo{};
+	pyramidInfo.sampler = depthPyramidSampler;
+	pyramidInfo.imageView = depthPyramidView;
+	pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = cullDescriptorSets[frame];
+	write.dstBinding = 6;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &pyramidInfo;
+
+	vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+	depthPyramidBindingStale[frame] = false;
 }
 
-void Vulkan::createTextureSampler()
+// [x̃TvOpւ̑JڂƁAOJOE㔼JOƂ̓̓t[Ots
+void Vulkan::recordDepthPyramid(VkCommandBuffer commandBuffer)
 {
-	VkPhysicalDeviceProperties properties{};
-	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, depthReducePipeline);
 
-	VkSamplerCreateInfo samplerInfo{};
-	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-	samplerInfo.magFilter = VK_FILTER_LINEAR;
-	samplerInfo.minFilter = VK_FILTER_LINEAR;
-	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	samplerInfo.anisotropyEnable = VK_TRUE;
-	samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
-	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-	samplerInfo.unnormalizedCoordinates = VK_FALSE;
-	samplerInfo.compareEnable = VK_FALSE;
-	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-	samplerInfo.mipLodBias = 0.0f;
-	samplerInfo.minLod = 0.0f;
-	samplerInfo.maxLod = 0.0f;
+	VkMemoryBarrier levelBarrier{};
+	levelBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-	if (vkCreateSampler(device, &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS)
+	for (uint32_t i = 0; i < depthPyramidLevels; i++)
 	{
-		throw runtime_error("failed to create texture sampler!");
+		uint32_t levelWidth = max(depthPyramidWidth >> i, 1u);
+		uint32_t levelHeight = max(depthPyramidHeight >> i, 1u);
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, depthReducePipelineLayout, 0, 1, &depthReduceSets[i], 0, nullptr);
+		vkCmdDispatch(commandBuffer, (levelWidth + 7) / 8, (levelHeight + 7) / 8, 1);
+
+		// ̃xǂ
+		if (i + 1 < depthPyramidLevels)
+		{
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+				1, &levelBarrier, 0, nullptr, 0, nullptr);
+		}
 	}
 }
 
@@ -1129,7 +4794,8 @@ bool Vulkan::checkValidationLayerSupport()
 	return true;
 }
 
-bool Vulkan::isDeviceSuitable(VkPhysicalDevice physDev)
+// gȂpReasonɗR
+bool Vulkan::isDeviceSuitable(VkPhysicalDevice physDev, string* pReason)
 {
 	// GPU̓K`FbN
 	VkPhysicalDeviceProperties properties{};
@@ -1144,15 +4810,29 @@ bool Vulkan::isDeviceSuitable(VkPhysicalDevice physDev)
 	bool extensionSupported = checkDeviceExtensionSupport(physDev);
 
 	// Xbv`FC̃T|[g\
-	bool swapChainAdequate = false;
-	if (extensionSupported) // Xbv`FCKHRłgł邩
+	bool swapChainAdequate = headless;
+	if (extensionSupported && !headless) // Xbv`FCKHRłgł邩
 	{
 		SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physDev);
 		swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
 	}
 
 	// eK̘_ςԂ
-	return indices.isComplete() && extensionSupported && swapChainAdequate && features.samplerAnisotropy;
+	const pair<bool, const char*> checks[] = {
+		{ indices.isComplete(), "no graphics/present queue" },
+		{ extensionSupported, "missing device extensions" },
+		{ swapChainAdequate, "no swapchain formats or present modes" },
+		{ features.samplerAnisotropy == VK_TRUE, "no samplerAnisotropy" },
+		{ features.drawIndirectFirstInstance == VK_TRUE, "no drawIndirectFirstInstance" },
+	};
+	for (const auto& check : checks)
+	{
+		if (!check.first)
+		{
+			*pReason += (pReason->empty() ? "" : ", ") + string(check.second);
+		}
+	}
+	return pReason->empty();
 }
 
 // ̃L[t@~CfbNX̍\̂Ԃ
@@ -1169,17 +4849,33 @@ QueueFamilyIndices Vulkan::findQueueFamiles(VkPhysicalDevice physDev)
 		vkGetPhysicalDeviceQueueFamilyProperties(physDev, &count, queueFamilyProps.data());
 	}
 
+	// OtBbNX̓v[głt@~D悵 (1̃L[ōς)AȂ΍ŏ̂
+	// Rs[g̓OtBbNXȂŏ̃t@~ (񓯊Rs[gp)
 	for (uint32_t i = 0; i < uint32_t(queueFamilyProps.size()); i++)
 	{
-		// iԖڂ̃L[t@~CfbNXOtBbNL[
-		if (queueFamilyProps[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) indices.graphicsFamily = i;
+		VkQueueFlags flags = queueFamilyProps[i].queueFlags;
+		bool graphics = (flags & VK_QUEUE_GRAPHICS_BIT) != 0;
 
-		// iԖڂ̃L[t@~CfbNXC[W邩
+		// iԖڂ̃L[t@~CfbNXC[W邩 (wbhXȂOtBbNL[ōς܂)
 		VkBool32 presentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(physDev, i, surface, &presentSupport);
-		if (presentSupport) indices.presentFamily = i;
+		if (headless)
+		{
+			presentSupport = graphics;
+		}
+		else
+		{
+			vkGetPhysicalDeviceSurfaceSupportKHR(physDev, i, surface, &presentSupport);
+		}
 
-		if (indices.isComplete()) break;
+		bool sharedFound = indices.isComplete() && indices.graphicsFamily == indices.presentFamily;
+		if (graphics && presentSupport && !sharedFound)
+		{
+			indices.graphicsFamily = i;
+			indices.presentFamily = i;
+		}
+		if (graphics && !indices.graphicsFamily.has_value()) indices.graphicsFamily = i;
+		if (presentSupport && !indices.presentFamily.has_value()) indices.presentFamily = i;
+		if ((flags & VK_QUEUE_COMPUTE_BIT) && !graphics && !indices.computeFamily.has_value()) indices.computeFamily = i;
 	}
 
 	return indices;
@@ -1253,11 +4949,12 @@ VkSurfaceFormatKHR Vulkan::chooseSwapSurfaceFormat(const vector<VkSurfaceFormatK
 	return availableFormats[0];
 }
 
+// ݒ̃[hȂΕKgFIFOɂ
 VkPresentModeKHR Vulkan::chooseSwapPresentMode(const vector<VkPresentModeKHR>& availablePresentModes)
 {
 	for (const auto& a : availablePresentModes)
 	{
-		if (a == VK_PRESENT_MODE_MAILBOX_KHR)
+		if (a == presentSettings.presentMode)
 		{
 			return a;
 		}
@@ -1289,13 +4986,21 @@ VkExtent2D Vulkan::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities
 	}
 }
 
-void Vulkan::createBuffer(size_t size, VkBuffer* pBuffer, VkDeviceMemory* pDeviceMemory, VkBufferUsageFlags usage, VkMemoryPropertyFlags props)
+void Vulkan::createBuffer(size_t size, VkBuffer* pBuffer, VkDeviceMemory* pDeviceMemory, VkBufferUsageFlags usage, VkMemoryPropertyFlags props,
+	MemoryCategory category, const char* name)
 {
 	VkBufferCreateInfo bufferInfo{};
 	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	bufferInfo.size = size;
 	bufferInfo.usage = usage;
 	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	// 񓯊Rs[g̎̓L[t@~Ԃ̏L̈ړȂɋLɂ (obt@ł͑͂قڕςȂ)
+	if (!sharedQueueFamilies.empty())
+	{
+		bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(sharedQueueFamilies.size());
+		bufferInfo.pQueueFamilyIndices = sharedQueueFamilies.data();
+	}
 
 	if (vkCreateBuffer(device, &bufferInfo, nullptr, pBuffer) != VK_SUCCESS)
 	{
@@ -1309,10 +5014,7 @@ void Vulkan::createBuffer(size_t size, VkBuffer* pBuffer, VkDeviceMemory* pDevic
 	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 	allocInfo.allocationSize = memReq.size;
 	allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, props);
-	if (vkAllocateMemory(device, &allocInfo, nullptr, pDeviceMemory) != VK_SUCCESS)
-	{
-		throw runtime_error("failed to allocate vertex buffer memory!");
-	}
+	allocateMemory(allocInfo, category, name, pDeviceMemory);
 
 	vkBindBufferMemory(device, *pBuffer, *pDeviceMemory, 0);
 }
@@ -1402,9 +5104,14 @@ void Vulkan::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout
 
 void Vulkan::updateUniformBuffer(uint32_t currentImage)
 {
+	PROFILE_ZONE("updateUniformBuffer");
 	static auto startTime = chrono::high_resolution_clock::now();
 	auto currentTime = chrono::high_resolution_clock::now();
 	float time = chrono::duration<float, chrono::seconds::period>(currentTime - startTime).count();
+	if (headless)
+	{
+		time = static_cast<float>(frameNumber * benchmarkSettings.frameTime); // ܂v
+	}
 	UniformBufferObject ubo{};
 	ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 	ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
@@ -2,11 +2,15 @@
 
 #define NOMINMAX // windows.hmin max}N̖
 //#include <vulkan/vulkan.h>
+#ifdef _WIN32
 #define VK_USE_PLATFORM_WIN32_KHR
+#endif
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#ifdef _WIN32
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include <GLFW/glfw3native.h>
+#endif
 #include <iostream>
 #include <stdexcept>
 #include <cstdlib>
@@ -20,10 +24,18 @@
 #include <fstream>
 #include <string>
 #define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE // Vulkan̐[x͈ 0..1
+#define GLM_ENABLE_EXPERIMENTAL // glm/gtx/hash.hpp
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/hash.hpp>
+#include <glm/gtc/packing.hpp>
 #include <array>
 #include <chrono>
+#include <unordered_map>
+#include <deque>
+#include <functional>
+#include <thread>
 
 #pragma comment(lib, "vulkan-1.lib")
 
@@ -37,12 +49,193 @@ using namespace std;
 
 const uint32_t WIDTH = 800;
 const uint32_t HEIGHT = 600;
-const uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+const uint32_t MAX_FRAMES_IN_FLIGHT = 2; // lBsPresentSettingsŕς
+const uint32_t SCENE_GRID_SIZE = 32; // V[ɕׂIuWFNg = SCENE_GRID_SIZE^2
+const uint32_t MAX_MESH_LODS = 4;
+const float LOD_PIXEL_THRESHOLD = 64.0f; // eaLOD1i
+const float LOD_HYSTERESIS = 0.15f; // LOD̐؂ւ̕s (log2(ea)̒P)
+const float LOD_REDUCTION = 0.5f; // LODƂ̎Op`̔
+const float LOD_TARGET_ERROR = 0.02f; // ȗŋ덷 (bV̑傫ɑ΂)
+const bool enableOcclusionCulling = true;
+const string MODEL_PATH = ""; // .obj / .glb Ȃgݍ݂̎lp`g
+const bool enableMeshCache = true; // ϊς݂̃bV MODEL_PATH + ".meshcache" ɕۑA񂩂ǂ
+enum class VertexFormat
+{
+	Float, // Vertex̂܂ܑ (32 bytes)
+	Half, // ʒuhalf (16 bytes)
+	Snorm16, // ʒubV͈̔͂ŐKsnorm16 (16 bytes)
+};
+
+const VertexFormat VERTEX_FORMAT = VertexFormat::Snorm16;
+const bool enableMeshOptimization = true; // ǂݍ񂾃bV𒸓_LbVEI[o[h[E_tFb`ɕבւ
+const bool enableClusterCulling = true; // LOD0ŕ`IuWFNgbVbgPʂŃJO
+const uint32_t MAX_CLUSTER_DRAWS = 65536; // 1pX̃bVbg`̏Bꂽ̓IuWFNgPʂŕ`
+const uint32_t RESIZE_SETTLE_MS = 50; // TCYύXĂԂ͍蒼Aꂾ~܂Ă蒼 (OUT_OF_DATEȂ瑦)
+const bool enableTimelineSemaphore = true; // VK_KHR_timeline_semaphore΃t[̓Ɏg (Ȃ΃tFXœlǂ)
+const bool enableAsyncCompute = true; // ʂ̃Rs[gL[Ύ̃t[̃JO`ƕsɎs (^CCZ}tHKv)
+const bool enableDynamicRendering = true; // VK_KHR_dynamic_renderingVkRenderPass/VkFramebuffer炸ɕ` (Ȃ΍܂Œʂ背_[pXŕ`)
+const uint32_t GEOMETRY_ARENA_VERTICES = 1 << 20; // SbVŋL钸_ECfbNXobt@̏e (ȂΔ{XɍL)
+const uint32_t GEOMETRY_ARENA_INDICES = 1 << 22;
+const bool enableModelReload = true; // \Ƀf̃t@CςǂݒAA[ǐÂbVƒu
+const char* const DEVICE_OVERRIDE_ENV = "VULKAN_TUTORIAL_DEVICE";
+const bool enableParallelInit = true; // falseȂ珉̒iK1XbhŏɎs (Ԃ̔rp)
+const uint32_t INIT_MAX_THREADS = 8;
+const bool enableGpuProfiler = true; // Ot̋Ԃ̑OɃ^CX^vAt[ɓǂ
+const uint32_t GPU_PROFILER_MAX_SCOPES = 32; // 1t[BԂ͑Ȃ
+const bool enablePipelineStatistics = true; // pipelineStatisticsQueryΕ`pXƂ̒_Ev~eBuEtOg𐔂
+const uint32_t PIPELINE_STATS_MAX_PASSES = 8; // 1t[
+const VkQueryPipelineStatisticFlags pipelineStatisticsFlags =
+	VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+const uint32_t PROFILER_HISTORY = 256; // min/avg/p99o߂̃Tv
+const size_t PROFILER_MAX_TRACE_EVENTS = 1 << 20; // g[XɎcCxg̏ (Â̂̂Ă)
+
+// sɑIԕ\̐ݒBX[vbg肩x肩zu悲ƂɌ߂
+struct PresentSettings
+{
+	VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR; // gȂFIFO
+	uint32_t framesInFlight = MAX_FRAMES_IN_FLIGHT; // CPUsłt[
+	uint32_t swapchainImages = 0; // 0ȂminImageCount + 1
+	double targetFps = 0.0; // t[[g̏B0Ȃ琧ȂAȂ烂j^̃tbV[g
+	bool lowLatency = false; // Õt[\܂Ŏ̃t[̓͂ǂ܂Ȃ
+};
+
+// jx点IuWFNg̎
+enum class DeferredObject
+{
+	Buffer,
+	Memory,
+	Image,
+	ImageView,
+	Sampler,
+	Framebuffer,
+	Pipeline,
+	PipelineLayout,
+	DescriptorPool,
+	QueryPool,
+	SwapChain,
+};
+
+// timelineValue܂łGPU̍ƂIΔjł
+struct DeferredDestroy
+{
+	uint64_t timelineValue;
+	DeferredObject type;
+	uint64_t handle; // fBXpb`nh (32bitłuint64_t)
+};
+
+// g[X1 (Chrome trace  "X" Cxg)
+struct ProfileEvent
+{
+	const char* name; // 񃊃e
+	uint64_t frame;
+	double startUs; // profileClockUs()̎Ԏ
+	double durationUs;
+	uint32_t track; // Chrome tracetid
+};
+
+// ԂƂ̒߂̃Tv (ms)
+struct ProfileScopeStats
+{
+	const char* name;
+	deque<double> samples;
+};
+
+// 1t[̒̋ԁBbegin2*indexAend2*index+1Ԗڂ̃NG
+struct GpuScope
+{
+	const char* name;
+	bool ended;
+	uint32_t track; // PROFILE_TRACK_GPU  PROFILE_TRACK_GPU_COMPUTE
+};
+
+// VK_QUERY_TYPE_PIPELINE_STATISTICŠʁBт̓tÕrbg (pipelineStatisticsFlagsƍ킹)
+struct PipelineStatistics
+{
+	uint64_t inputVertices; // INPUT_ASSEMBLY_VERTICES
+	uint64_t inputPrimitives; // INPUT_ASSEMBLY_PRIMITIVES
+	uint64_t vertexInvocations; // VERTEX_SHADER_INVOCATIONS (inputVertices菭ȂΒ_LbVĂ)
+	uint64_t clippingPrimitives; // CLIPPING_PRIMITIVES (NbvɃX^CY֓nv~eBu)
+	uint64_t fragmentInvocations; // FRAGMENT_SHADER_INVOCATIONS (fŊƃI[o[h[̖ڈ)
+};
+
+// `pXƂ̍vBwindowreportStats̊ԊuAtotal͋NBpXname̒gŌ
+struct PipelineStatsPass
+{
+	const char* name;
+	PipelineStatistics window;
+	uint64_t windowFrames;
+	PipelineStatistics total;
+	uint64_t totalFrames;
+};
+
+// EBhE炸AItXN[̃J[摜Ɍ܂̃t[`Čv
+struct BenchmarkSettings
+{
+	bool headless = false;
+	uint32_t frames = 1000; // vt[
+	uint32_t warmupFrames = 30; // vOɎ̂Ăt[
+	uint32_t width = WIDTH;
+	uint32_t height = HEIGHT;
+	double frameTime = 1.0 / 60.0; // V[̎v1t[Ői߂b (ԂɈ˂炸񓯂GɂȂ)
+	string statsPath; // ʂJSONBȂWo
+	bool readback = false; // 󂯎薳Ŗt[ǂݖ߂ (Rs[ƕבւׂ̕𑪂)
+};
+
+// ǂݖ߂1t[BpRgba̓R[obN̊ԂL (width * height * 4oCgAs̋lߕȂ)
+struct ReadbackFrame
+{
+	uint64_t frame;
+	uint32_t width;
+	uint32_t height;
+	const uint8_t* pRgba;
+};
+
+// g[X̏o͐Ɣ͈ (t[ԍA[܂)
+struct ProfilerSettings
+{
+	string tracePath; // Ȃ珑Ȃ
+	uint64_t firstFrame = 0;
+	uint64_t lastFrame = numeric_limits<uint64_t>::max();
+	string memoryReportPath; // IGPȔWv (JSON)BȂ珑Ȃ
+};
+
+// foCX̗prB蓖ĂƂ1t
+enum class MemoryCategory
+{
+	Vertex,
+	Index,
+	Uniform,
+	Storage, // JOV[̕\ȂǃVF[_ǂݏobt@
+	Texture,
+	Staging, // CPUƂ̎󂯓n (Abv[hƓǂݖ߂)
+	RenderTarget, // [xAHi-ZAItXN[̃J[
+	Count,
+};
+
+struct MemoryAllocation
+{
+	MemoryCategory category;
+	const char* name; // 񃊃e
+	VkDeviceSize size;
+	uint32_t heap;
+};
+
+struct MemoryUsage
+{
+	VkDeviceSize currentBytes;
+	VkDeviceSize peakBytes;
+	uint32_t allocationCount; // Ă銄蓖Ă̐
+};
 
 struct QueueFamilyIndices
 {
 	optional<uint32_t> graphicsFamily;
 	optional<uint32_t> presentFamily;
+	optional<uint32_t> computeFamily; // OtBbNXȂRs[g̃t@~ (񓯊Rs[gpBĂ)
 
 	bool isComplete()
 	{
@@ -60,10 +253,15 @@ struct SwapChainSupportDetails
 
 struct Vertex
 {
-	glm::vec2 pos;
+	glm::vec3 pos;
 	glm::vec3 color;
 	glm::vec2 texCoord;
 
+	bool operator==(const Vertex& other) const
+	{
+		return pos == other.pos && color == other.color && texCoord == other.texCoord;
+	}
+
 	static VkVertexInputBindingDescription getBindingDescription()
 	{
 		VkVertexInputBindingDescription bindingDescription{};
@@ -79,7 +277,7 @@ struct Vertex
 		array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
 		attributeDescriptions[0].binding = 0;
 		attributeDescriptions[0].location = 0;
-		attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+		attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
 		attributeDescriptions[0].offset = offsetof(Vertex, pos);
 		attributeDescriptions[1].binding = 0;
 		attributeDescriptions[1].location = 1;
@@ -94,6 +292,56 @@ struct Vertex
 	}
 };
 
+// GPUɑ鈳k_BFRGBA8AUVunorm16Ȃ̂[0,1]̊O͐؂l߂
+struct PackedVertex
+{
+	uint16_t pos[4]; // half/snorm16 (w3vftH[}bgK{łȂ߂̋lߕ)
+	uint8_t color[4];
+	uint16_t texCoord[2];
+
+	static VkVertexInputBindingDescription getBindingDescription()
+	{
+		VkVertexInputBindingDescription bindingDescription{};
+		bindingDescription.binding = 0;
+		bindingDescription.stride = sizeof(PackedVertex);
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return bindingDescription;
+	}
+
+	static array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions(VertexFormat format)
+	{
+		array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
+		attributeDescriptions[0].binding = 0;
+		attributeDescriptions[0].location = 0;
+		attributeDescriptions[0].format = format == VertexFormat::Half ? VK_FORMAT_R16G16B16A16_SFLOAT : VK_FORMAT_R16G16B16A16_SNORM;
+		attributeDescriptions[0].offset = offsetof(PackedVertex, pos);
+		attributeDescriptions[1].binding = 0;
+		attributeDescriptions[1].location = 1;
+		attributeDescriptions[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+		attributeDescriptions[1].offset = offsetof(PackedVertex, color);
+		attributeDescriptions[2].binding = 0;
+		attributeDescriptions[2].location = 2;
+		attributeDescriptions[2].format = VK_FORMAT_R16G16_UNORM;
+		attributeDescriptions[2].offset = offsetof(PackedVertex, texCoord);
+
+		return attributeDescriptions;
+	}
+};
+
+// _̏dɎg
+namespace std
+{
+	template<> struct hash<Vertex>
+	{
+		size_t operator()(Vertex const& vertex) const
+		{
+			return ((hash<glm::vec3>()(vertex.pos) ^ (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^
+				(hash<glm::vec2>()(vertex.texCoord) << 1);
+		}
+	};
+}
+
 struct UniformBufferObject
 {
 	alignas(16)glm::mat4 model;//explicit multiple of 16 p183
@@ -101,14 +349,217 @@ struct UniformBufferObject
 	alignas(16)glm::mat4 proj;
 };
 
+// ȉstd430ŃVF[_[ƋL
+struct ObjectData
+{
+	glm::mat4 model;
+	glm::vec4 boundingSphere; // xyz:[JS w:a
+	uint32_t meshIndex;
+	uint32_t padding[3];
+};
+
+struct MeshData
+{
+	uint32_t firstDraw; // ̃bVLOD0̕`Xbg
+	uint32_t lodCount;
+	uint32_t firstMeshlet; // LOD0̃bVbg
+	uint32_t meshletCount;
+	int32_t vertexOffset; // WIgA[i̐擪_
+	uint32_t padding[3];
+};
+
+struct MeshletData
+{
+	glm::vec4 boundingSphere; // xyz:[JS w:a
+	glm::vec4 coneApex; // xyz:[Jʒu
+	glm::vec4 coneAxis; // xyz: w:cutoff
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	uint32_t padding[2];
+};
+
+// WIgA[i̋󂫗̈ (vfP)
+struct GeometryRange
+{
+	uint64_t offset;
+	uint64_t size;
+};
+
+// WIgA[i1bV̈ʒu (vfP)BkƓ
+struct GeometryAllocation
+{
+	uint32_t vertexOffset;
+	uint32_t vertexCount;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	bool live;
+};
+
+// pXƂ̃bVbgJO̊ԐڃfBXpb`ƃJE^
+struct ClusterCullState
+{
+	uint32_t groupCountX; // bVbgPʂŕ`IuWFNg
+	uint32_t groupCountY;
+	uint32_t groupCountZ;
+	uint32_t reservedDraws; // IuWFNg̃JOŊmۂ`搔 (bVbg̍v)
+	uint32_t drawCount; // ۂɏo͂`搔
+	uint32_t padding[3];
+};
+
+struct CullingStats
+{
+	uint32_t visibleCount;
+	uint32_t frustumCulledCount;
+	uint32_t occlusionCulledCount;
+	uint32_t disoccludedCount; // 㔼pXŐVɌ
+	uint32_t lodVisibleCount[MAX_MESH_LODS];
+	uint32_t submittedTriangles; // ILODŕ`Op`
+	uint32_t fullDetailTriangles; // SLOD0ŕ`ꍇ̎Op`
+	uint32_t clusterObjectCount; // bVbgPʂŕ`IuWFNg
+	uint32_t meshletVisibleCount;
+	uint32_t meshletFrustumCulledCount;
+	uint32_t meshletBackfaceCulledCount;
+};
+
+struct CullPushConstants
+{
+	uint32_t objectCount;
+	uint32_t drawCapacity; // `Xbg1̃CX^X
+	float lodPixelThreshold;
+	float viewportHeight;
+	uint32_t pass; // 0:Ot[Hi-ZŔ 1:Օꂽ̂t[Hi-ZōĔ
+	uint32_t drawOffset;
+	uint32_t occlusionEnabled;
+	float lodHysteresis;
+	uint32_t clusterDrawCapacity; // 0Ȃ烁bVbgJOgȂ
+	uint32_t clusterInstanceBase; // visibleInstances̃bVbg`p̗̈
+};
+
+// 1̃CfbNXobt@ɕׂLOD͈̔ (_͋L)
+struct MeshLod
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float error;
+};
+
+// _[Ot (render_graph.hpp)BpXg\[XƃANZX錾ƁApXԂ̃oAƃCAEgJڂ܂Ƃ߂ċ߂
+enum class RenderGraphAccess
+{
+	None, // gvȂ (UNDEFINED)Bo͂Ɏw肵͑JڂɎc
+	Acquire, // Xbv`F[擾 (擾̃Z}tHCOLOR_ATTACHMENT_OUTPUTő҂)
+	IndirectRead,
+	VertexRead, // _VF[_[̃Xg[Wobt@
+	ComputeRead, // C[WGENERAL
+	ComputeWrite,
+	ComputeReadWrite,
+	ComputeSampled, // SHADER_READ_ONLY_OPTIMAL
+	ColorAttachment,
+	DepthAttachment,
+	TransferRead,
+	TransferWrite,
+	HostRead,
+	Present,
+};
+
+struct RenderGraphUse
+{
+	uint32_t resource;
+	RenderGraphAccess access;
+};
+
+struct RenderGraphResource
+{
+	const char* name;
+	bool image;
+	bool transient; // Ot蓖ĂC[WB̏dȂȂ͓̂g
+	VkImageCreateInfo imageInfo; // transient̂
+	VkImageAspectFlags aspect;
+	RenderGraphAccess previous; // t[̎n߂̏ (Õt[̍Ō̃ANZX)
+	bool output; // o (ɌȂpX͏)
+	RenderGraphAccess finalAccess; // o͂t[̏IɈڂANZX
+	VkImage handle; // 荞񂾃C[W͋L^̑Oɖt[ݒ肷
+
+	// compileRenderGraphŖ܂
+	uint32_t firstPass; // gpX͈̔́BgȂUINT32_MAX
+	uint32_t lastPass;
+	VkPipelineStageFlags endStages; // t[̍Ō̃ANZX (̃t[⓯g̃C[W҂)
+	VkAccessFlags endAccess;
+};
+
+struct RenderGraphImageTransition
+{
+	uint32_t resource;
+	VkAccessFlags srcAccess;
+	VkAccessFlags dstAccess;
+	VkImageLayout oldLayout;
+	VkImageLayout newLayout;
+};
+
+// 1vkCmdPipelineBarrierBobt@ƃCAEg̕ςȂC[W1̃oAɂ܂Ƃ߂
+struct RenderGraphBarrier
+{
+	VkPipelineStageFlags srcStages;
+	VkPipelineStageFlags dstStages; // 0ȂoA͗vȂ
+	VkAccessFlags srcAccess;
+	VkAccessFlags dstAccess;
+	vector<RenderGraphImageTransition> images;
+};
+
+struct RenderGraphPass
+{
+	const char* name;
+	vector<RenderGraphUse> uses; // \[X1񂾂 (ǂݏȂReadWritẽANZX)
+	function<void(VkCommandBuffer)> record;
+	bool culled; // compileRenderGraphŖ܂
+	RenderGraphBarrier barrier; // pX̑OɋL^
+};
+
+struct RenderGraph
+{
+	vector<RenderGraphResource> resources;
+	vector<RenderGraphPass> passes; // 錾Ɏs
+	RenderGraphBarrier finalBarrier; // o͂finalAccessɈڂ
+	vector<VkDeviceMemory> transientMemory;
+	VkDeviceSize transientBytes = 0; // ꎞC[WʁXɒuꍇ̍v
+	VkDeviceSize transientAllocatedBytes = 0;
+	uint32_t culledPasses = 0;
+	uint32_t barrierCount = 0;
+	uint32_t imageTransitionCount = 0;
+};
+
+struct TaskGraphNode; // task_graph.hpp
+struct TaskGraphStats;
+
 class Vulkan
 {
 public:
 	void run();
+	void convertMesh(const string& sourcePath); // LbV邾
+	void benchmarkMeshCache(const string& sourcePath);
+	void setPresentSettings(const PresentSettings& settings);
+	// gGPU̔ԍÖꕔBȂϐDEVICE_OVERRIDE_ENVAΓ_̈ԍ
+	void setDeviceOverride(const string& device);
+	// ǂݍ .obj / .glbBȂgݍ݂̎lp` ( MODEL_PATH)
+	void setModelPath(const string& path);
+	void setProfilerSettings(const ProfilerSettings& settings);
+	// prʁEq[vʂ݂̌ƍő̃oCgAĂ銄蓖Ă̈ꗗJSONŏ (foCXԂł)
+	void writeMemoryReport(ostream& out) const;
+	void setBenchmarkSettings(const BenchmarkSettings& settings);
+	// `摜𖈃t[ǂݖ߂At[(̃t[GPU̍ƂI)ɃCXbhœn
+	void setReadbackCallback(function<void(const ReadbackFrame&)> callback);
 private:
 	void initWindow(const char* title);
 	void initVulkan();
+	void reportInitTimings(const vector<TaskGraphNode>& steps, const TaskGraphStats& stats);
 	void mainLoop();
+	void benchmarkLoop();
+	void finishFrames();
+	void writeBenchmarkResults(const vector<double>& frameTimesMs, double seconds);
+	void createOffscreenImages();
+	void createReadbackBuffers();
+	void recordReadback(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+	void deliverReadback(uint32_t frame);
 	void cleanup();
 	void cleanupSwapChain();
 
@@ -125,31 +576,106 @@ private:
 	void createCommandPool(VkCommandPool *pCommandPool, uint32_t queueIndex);
 	void createCommandBuffer();
 	void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+	void recordAsyncCompute(VkCommandBuffer commandBuffer);
+	void submitAsyncCompute();
 	void drawFrame();
 	void createSyncObjects();
+	void createFrameTimeline();
+	void paceFrame();
+	void measureFrameLatency(uint32_t frame);
+	void addLatencySample(double ms);
+	uint64_t submitTimeline(VkQueue queue, const VkSubmitInfo& submitInfo, const uint64_t* pWaitValues, VkFence fence);
+	uint64_t pollTimeline();
+	bool isTimelineValueComplete(uint64_t value);
+	void waitTimelineValue(uint64_t value);
 	void recreateSwapChain();
-	void createBuffer(size_t size, VkBuffer *pBuffer, VkDeviceMemory *pDeviceMemory, VkBufferUsageFlags usage, VkMemoryPropertyFlags props);
+	// ܂łɒoƂIĂjBVK_NULL_HANDLE͖
+	template<typename T>
+	void destroyLater(DeferredObject type, T handle)
+	{
+		if (handle != VK_NULL_HANDLE)
+		{
+			deferredDestroys.push_back({ submittedTimelineValue, type, (uint64_t)handle });
+		}
+	}
+	void destroyDeferredObject(const DeferredDestroy& object);
+	void collectDeferredDestroys();
+	void flushDeferredDestroys();
+	void createBuffer(size_t size, VkBuffer *pBuffer, VkDeviceMemory *pDeviceMemory, VkBufferUsageFlags usage, VkMemoryPropertyFlags props,
+		MemoryCategory category, const char* name);
+	void allocateMemory(const VkMemoryAllocateInfo& allocInfo, MemoryCategory category, const char* name, VkDeviceMemory* pMemory);
+	void freeMemory(VkDeviceMemory memory);
+	void reportLeakedMemory();
 	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, size_t size);
-	void createVertexBuffer(void *pData, size_t size);
-	void createIndexBuffer(void *pData, size_t size);
+	void createMeshBuffers();
+	void packMesh(vector<uint8_t>* pVertexData, vector<uint8_t>* pIndexData);
+	bool probeMeshCache();
+	bool loadMeshCache();
+	void writeModelCache(const vector<uint8_t>& vertexData, const vector<uint8_t>& indexData);
+	uint32_t uploadGeometry(const void* pVertices, uint32_t vertexCount, const void* pIndices, uint32_t indexCount, VkIndexType meshIndexType);
+	void freeGeometry(uint32_t allocation);
+	void compactGeometry();
+	void rebuildGeometryArena(uint32_t newVertexCapacity, uint32_t newIndexCapacity, VkIndexType newIndexType);
+	void widenGeometryIndices(VkBuffer newIndexBuffer, const vector<VkBufferCopy>& copies, uint32_t indexCount);
+	void relocateSceneGeometry(const vector<GeometryAllocation>& oldAllocations);
+	void updateDeviceLocalBuffer(VkBuffer buffer, const void* pData, size_t size);
 	void createUniformBuffers();
 	void createDescriptorSetLayout();
 	void updateUniformBuffer(uint32_t currentImage);
 	void createDescriptorPool();
 	void createDescriptorSets();
+	void loadTexturePixels();
 	void createTextureImage();
-	void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, 
-		VkMemoryPropertyFlagBits properties, VkImage *image, VkDeviceMemory *imageMemory);
+	void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, 
+		VkMemoryPropertyFlagBits properties, VkImage *image, VkDeviceMemory *imageMemory, MemoryCategory category, const char* name);
 	VkCommandBuffer beginSingleTimeCommands();
 	void endSingleTimeCommands(VkCommandBuffer commandBuffer);
 	void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
 	void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
-	VkImageView createImageView(VkImage image, VkFormat format);
+	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t baseMipLevel, uint32_t levelCount);
 	void createTextureImageView();
 	void createTextureSampler();
+	void createDeviceLocalBuffer(void *pData, size_t size, VkBufferUsageFlags usage, VkBuffer *pBuffer, VkDeviceMemory *pDeviceMemory,
+		MemoryCategory category, const char* name);
+	void loadModel();
+	void optimizeMesh();
+	void createMeshLods();
+	void createScene();
+	void createSceneBuffers();
+	void createCullingResources();
+	void destroySceneResources();
+	void checkModelReload();
+	void reloadModel();
+	void createCullingPipeline();
+	void recordCulling(VkCommandBuffer commandBuffer, uint32_t pass);
+	void recordClusterCulling(VkCommandBuffer commandBuffer, uint32_t pass);
+	void recordSceneDraw(VkCommandBuffer commandBuffer, uint32_t pass);
+	void buildFrameGraph();
+	void recordDrawPass(VkCommandBuffer commandBuffer, uint32_t pass);
+	void createDepthResources();
+	VkFormat findDepthFormat();
+	void createDepthPyramid();
+	void recordDepthPyramidClear(VkCommandBuffer commandBuffer);
+	void updateDepthPyramidBinding(uint32_t frame);
+	void createDepthReducePipeline();
+	void recordDepthPyramid(VkCommandBuffer commandBuffer);
+	void readCullingResults(uint32_t frame);
+	void createGpuProfiler();
+	void calibrateGpuClock();
+	uint32_t beginGpuScope(VkCommandBuffer commandBuffer, const char* name);
+	void endGpuScope(VkCommandBuffer commandBuffer, uint32_t scope);
+	void readGpuProfiler(uint32_t frame);
+	uint32_t beginPipelineStats(VkCommandBuffer commandBuffer, const char* name);
+	void endPipelineStats(VkCommandBuffer commandBuffer, uint32_t pass);
+	void readPipelineStats(uint32_t frame);
+	void collectCpuProfile();
+	void addTraceEvent(const ProfileEvent& event);
+	void writeTrace();
+	void reportStats();
 
 	bool checkValidationLayerSupport();
-	bool isDeviceSuitable(VkPhysicalDevice pDevice);
+	bool isDeviceSuitable(VkPhysicalDevice pDevice, string* pReason);
+	int64_t scorePhysicalDevice(VkPhysicalDevice pDevice, string* pReason);
 	bool checkDeviceExtensionSupport(VkPhysicalDevice pDevice);
 	static void framebufferResizeCallback(GLFWwindow *pWindow, int width, int height);
 	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -183,18 +709,52 @@ private:
 
 	GLFWwindow* window;
 	VkInstance instance;
-	VkPhysicalDevice physicalDevice;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkPhysicalDeviceMemoryProperties memoryProperties{}; // selectPhysicalDeviceňx
+	string deviceOverride;
 	VkDevice device;
 	VkQueue graphicsQueue;
 	VkQueue presentQueue;
 	VkQueue transferQueue;
-	VkSurfaceKHR surface;
-	VkSwapchainKHR swapChain;
+	// 񓯊Rs[g: t[ÑJO(O)t[N-1̌㔼̕`Əd˂
+	// vZL[: N-1Hi-Z܂ł҂ -> JO -> computeTimelineSemaphorei߂
+	// OtBbNX: JO҂ -> O̕`EHi-ZE㔼̃JO (hiZTimelineValue) -> 㔼̕`
+	bool asyncComputeEnabled = false;
+	uint32_t computeQueueFamily = 0;
+	VkQueue computeQueue = VK_NULL_HANDLE;
+	VkCommandPool computeCmdPool = VK_NULL_HANDLE;
+	vector<VkCommandBuffer> computeCommandBuffers;
+	vector<VkCommandBuffer> lateCommandBuffers; // 㔼̕` (Hi-ŽŒo𕪂)
+	VkSemaphore computeTimelineSemaphore = VK_NULL_HANDLE;
+	uint64_t computeTimelineValue = 0;
+	uint64_t hiZTimelineValue = 0; // ŌHi-Z܂ޒõ^CC̒l
+	vector<uint32_t> sharedQueueFamilies; // łȂ΃obt@ƏރC[WgSẴL[t@~ŋL (CONCURRENT)
+	bool computeTimestampsSupported = false;
+	VkSurfaceKHR surface = VK_NULL_HANDLE;
+	BenchmarkSettings benchmarkSettings;
+	bool headless = false; // Xbv`F[̑offscreenImagesMemorỷ摜ɕ`
+	vector<VkDeviceMemory> offscreenImagesMemory;
+
+	// ǂݖ߂ (t[Ƃ̃zXg猩obt@)
+	function<void(const ReadbackFrame&)> readbackCallback;
+	bool readbackEnabled = false;
+	bool readbackCached = false; // HOST_CACHED (Rq[głȂȂ̂œǂޑOinvalidate)
+	VkExtent2D readbackExtent{};
+	vector<VkBuffer> readbackBuffers;
+	vector<VkDeviceMemory> readbackBuffersMemory;
+	vector<void*> readbackBuffersMapped;
+	vector<uint64_t> readbackFrames; // ݑ҂̃t[ԍBUINT64_MAX
+	vector<uint8_t> readbackPixels;
+	uint64_t readbackCount = 0;
+	double readbackMsSum = 0.0; // invalidateƕבւƃR[obN
+	VkSwapchainKHR swapChain = VK_NULL_HANDLE;
+	chrono::steady_clock::time_point lastResizeEvent;
 	vector<VkImage> swapChainImages;
 	VkFormat swapChainImageFormat;
 	VkExtent2D swapChainExtent;
 	vector<VkImageView> swapChainImageViews;
-	VkRenderPass renderPass;
+	VkRenderPass renderPass = VK_NULL_HANDLE; // _Ci~bN_O͍̎Ȃ
+	VkRenderPass renderPassLoad = VK_NULL_HANDLE; // 㔼pXpBrenderPassƌ݊
 	VkPipelineLayout pipelineLayout;
 	VkPipeline pipeline;
 	vector<VkFramebuffer>swapChainFramebuffers;
@@ -203,24 +763,170 @@ private:
 	vector<VkCommandBuffer> commandBuffers;
 	vector<VkSemaphore> imageAvailableSemaphores;
 	vector<VkSemaphore> renderFinishedSemaphores;
-	vector<VkFence> inFlightFences;
+	vector<VkFence> inFlightFences; // ^CCZ}tHȂg
+	// GPU^CC: oƂ1lBlN܂ł̍ƂIǂł₢킹E҂Ă
+	bool physicalDeviceProperties2Supported = false; // VK_KHR_get_physical_device_properties2
+	bool timelineSemaphoreSupported = false;
+	VkSemaphore timelineSemaphore = VK_NULL_HANDLE;
+	PFN_vkGetSemaphoreCounterValueKHR pfnGetSemaphoreCounterValue = nullptr;
+	PFN_vkWaitSemaphoresKHR pfnWaitSemaphores = nullptr;
+	uint64_t submittedTimelineValue = 0; // Ōɒol
+	deque<DeferredDestroy> deferredDestroys; // timelineValuȅ
+	uint64_t completedTimelineValue = 0; // mFl
+	vector<uint64_t> frameTimelineValues; // t[XbgŌɒol
 	bool framebufferResized = false;
+	PresentSettings presentSettings;
+	uint32_t framesInFlight = MAX_FRAMES_IN_FLIGHT;
+	VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR; // ۂɎgĂ郂[h
+	// t[y[T[
+	bool presentWaitSupported = false; // VK_KHR_present_id + VK_KHR_present_wait
+	PFN_vkWaitForPresentKHR pfnWaitForPresent = nullptr;
+	uint64_t lastPresentId = 0;
+	vector<uint64_t> framePresentIds; // XbgŌɕ\present_id (0ȂsEvς)
+	chrono::steady_clock::time_point frameInputTime; // ̃t[͂ǂ񂾎
+	vector<chrono::steady_clock::time_point> frameInputTimes; // Xbg̃t[͂ǂ񂾎
+	chrono::steady_clock::time_point nextFrameTime;
+	double refreshInterval = 0.0; // b
+	double latencyMsSum = 0.0;
+	double latencyMsMax = 0.0;
+	uint32_t latencySamples = 0;
 	uint32_t currentFrame = 0;
-	VkBuffer vertexBuffer;
-	VkDeviceMemory vertexBufferMemory;
-	VkBuffer indexBuffer;
-	VkDeviceMemory indexBufferMemory;
+	// WIgA[i: SbV̒_ƃCfbNX1g̃obt@ɒuA`firstIndex/vertexOffsetőI
+	VkBuffer vertexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
+	VkBuffer indexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory indexBufferMemory = VK_NULL_HANDLE;
+	VkIndexType geometryIndexType = VK_INDEX_TYPE_UINT32; // ŏ̃bVŌ܂A32bit̃bVL
+	uint32_t vertexStride = 0;
+	uint32_t vertexCapacity = 0;
+	uint32_t indexCapacity = 0;
+	vector<GeometryRange> freeVertexRanges;
+	vector<GeometryRange> freeIndexRanges;
+	vector<GeometryAllocation> geometryAllocations;
+	vector<uint32_t> meshGeometry; // meshes[i] ̃AP[V
+	uint32_t modelGeometry = 0; // ǂݍ񂾃f̃AP[V
 	VkDescriptorSetLayout descriptorSetLayout;
 	vector<VkBuffer>uniformBuffers;
 	vector<VkDeviceMemory> uniformBuffersMemory;
 	vector<void*> uniformBuffersMapped;
 	VkDescriptorPool descriptorPool;
 	vector<VkDescriptorSet> descriptorSets;
+	unsigned char* pTexturePixels = nullptr; // loadTexturePixelscreateTextureImage܂
+	int textureWidth = 0;
+	int textureHeight = 0;
 	VkImage textureImage;
 	VkDeviceMemory textureImageMemory;
 	VkImageView textureImageView;
 	VkSampler textureSampler;
 
+	// GPUJO
+	vector<ObjectData> objects;
+	vector<MeshData> meshes;
+	vector<VkDrawIndexedIndirectCommand> drawTemplates; // instanceCount = 0 ̕`R}h̐`
+	VkBuffer objectBuffer;
+	VkDeviceMemory objectBufferMemory;
+	VkBuffer meshBuffer;
+	VkDeviceMemory meshBufferMemory;
+	VkBuffer objectLodBuffer; // IuWFNgƂ̑OLOD (qXeVXp)
+	VkDeviceMemory objectLodBufferMemory;
+	vector<MeshLod> meshLods;
+	vector<MeshletData> meshlets;
+	VkBuffer meshletBuffer;
+	VkDeviceMemory meshletBufferMemory;
+	uint32_t clusterDrawCapacity = 0;
+	vector<VkBuffer> clusterObjectBuffers; // bVbgPʂŕ`IuWFNg̈ꗗ
+	vector<VkDeviceMemory> clusterObjectBuffersMemory;
+	vector<VkBuffer> clusterStateBuffers;
+	vector<VkDeviceMemory> clusterStateBuffersMemory;
+	vector<VkBuffer> clusterDrawBuffers; // l߂ďo͂bVbg̕`R}h
+	vector<VkDeviceMemory> clusterDrawBuffersMemory;
+	VkBuffer drawTemplateBuffer;
+	VkDeviceMemory drawTemplateBufferMemory;
+	vector<VkBuffer> drawCommandBuffers;
+	vector<VkDeviceMemory> drawCommandBuffersMemory;
+	vector<VkBuffer> visibleBuffers;
+	vector<VkDeviceMemory> visibleBuffersMemory;
+	vector<VkBuffer> cullStatsBuffers;
+	vector<VkDeviceMemory> cullStatsBuffersMemory;
+	vector<void*> cullStatsBuffersMapped;
+	vector<VkBuffer> cullStateBuffers; // IuWFNgƂ̑OpX̔茋
+	vector<VkDeviceMemory> cullStateBuffersMemory;
+	vector<bool> cullResultsPending;
+	VkDescriptorSetLayout cullDescriptorSetLayout;
+	vector<VkDescriptorSet> cullDescriptorSets;
+	VkPipelineLayout cullPipelineLayout;
+	VkPipeline cullPipeline;
+	VkPipeline clusterCullPipeline; // cullPipelineLayoutL
+	bool multiDrawIndirectSupported = false;
+	bool drawIndirectCountSupported = false; // VK_KHR_draw_indirect_count
+	PFN_vkCmdDrawIndexedIndirectCountKHR pfnCmdDrawIndexedIndirectCount = nullptr;
+	bool dynamicRenderingSupported = false; // VK_KHR_dynamic_renderingBA^b`g͕`ɓn
+	PFN_vkCmdBeginRenderingKHR pfnCmdBeginRendering = nullptr;
+	PFN_vkCmdEndRenderingKHR pfnCmdEndRendering = nullptr;
+	bool timestampsSupported = false;
+	float timestampPeriod = 1.0f; // ns / tick
+	CullingStats cullingStats{};
+
+	// GPUvt@C (t[Ƃ̃NGv[) CPŰ
+	ProfilerSettings profilerSettings;
+	uint64_t timestampMask = ~0ull; // timestampValidBits
+	double gpuClockOffsetUs = 0.0; // GPU̎(us) +  = profileClockUs()
+	uint64_t frameNumber = 0;
+	vector<VkQueryPool> gpuQueryPools;
+	vector<vector<GpuScope>> gpuScopes;
+	vector<uint64_t> gpuScopeFrames; // NGv[ɋL^t[ԍ
+	vector<ProfileScopeStats> gpuScopeStats;
+	bool pipelineStatisticsSupported = false;
+	vector<VkQueryPool> statsQueryPools; // pXƂ1NG
+	vector<vector<GpuScope>> statsPasses;
+	vector<PipelineStatsPass> pipelineStats;
+	vector<ProfileScopeStats> cpuZoneStats;
+	vector<ProfileEvent> cpuZoneEvents; // collectCpuProfile̍Ɨp
+	deque<ProfileEvent> traceEvents;
+
+	// foCX̊蓖 (allocateMemory / freeMemoryG)
+	unordered_map<VkDeviceMemory, MemoryAllocation> memoryAllocations;
+	array<MemoryUsage, static_cast<size_t>(MemoryCategory::Count)> categoryMemoryUsage{};
+	vector<MemoryUsage> heapMemoryUsage;
+	MemoryUsage totalMemoryUsage{};
+
+	// [xHi-Zs~bh
+	VkFormat depthFormat;
+	VkImage depthImage; // frameGrapḧꎞC[W
+	VkImageView depthImageView;
+	VkImage depthPyramid;
+	VkDeviceMemory depthPyramidMemory;
+	VkImageView depthPyramidView;
+	vector<VkImageView> depthPyramidMips;
+	bool depthPyramidNeedsClear = false; // 蒼̍ŏ̃t[1.0ɖ߂
+
+	// t[̃pXƃ\[XBXbv`F[蒼тɑgݒAt[͎荞ރC[Wւ邾
+	RenderGraph frameGraph;
+	uint32_t frameGraphColor;
+	uint32_t frameGraphDepth;
+	uint32_t frameGraphPyramid;
+	uint32_t frameGraphLatePass; // 񓯊Rs[g̎͂lateCommandBuffersɋL^
+	uint32_t frameImageIndex; // L^̃t[̉摜
+	vector<bool> depthPyramidBindingStale; // JÕfBXNv^ZbgÂs~bhwĂ
+	uint32_t depthPyramidWidth;
+	uint32_t depthPyramidHeight;
+	uint32_t depthPyramidLevels;
+	VkSampler depthPyramidSampler;
+	VkDescriptorSetLayout depthReduceSetLayout;
+	VkPipelineLayout depthReducePipelineLayout;
+	VkPipeline depthReducePipeline;
+	VkDescriptorPool depthPyramidDescriptorPool;
+	vector<VkDescriptorSet> depthReduceSets;
+	chrono::steady_clock::time_point lastStatsReport;
+	VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+	glm::mat4 meshDequantize = glm::mat4(1.0f); // snorm16̈ʒu -> bV
+	glm::vec4 meshBounds = glm::vec4(0.0f); // bVԂ̋E
+	string modelPath = MODEL_PATH;
+	uint64_t modelSourceSize = 0; // ǂݍ񂾂Ƃ̃t@C̑傫ƍXV
+	int64_t modelSourceTime = 0;
+	chrono::steady_clock::time_point lastModelCheck;
+
+
 	vector<const char*> validationLayers = {
 		"VK_LAYER_KHRONOS_validation"
 	};
@@ -230,10 +936,10 @@ private:
 	};
 
 	vector<Vertex> vertices{
-		{{-0.5f,-0.5f},{1.0f,0.0f,0.0f}, {1.0f, 0.0f}},
-		{{0.5f,-0.5f},{0.0f,1.0f,0.0f}, {0.0f, 0.0f}},
-		{{0.5f,0.5f},{0.0f,0.0f,1.0f}, {0.0f, 1.0f}},
-		{{-0.5f,0.5f},{1.0f,1.0f,1.0f}, {1.0f, 1.0f}}
+		{{-0.5f,-0.5f,0.0f},{1.0f,0.0f,0.0f}, {1.0f, 0.0f}},
+		{{0.5f,-0.5f,0.0f},{0.0f,1.0f,0.0f}, {0.0f, 0.0f}},
+		{{0.5f,0.5f,0.0f},{0.0f,0.0f,1.0f}, {0.0f, 1.0f}},
+		{{-0.5f,0.5f,0.0f},{1.0f,1.0f,1.0f}, {1.0f, 1.0f}}
 	};
 
 	vector<uint32_t>indices{
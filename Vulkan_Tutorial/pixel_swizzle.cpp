@@ -0,0 +1,37 @@
+#include "pixel_swizzle.hpp"
+
+#if defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define PIXEL_SWIZZLE_SSE2
+#include <emmintrin.h>
+#endif
+
+// gGfBẢf 0xAARRGGBB -> 0xAABBGGRR
+static uint32_t swapRedBlue(uint32_t pixel)
+{
+	uint32_t rb = pixel & 0x00FF00FFu;
+	return (pixel & 0xFF00FF00u) | (rb << 16) | (rb >> 16);
+}
+
+void swizzleBgraToRgba(const uint8_t* pSrc, uint8_t* pDst, size_t pixelCount)
+{
+	size_t i = 0;
+#ifdef PIXEL_SWIZZLE_SSE2
+	// SSSE3pshufbg킸ɃVtgƃ}XNœւ (SSE2œ)
+	const __m128i rbMask = _mm_set1_epi32(0x00FF00FF);
+	const __m128i agMask = _mm_set1_epi32(static_cast<int>(0xFF00FF00u));
+	for (; i + 4 <= pixelCount; i += 4)
+	{
+		__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 4));
+		__m128i rb = _mm_and_si128(pixels, rbMask);
+		__m128i swapped = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 4), _mm_or_si128(_mm_and_si128(pixels, agMask), swapped));
+	}
+#endif
+	for (; i < pixelCount; i++)
+	{
+		uint32_t pixel;
+		memcpy(&pixel, pSrc + i * 4, sizeof(pixel));
+		pixel = swapRedBlue(pixel);
+		memcpy(pDst + i * 4, &pixel, sizeof(pixel));
+	}
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "my_vulkan.hpp"
+
+// BGRA8 -> RGBA8 (RBւ)BpSrcpDst͓ł悢
+// x86łSSE24fAȊO1f
+void swizzleBgraToRgba(const uint8_t* pSrc, uint8_t* pDst, size_t pixelCount);
@@ -0,0 +1,220 @@
+#include "profiler.hpp"
+
+#include <atomic>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+
+double profileClockUs()
+{
+	return static_cast<double>(profileClockNs()) / 1000.0;
+}
+
+void addProfileSample(vector<ProfileScopeStats>* pStats, const char* name, double ms, size_t window)
+{
+	auto it = find_if(pStats->begin(), pStats->end(), [&](const ProfileScopeStats& stats) { return strcmp(stats.name, name) == 0; });
+	if (it == pStats->end())
+	{
+		pStats->push_back({ name, {} });
+		it = pStats->end() - 1;
+	}
+	it->samples.push_back(ms);
+	if (it->samples.size() > window)
+	{
+		it->samples.pop_front();
+	}
+}
+
+double profilePercentile(vector<double> samples, double fraction)
+{
+	if (samples.empty())
+	{
+		return 0.0;
+	}
+	size_t index = min(samples.size() - 1, static_cast<size_t>(samples.size() * fraction));
+	nth_element(samples.begin(), samples.begin() + index, samples.end());
+	return samples[index];
+}
+
+bool summarizeProfileScope(const ProfileScopeStats& stats, double* pMinMs, double* pAvgMs, double* pP99Ms)
+{
+	if (stats.samples.empty())
+	{
+		return false;
+	}
+	vector<double> samples(stats.samples.begin(), stats.samples.end());
+	*pMinMs = *min_element(samples.begin(), samples.end());
+	double sum = 0.0;
+	for (double ms : samples)
+	{
+		sum += ms;
+	}
+	*pAvgMs = sum / samples.size();
+	*pP99Ms = profilePercentile(move(samples), 0.99);
+	return true;
+}
+
+void writeJsonString(ostream& file, const char* text)
+{
+	file << '"';
+	for (const char* p = text; *p != '\0'; p++)
+	{
+		char c = *p;
+		if (c == '"' || c == '\\')
+		{
+			file << '\\' << c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20)
+		{
+			file << "\\u" << hex << setw(4) << setfill('0') << static_cast<int>(c) << dec << setfill(' ');
+		}
+		else
+		{
+			file << c;
+		}
+	}
+	file << '"';
+}
+
+void writeChromeTrace(const string& path, const vector<ProfileEvent>& events, const vector<pair<uint32_t, string>>& trackNames)
+{
+	ofstream file(path, ios::trunc);
+	if (!file.is_open())
+	{
+		throw runtime_error("failed to create trace: " + path);
+	}
+
+	file << fixed << setprecision(3);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	for (const auto& track : trackNames)
+	{
+		file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track.first << ",\"args\":{\"name\":";
+		writeJsonString(file, track.second.c_str());
+		file << "}}";
+		first = false;
+	}
+	for (const auto& event : events)
+	{
+		file << (first ? "" : ",\n") << "{\"name\":";
+		writeJsonString(file, event.name);
+		file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.track << ",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs
+			<< ",\"args\":{\"frame\":" << event.frame << "}}";
+		first = false;
+	}
+	file << "\n]}\n";
+
+	if (!file)
+	{
+		throw runtime_error("failed to write trace: " + path);
+	}
+}
+
+//=================================================================
+// CPU Zones
+//=================================================================
+
+struct CpuZoneRecord
+{
+	const char* name;
+	int64_t beginNs;
+	int64_t endNs;
+	uint64_t frame;
+};
+
+// ͎̂̃XbhAǂނ̂collectCpuZones (single producer / single consumer)
+struct CpuProfileBuffer
+{
+	uint32_t track;
+	string name;
+	atomic<uint64_t> writeIndex{ 0 };
+	uint64_t readIndex = 0; // collectCpuZonesG
+	vector<CpuZoneRecord> records;
+};
+
+static mutex cpuProfileRegistryMutex; // o^ƉBL^ł͎Ȃ
+static vector<unique_ptr<CpuProfileBuffer>> cpuProfileBuffers;
+static atomic<uint64_t> cpuProfileFrame{ 0 };
+static thread_local CpuProfileBuffer* pThreadProfileBuffer = nullptr;
+
+int64_t profileClockNs()
+{
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void setProfileFrame(uint64_t frame)
+{
+	cpuProfileFrame.store(frame, memory_order_relaxed);
+}
+
+static CpuProfileBuffer* threadProfileBuffer()
+{
+	if (pThreadProfileBuffer == nullptr)
+	{
+		auto buffer = make_unique<CpuProfileBuffer>();
+		buffer->records.resize(CPU_PROFILER_BUFFER_SIZE);
+		lock_guard<mutex> lock(cpuProfileRegistryMutex);
+		buffer->track = static_cast<uint32_t>(cpuProfileBuffers.size()) + PROFILE_TRACK_GPU_COMPUTE + 1;
+		buffer->name = "CPU thread " + to_string(buffer->track);
+		pThreadProfileBuffer = buffer.get();
+		cpuProfileBuffers.push_back(move(buffer)); // XbhIĂc
+	}
+	return pThreadProfileBuffer;
+}
+
+void setProfileThreadName(const string& name)
+{
+	CpuProfileBuffer* pBuffer = threadProfileBuffer();
+	lock_guard<mutex> lock(cpuProfileRegistryMutex);
+	pBuffer->name = name;
+}
+
+void recordCpuZone(const char* name, int64_t beginNs, int64_t endNs)
+{
+	CpuProfileBuffer* pBuffer = threadProfileBuffer();
+	uint64_t index = pBuffer->writeIndex.load(memory_order_relaxed);
+	pBuffer->records[index & (CPU_PROFILER_BUFFER_SIZE - 1)] = { name, beginNs, endNs, cpuProfileFrame.load(memory_order_relaxed) };
+	pBuffer->writeIndex.store(index + 1, memory_order_release);
+}
+
+void collectCpuZones(vector<ProfileEvent>* pEvents)
+{
+	lock_guard<mutex> lock(cpuProfileRegistryMutex);
+	for (auto& buffer : cpuProfileBuffers)
+	{
+		uint64_t end = buffer->writeIndex.load(memory_order_acquire);
+		uint64_t begin = max(buffer->readIndex, end > CPU_PROFILER_BUFFER_SIZE ? end - CPU_PROFILER_BUFFER_SIZE : 0);
+		size_t first = pEvents->size();
+		for (uint64_t i = begin; i < end; i++)
+		{
+			const CpuZoneRecord& record = buffer->records[i & (CPU_PROFILER_BUFFER_SIZE - 1)];
+			ProfileEvent event{};
+			event.name = record.name;
+			event.frame = record.frame;
+			event.startUs = static_cast<double>(record.beginNs) / 1000.0;
+			event.durationUs = static_cast<double>(record.endNs - record.beginNs) / 1000.0;
+			event.track = buffer->track;
+			pEvents->push_back(event);
+		}
+
+		// ǂłԂɈĂ͉Ă邩Ȃ
+		uint64_t written = buffer->writeIndex.load(memory_order_acquire);
+		if (written > CPU_PROFILER_BUFFER_SIZE && written - CPU_PROFILER_BUFFER_SIZE > begin)
+		{
+			uint64_t overwritten = min(written - CPU_PROFILER_BUFFER_SIZE, end) - begin;
+			pEvents->erase(pEvents->begin() + first, pEvents->begin() + first + static_cast<size_t>(overwritten));
+		}
+		buffer->readIndex = end;
+	}
+}
+
+vector<pair<uint32_t, string>> cpuProfileTracks()
+{
+	lock_guard<mutex> lock(cpuProfileRegistryMutex);
+	vector<pair<uint32_t, string>> tracks;
+	for (const auto& buffer : cpuProfileBuffers)
+	{
+		tracks.push_back({ buffer->track, buffer->name });
+	}
+	return tracks;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "my_vulkan.hpp"
+
+// CPUGPŰԂ𓯂Ԏ (steady_clock̃}CNb) ɕׁAvChrome traceo
+const uint32_t PROFILE_TRACK_GPU = 0; // GPŨOtBbNXL[
+const uint32_t PROFILE_TRACK_GPU_COMPUTE = 1; // GPU̔񓯊Rs[gL[BCPŨXbh2
+
+double profileClockUs(); // profileClockNs() / 1000
+
+// OƂɒwindow̃TvcBname͒gŔׂ (񃊃eAhXƂ͌Ȃ)
+void addProfileSample(vector<ProfileScopeStats>* pStats, const char* name, double ms, size_t window);
+
+// fraction (0..1) ̈ʒu̒l (ŋߖT)BȂ0
+double profilePercentile(vector<double> samples, double fraction);
+
+// ߂̃Tv̍ŏEρE99p[Z^CBTvfalse
+bool summarizeProfileScope(const ProfileScopeStats& stats, double* pMinMs, double* pAvgMs, double* pP99Ms);
+
+void writeJsonString(ostream& out, const char* text);
+
+// chrome://tracing  Perfetto ŊJ`ŏBsruntime_error𓊂
+void writeChromeTrace(const string& path, const vector<ProfileEvent>& events, const vector<pair<uint32_t, string>>& trackNames);
+
+//=================================================================
+// CPU Zones
+//=================================================================
+
+// 0ɂPROFILE_ZONE͉Ȃ (vWFNg̃vvZbT` ENABLE_CPU_PROFILER=0)
+#ifndef ENABLE_CPU_PROFILER
+#define ENABLE_CPU_PROFILER 1
+#endif
+
+const size_t CPU_PROFILER_BUFFER_SIZE = 1 << 16; // XbhƂ̃ŐԐ (2ׂ̂)
+
+int64_t profileClockNs();
+
+// ꂩL^Ԃ̃t[ԍ
+void setProfileFrame(uint64_t frame);
+
+// Ă񂾃Xbh̃g[X̖O (ŏ̋ԂOɌĂ)
+void setProfileThreadName(const string& name);
+
+// Ă񂾃Xbh̃obt@ɏBbN͎Ȃ (Xbh̍ŏ1񂾂o^ŃbN)
+void recordCpuZone(const char* name, int64_t beginNs, int64_t endNs);
+
+// SXbh̃obt@Oȍ~̋ԂoBĂrŏ㏑ꂽԂ͎̂Ă
+void collectCpuZones(vector<ProfileEvent>* pEvents);
+
+// o^ς݃Xbh̃gbNԍƖO
+vector<pair<uint32_t, string>> cpuProfileTracks();
+
+// XR[v̎n߂I܂ł1ԂƂċL^
+class CpuZone
+{
+public:
+	explicit CpuZone(const char* name) : name(name), beginNs(profileClockNs()) {}
+	~CpuZone() { recordCpuZone(name, beginNs, profileClockNs()); }
+	CpuZone(const CpuZone&) = delete;
+	CpuZone& operator=(const CpuZone&) = delete;
+private:
+	const char* name;
+	int64_t beginNs;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#if ENABLE_CPU_PROFILER
+#define PROFILE_ZONE(name) CpuZone PROFILE_CONCAT(cpuZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
@@ -0,0 +1,503 @@
+#include "render_graph.hpp"
+
+struct RenderGraphAccessInfo
+{
+	VkPipelineStageFlags stages;
+	VkAccessFlags access;
+	VkImageLayout layout; // obt@ł͎gȂ
+};
+
+const VkAccessFlags RENDER_GRAPH_WRITE_ACCESS = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+	VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+static RenderGraphAccessInfo accessInfo(RenderGraphAccess access)
+{
+	switch (access)
+	{
+	case RenderGraphAccess::Acquire:
+		return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED };
+	case RenderGraphAccess::IndirectRead:
+		return { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED };
+	case RenderGraphAccess::VertexRead:
+		return { VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED };
+	case RenderGraphAccess::ComputeRead:
+		return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL };
+	case RenderGraphAccess::ComputeWrite:
+		return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL };
+	case RenderGraphAccess::ComputeReadWrite:
+		return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL };
+	case RenderGraphAccess::ComputeSampled:
+		return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+	case RenderGraphAccess::ColorAttachment:
+		return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+	case RenderGraphAccess::DepthAttachment:
+		return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+	case RenderGraphAccess::TransferRead:
+		return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL };
+	case RenderGraphAccess::TransferWrite:
+		return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL };
+	case RenderGraphAccess::HostRead:
+		return { VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT, VK_IMAGE_LAYOUT_GENERAL };
+	case RenderGraphAccess::Present:
+		return { VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR };
+	default:
+		return { 0, 0, VK_IMAGE_LAYOUT_UNDEFINED };
+	}
+}
+
+static bool isWriteAccess(RenderGraphAccess access)
+{
+	return (accessInfo(access).access & RENDER_GRAPH_WRITE_ACCESS) != 0;
+}
+
+// compileRenderGraphǂ\[X̏
+struct RenderGraphState
+{
+	VkPipelineStageFlags writeStages; // Ō݂̏CAEgJ
+	VkAccessFlags writeAccess;
+	VkPipelineStageFlags readStages; // ̌̓ǂݍ (݂̏҂)
+	VkPipelineStageFlags visibleStages; // Ō݂̏悤ɂȂXe[WƃANZX
+	VkAccessFlags visibleAccess;
+	VkImageLayout layout;
+};
+
+static RenderGraphState initialState(RenderGraphAccess previous)
+{
+	RenderGraphAccessInfo info = accessInfo(previous);
+	RenderGraphState state{};
+	if (info.access != 0 && !isWriteAccess(previous))
+	{
+		state.readStages = info.stages;
+	}
+	else
+	{
+		// Acquire̓ANZXA擾̃Z}tH҂Xe[Wn߂
+		state.writeStages = info.stages;
+		state.writeAccess = info.access & RENDER_GRAPH_WRITE_ACCESS;
+	}
+	state.layout = info.layout;
+	return state;
+}
+
+// accessɕKvȓpBarrierɑAԂi߂
+static void addAccess(const RenderGraphResource& resource, uint32_t index, RenderGraphAccess access, RenderGraphState* pState,
+	RenderGraphBarrier* pBarrier)
+{
+	RenderGraphAccessInfo info = accessInfo(access);
+	RenderGraphState& state = *pState;
+	bool write = isWriteAccess(access);
+	bool transition = resource.image && info.layout != state.layout;
+
+	if (write || transition)
+	{
+		// ݂ƃCAEgJڂ͑Ȍ݂Ɠǂݍ݂S҂
+		VkPipelineStageFlags srcStages = state.writeStages | state.readStages;
+		if (srcStages != 0 || transition)
+		{
+			pBarrier->srcStages |= srcStages;
+			pBarrier->dstStages |= info.stages;
+			if (transition)
+			{
+				pBarrier->images.push_back({ index, state.writeAccess, info.access, state.layout, info.layout });
+			}
+			else
+			{
+				pBarrier->srcAccess |= state.writeAccess;
+				pBarrier->dstAccess |= info.access;
+			}
+		}
+		state.writeStages = info.stages;
+		state.writeAccess = info.access & RENDER_GRAPH_WRITE_ACCESS;
+		state.readStages = write ? 0 : info.stages;
+		state.visibleStages = write ? 0 : info.stages;
+		state.visibleAccess = write ? 0 : info.access;
+		if (resource.image)
+		{
+			state.layout = info.layout;
+		}
+		return;
+	}
+
+	// ǂݍ݂́AŌ݂̏܂ĂȂXe[WEANZX̎҂
+	if (state.writeStages != 0 && ((info.stages & ~state.visibleStages) != 0 || (info.access & ~state.visibleAccess) != 0))
+	{
+		pBarrier->srcStages |= state.writeStages;
+		pBarrier->dstStages |= info.stages;
+		pBarrier->srcAccess |= state.writeAccess;
+		pBarrier->dstAccess |= info.access;
+		state.visibleStages |= info.stages;
+		state.visibleAccess |= info.access;
+	}
+	state.readStages |= info.stages;
+}
+
+static uint32_t addResource(RenderGraph* pGraph, const RenderGraphResource& resource)
+{
+	pGraph->resources.push_back(resource);
+	return static_cast<uint32_t>(pGraph->resources.size() - 1);
+}
+
+uint32_t addRenderGraphImage(RenderGraph* pGraph, const char* name, VkImageAspectFlags aspect, RenderGraphAccess previous)
+{
+	RenderGraphResource resource{};
+	resource.name = name;
+	resource.image = true;
+	resource.aspect = aspect;
+	resource.previous = previous;
+	return addResource(pGraph, resource);
+}
+
+uint32_t addRenderGraphBuffer(RenderGraph* pGraph, const char* name, RenderGraphAccess previous)
+{
+	RenderGraphResource resource{};
+	resource.name = name;
+	resource.previous = previous;
+	return addResource(pGraph, resource);
+}
+
+uint32_t addRenderGraphTransientImage(RenderGraph* pGraph, const char* name, const VkImageCreateInfo& imageInfo, VkImageAspectFlags aspect)
+{
+	RenderGraphResource resource{};
+	resource.name = name;
+	resource.image = true;
+	resource.transient = true;
+	resource.imageInfo = imageInfo;
+	resource.aspect = aspect;
+	resource.previous = RenderGraphAccess::None; // O̒g͗vȂ (҂̂createRenderGraphTransientső)
+	return addResource(pGraph, resource);
+}
+
+uint32_t addRenderGraphPass(RenderGraph* pGraph, const char* name, const vector<RenderGraphUse>& uses, function<void(VkCommandBuffer)> record)
+{
+	for (size_t i = 0; i < uses.size(); i++)
+	{
+		if (uses[i].resource >= pGraph->resources.size())
+		{
+			throw runtime_error(string("unknown render graph resource in pass ") + name);
+		}
+		for (size_t j = 0; j < i; j++)
+		{
+			if (uses[j].resource == uses[i].resource)
+			{
+				throw runtime_error(string("render graph pass ") + name + " uses " + pGraph->resources[uses[i].resource].name + " twice");
+			}
+		}
+	}
+
+	RenderGraphPass pass{};
+	pass.name = name;
+	pass.uses = uses;
+	pass.record = move(record);
+	pGraph->passes.push_back(move(pass));
+	return static_cast<uint32_t>(pGraph->passes.size() - 1);
+}
+
+void setRenderGraphOutput(RenderGraph* pGraph, uint32_t resource, RenderGraphAccess finalAccess)
+{
+	pGraph->resources[resource].output = true;
+	pGraph->resources[resource].finalAccess = finalAccess;
+}
+
+void compileRenderGraph(RenderGraph* pGraph)
+{
+	RenderGraph& graph = *pGraph;
+	vector<RenderGraphResource>& resources = graph.resources;
+
+	// 납: Ă郊\[XɏpXcÃpXg\[X
+	vector<bool> live(resources.size(), false);
+	for (size_t r = 0; r < resources.size(); r++)
+	{
+		live[r] = resources[r].output;
+	}
+	graph.culledPasses = 0;
+	for (size_t p = graph.passes.size(); p-- > 0;)
+	{
+		RenderGraphPass& pass = graph.passes[p];
+		pass.culled = true;
+		for (const auto& use : pass.uses)
+		{
+			if (live[use.resource] && isWriteAccess(use.access))
+			{
+				pass.culled = false;
+			}
+		}
+		if (pass.culled)
+		{
+			graph.culledPasses++;
+			continue;
+		}
+		for (const auto& use : pass.uses)
+		{
+			live[use.resource] = true;
+		}
+	}
+
+	// O: ԂǂĊepX̑ÕoA܂Ƃ߂
+	vector<RenderGraphState> states(resources.size());
+	for (size_t r = 0; r < resources.size(); r++)
+	{
+		states[r] = initialState(resources[r].previous);
+		resources[r].firstPass = UINT32_MAX;
+		resources[r].lastPass = 0;
+	}
+	graph.barrierCount = 0;
+	graph.imageTransitionCount = 0;
+	auto countBarrier = [&](const RenderGraphBarrier& barrier)
+	{
+		if (barrier.dstStages != 0)
+		{
+			graph.barrierCount++;
+			graph.imageTransitionCount += static_cast<uint32_t>(barrier.images.size());
+		}
+	};
+	for (uint32_t p = 0; p < graph.passes.size(); p++)
+	{
+		RenderGraphPass& pass = graph.passes[p];
+		pass.barrier = {};
+		if (pass.culled)
+		{
+			continue;
+		}
+		for (const auto& use : pass.uses)
+		{
+			RenderGraphResource& resource = resources[use.resource];
+			resource.firstPass = min(resource.firstPass, p);
+			resource.lastPass = p;
+			addAccess(resource, use.resource, use.access, &states[use.resource], &pass.barrier);
+		}
+		countBarrier(pass.barrier);
+	}
+
+	graph.finalBarrier = {};
+	for (uint32_t r = 0; r < resources.size(); r++)
+	{
+		if (resources[r].output && resources[r].finalAccess != RenderGraphAccess::None)
+		{
+			addAccess(resources[r], r, resources[r].finalAccess, &states[r], &graph.finalBarrier);
+		}
+		resources[r].endStages = states[r].writeStages | states[r].readStages;
+		resources[r].endAccess = states[r].writeAccess;
+	}
+	countBarrier(graph.finalBarrier);
+}
+
+// ꎞC[Ŵ܂Ƃ܂Bo[͑S̐擪ɒu
+struct RenderGraphMemoryBlock
+{
+	VkMemoryRequirements requirements;
+	vector<uint32_t> resources;
+};
+
+// 傫ɁAdȂ炸̎ނŏ̂܂Ƃ܂ɓ (gȂ̂͂ǂƂdȂȂ)
+static vector<RenderGraphMemoryBlock> packTransients(const RenderGraph& graph, vector<uint32_t> transients,
+	const vector<VkMemoryRequirements>& requirements)
+{
+	const vector<RenderGraphResource>& resources = graph.resources;
+	auto overlaps = [&](uint32_t a, uint32_t b)
+	{
+		return resources[a].firstPass != UINT32_MAX && resources[b].firstPass != UINT32_MAX &&
+			resources[a].firstPass <= resources[b].lastPass && resources[b].firstPass <= resources[a].lastPass;
+	};
+	sort(transients.begin(), transients.end(), [&](uint32_t a, uint32_t b) { return requirements[a].size > requirements[b].size; });
+	vector<RenderGraphMemoryBlock> blocks;
+	for (uint32_t r : transients)
+	{
+		size_t block = 0;
+		for (; block < blocks.size(); block++)
+		{
+			bool fits = (blocks[block].requirements.memoryTypeBits & requirements[r].memoryTypeBits) != 0;
+			for (uint32_t other : blocks[block].resources)
+			{
+				fits = fits && !overlaps(r, other);
+			}
+			if (fits)
+			{
+				break;
+			}
+		}
+		if (block == blocks.size())
+		{
+			blocks.push_back({ requirements[r], {} });
+		}
+		VkMemoryRequirements& blockReq = blocks[block].requirements;
+		blockReq.size = max(blockReq.size, requirements[r].size);
+		blockReq.alignment = max(blockReq.alignment, requirements[r].alignment);
+		blockReq.memoryTypeBits &= requirements[r].memoryTypeBits;
+		blocks[block].resources.push_back(r);
+	}
+	return blocks;
+}
+
+// ŏɎgpX́AOɎgC[W (擪͑Õt[̍Ō̂) ̍Ō̃ANZX҂
+static void addAliasingBarriers(RenderGraph* pGraph, const RenderGraphMemoryBlock& block)
+{
+	RenderGraph& graph = *pGraph;
+	vector<uint32_t> members;
+	for (uint32_t r : block.resources)
+	{
+		if (graph.resources[r].firstPass != UINT32_MAX)
+		{
+			members.push_back(r);
+		}
+	}
+	sort(members.begin(), members.end(), [&](uint32_t a, uint32_t b) { return graph.resources[a].firstPass < graph.resources[b].firstPass; });
+	for (size_t i = 0; i < members.size(); i++)
+	{
+		const RenderGraphResource& previous = graph.resources[members[(i + members.size() - 1) % members.size()]];
+		RenderGraphBarrier& barrier = graph.passes[graph.resources[members[i]].firstPass].barrier;
+		barrier.srcStages |= previous.endStages;
+		for (auto& image : barrier.images)
+		{
+			if (image.resource == members[i])
+			{
+				image.srcAccess |= previous.endAccess;
+			}
+		}
+	}
+}
+
+void createRenderGraphTransients(RenderGraph* pGraph, VkDevice device,
+	const function<void(const VkMemoryRequirements&, VkDeviceMemory*)>& allocate)
+{
+	RenderGraph& graph = *pGraph;
+	vector<RenderGraphResource>& resources = graph.resources;
+
+	vector<uint32_t> transients;
+	vector<VkMemoryRequirements> requirements(resources.size());
+	graph.transientBytes = 0;
+	for (uint32_t r = 0; r < resources.size(); r++)
+	{
+		if (!resources[r].transient)
+		{
+			continue;
+		}
+		if (vkCreateImage(device, &resources[r].imageInfo, nullptr, &resources[r].handle) != VK_SUCCESS)
+		{
+			throw runtime_error(string("failed to create transient image: ") + resources[r].name);
+		}
+		vkGetImageMemoryRequirements(device, resources[r].handle, &requirements[r]);
+		graph.transientBytes += requirements[r].size;
+		transients.push_back(r);
+	}
+
+	graph.transientAllocatedBytes = 0;
+	for (const auto& block : packTransients(graph, transients, requirements))
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		allocate(block.requirements, &memory);
+		graph.transientMemory.push_back(memory);
+		graph.transientAllocatedBytes += block.requirements.size;
+		for (uint32_t r : block.resources)
+		{
+			vkBindImageMemory(device, resources[r].handle, memory, 0);
+		}
+		addAliasingBarriers(pGraph, block);
+	}
+}
+
+void checkRenderGraphAliasing()
+{
+	// a [0,1]  b [2,3] ͏dȂȂ̂œAc [1,2] ͗ƏdȂ̂ŕʂ̃ɂȂ͂
+	RenderGraph graph;
+	VkImageCreateInfo imageInfo{};
+	uint32_t a = addRenderGraphTransientImage(&graph, "a", imageInfo, VK_IMAGE_ASPECT_COLOR_BIT);
+	uint32_t b = addRenderGraphTransientImage(&graph, "b", imageInfo, VK_IMAGE_ASPECT_COLOR_BIT);
+	uint32_t c = addRenderGraphTransientImage(&graph, "c", imageInfo, VK_IMAGE_ASPECT_COLOR_BIT);
+	uint32_t out = addRenderGraphBuffer(&graph, "out", RenderGraphAccess::None);
+	auto none = [](VkCommandBuffer) {};
+	addRenderGraphPass(&graph, "write a", { { a, RenderGraphAccess::ColorAttachment } }, none);
+	addRenderGraphPass(&graph, "read a", { { a, RenderGraphAccess::ComputeSampled }, { c, RenderGraphAccess::ComputeWrite } }, none);
+	addRenderGraphPass(&graph, "write b", { { c, RenderGraphAccess::ComputeRead }, { b, RenderGraphAccess::ColorAttachment } }, none);
+	addRenderGraphPass(&graph, "read b", { { b, RenderGraphAccess::ComputeSampled }, { out, RenderGraphAccess::ComputeWrite } }, none);
+	setRenderGraphOutput(&graph, out, RenderGraphAccess::None);
+	compileRenderGraph(&graph);
+
+	vector<VkMemoryRequirements> requirements(graph.resources.size());
+	requirements[a] = { 4 << 20, 256, 1 };
+	requirements[b] = { 4 << 20, 256, 1 };
+	requirements[c] = { 1 << 20, 256, 1 };
+	vector<RenderGraphMemoryBlock> blocks = packTransients(graph, { a, b, c }, requirements);
+	bool shared = blocks.size() == 2 && blocks[0].resources.size() == 2 && blocks[1].resources == vector<uint32_t>{ c };
+	if (!shared)
+	{
+		throw runtime_error("render graph aliasing check: transients with disjoint lifetimes do not share memory");
+	}
+
+	for (const auto& block : blocks)
+	{
+		addAliasingBarriers(&graph, block);
+	}
+	// báÃt[ab̍Ō̃ANZX҂
+	auto waits = [&](uint32_t resource, uint32_t previous)
+	{
+		const RenderGraphBarrier& barrier = graph.passes[graph.resources[resource].firstPass].barrier;
+		bool access = false;
+		for (const auto& image : barrier.images)
+		{
+			access |= image.resource == resource && (image.srcAccess & graph.resources[previous].endAccess) == graph.resources[previous].endAccess;
+		}
+		return access && (barrier.srcStages & graph.resources[previous].endStages) == graph.resources[previous].endStages;
+	};
+	if (!waits(b, a) || !waits(a, b))
+	{
+		throw runtime_error("render graph aliasing check: missing barrier between aliased transients");
+	}
+}
+
+static void recordBarrier(const RenderGraph& graph, const RenderGraphBarrier& barrier, VkCommandBuffer commandBuffer)
+{
+	if (barrier.dstStages == 0)
+	{
+		return;
+	}
+
+	VkMemoryBarrier memoryBarrier{};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.srcAccessMask = barrier.srcAccess;
+	memoryBarrier.dstAccessMask = barrier.dstAccess;
+	uint32_t memoryBarrierCount = (barrier.srcAccess | barrier.dstAccess) != 0 ? 1 : 0;
+
+	array<VkImageMemoryBarrier, 8> imageBarriers{};
+	if (barrier.images.size() > imageBarriers.size())
+	{
+		throw runtime_error("too many image transitions in one render graph barrier");
+	}
+	for (size_t i = 0; i < barrier.images.size(); i++)
+	{
+		const RenderGraphImageTransition& transition = barrier.images[i];
+		const RenderGraphResource& resource = graph.resources[transition.resource];
+		VkImageMemoryBarrier& imageBarrier = imageBarriers[i];
+		imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageBarrier.srcAccessMask = transition.srcAccess;
+		imageBarrier.dstAccessMask = transition.dstAccess;
+		imageBarrier.oldLayout = transition.oldLayout;
+		imageBarrier.newLayout = transition.newLayout;
+		imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.image = resource.handle;
+		imageBarrier.subresourceRange = { resource.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+	}
+
+	vkCmdPipelineBarrier(commandBuffer, barrier.srcStages != 0 ? barrier.srcStages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT), barrier.dstStages, 0,
+		memoryBarrierCount, &memoryBarrier, 0, nullptr, static_cast<uint32_t>(barrier.images.size()), imageBarriers.data());
+}
+
+void recordRenderGraph(const RenderGraph& graph, VkCommandBuffer commandBuffer, uint32_t firstPass, uint32_t endPass)
+{
+	for (uint32_t p = firstPass; p < endPass; p++)
+	{
+		const RenderGraphPass& pass = graph.passes[p];
+		if (pass.culled)
+		{
+			continue;
+		}
+		recordBarrier(graph, pass.barrier, commandBuffer);
+		pass.record(commandBuffer);
+	}
+	if (endPass == graph.passes.size())
+	{
+		recordBarrier(graph, graph.finalBarrier, commandBuffer);
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "my_vulkan.hpp"
+
+// pXǂݏ郊\[X錾đgݗāAcompileRenderGraphŃpXԂ̃oA߂
+// pX̒̓ (~bvx̊ԂȂ) ͍܂ŒʂpXgL^
+
+// OnC[W (Xbv`F[Ȃ)Bhandle͋L^̑Oɐݒ肷
+uint32_t addRenderGraphImage(RenderGraph* pGraph, const char* name, VkImageAspectFlags aspect, RenderGraphAccess previous);
+// obt@̓oAł܂Ƃ߂ē̂Ńnh͗vȂ
+uint32_t addRenderGraphBuffer(RenderGraph* pGraph, const char* name, RenderGraphAccess previous);
+// t[̒ŎgC[WBcreateRenderGraphTransientsō
+uint32_t addRenderGraphTransientImage(RenderGraph* pGraph, const char* name, const VkImageCreateInfo& imageInfo, VkImageAspectFlags aspect);
+uint32_t addRenderGraphPass(RenderGraph* pGraph, const char* name, const vector<RenderGraphUse>& uses, function<void(VkCommandBuffer)> record);
+// finalAccessNoneȂJڂɎc (̃t[ǂނ̂Ȃ)
+void setRenderGraphOutput(RenderGraph* pGraph, uint32_t resource, RenderGraphAccess finalAccess);
+
+// o͂ɌȂpXAepX̑ÕoAƈꎞC[W̎߂
+void compileRenderGraph(RenderGraph* pGraph);
+// compileRenderGrapȟ1ĂԁB̏dȂȂꎞC[W𓯂ɒuA܂Ƃ܂育ƂallocateŊmۂ
+void createRenderGraphTransients(RenderGraph* pGraph, VkDevice device,
+	const function<void(const VkMemoryRequirements&, VkDeviceMemory*)>& allocate);
+// ̏dȂȂ2̈ꎞC[WɒuÂ̂Ô̂҂foCXŊm߂BႦΓ
+void checkRenderGraphAliasing();
+// [firstPass, endPass) ̃pXoAƈꏏɋL^BendPassŌȂo͂̑JڂL^
+void recordRenderGraph(const RenderGraph& graph, VkCommandBuffer commandBuffer, uint32_t firstPass, uint32_t endPass);
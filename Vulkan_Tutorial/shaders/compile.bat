@@ -1,3 +1,6 @@
 C:/VulkanSDK/1.3.268.0/Bin/glslc.exe shader.vert -o vert.spv
 C:/VulkanSDK/1.3.268.0/Bin/glslc.exe shader.frag -o frag.spv
+C:/VulkanSDK/1.3.268.0/Bin/glslc.exe cull.comp -o cull.spv
+C:/VulkanSDK/1.3.268.0/Bin/glslc.exe depth_reduce.comp -o depth_reduce.spv
+C:/VulkanSDK/1.3.268.0/Bin/glslc.exe cluster_cull.comp -o cluster_cull.spv
 pause
\ No newline at end of file
@@ -1,6 +1,6 @@
 #version 450
 
-layout(location = 0) in vec2 inPosition;
+layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
 
@@ -15,9 +15,30 @@ layout(binding = 0) uniform UniformBufferObject
 	mat4 proj;
 }ubo;
 
+struct ObjectData
+{
+	mat4 model;
+	vec4 boundingSphere;
+	uint meshIndex;
+	uint padding0;
+	uint padding1;
+	uint padding2;
+};
+
+layout(std430, binding = 2) readonly buffer ObjectBuffer
+{
+	ObjectData objects[];
+};
+
+layout(std430, binding = 3) readonly buffer VisibleInstanceBuffer
+{
+	uint visibleInstances[];
+};
+
 void main()
 {
-	gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 0.0, 1.0);
+	mat4 objectModel = objects[visibleInstances[gl_InstanceIndex]].model;
+	gl_Position = ubo.proj * ubo.view * ubo.model * objectModel * vec4(inPosition, 1.0);
 	fragColor = inColor;
 	fragTexCoord = inTexCoord;
 }
\ No newline at end of file
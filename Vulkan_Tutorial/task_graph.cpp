@@ -0,0 +1,221 @@
+#include "task_graph.hpp"
+
+#include <condition_variable>
+#include <mutex>
+
+// ˑԍɒAg|WJԂBmȂOzruntime_error
+static vector<size_t> sortTaskGraph(const vector<TaskGraphNode>& nodes, vector<vector<size_t>>* pDependencies,
+	vector<vector<size_t>>* pDependents)
+{
+	unordered_map<string, size_t> indices;
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		if (!indices.emplace(nodes[i].name, i).second)
+		{
+			throw runtime_error(string("duplicate task: ") + nodes[i].name);
+		}
+	}
+
+	pDependencies->assign(nodes.size(), {});
+	pDependents->assign(nodes.size(), {});
+	vector<size_t> remaining(nodes.size(), 0);
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		for (const char* dependency : nodes[i].dependencies)
+		{
+			auto it = indices.find(dependency);
+			if (it == indices.end())
+			{
+				throw runtime_error(string("unknown dependency of ") + nodes[i].name + ": " + dependency);
+			}
+			(*pDependencies)[i].push_back(it->second);
+			(*pDependents)[it->second].push_back(i);
+			remaining[i]++;
+		}
+	}
+
+	vector<size_t> order;
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		if (remaining[i] == 0)
+		{
+			order.push_back(i);
+		}
+	}
+	for (size_t k = 0; k < order.size(); k++)
+	{
+		for (size_t dependent : (*pDependents)[order[k]])
+		{
+			if (--remaining[dependent] == 0)
+			{
+				order.push_back(dependent);
+			}
+		}
+	}
+	if (order.size() != nodes.size())
+	{
+		throw runtime_error("task graph has a cycle");
+	}
+	return order;
+}
+
+void runTaskGraph(vector<TaskGraphNode>* pNodes, uint32_t threadCount, TaskGraphStats* pStats)
+{
+	vector<TaskGraphNode>& nodes = *pNodes;
+	vector<vector<size_t>> dependencies;
+	vector<vector<size_t>> dependents;
+	vector<size_t> order = sortTaskGraph(nodes, &dependencies, &dependents);
+
+	using clock = chrono::steady_clock;
+	auto start = clock::now();
+	uint32_t workerCount = threadCount > 1 ? threadCount - 1 : 0;
+
+	mutex graphMutex;
+	condition_variable graphChanged;
+	deque<size_t> mainReady;
+	deque<size_t> workerReady;
+	vector<size_t> remaining(nodes.size());
+	size_t finished = 0;
+	size_t running = 0;
+	bool stopping = false;
+	exception_ptr error;
+
+	// [J[ΑSĂ񂾃Xbh̃L[ɓ
+	auto enqueue = [&](size_t i)
+	{
+		(nodes[i].mainThread || workerCount == 0 ? mainReady : workerReady).push_back(i);
+	};
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		remaining[i] = dependencies[i].size();
+		if (remaining[i] == 0)
+		{
+			enqueue(i);
+		}
+	}
+
+	// bNɌĂԁBIˑĂm[hs҂ɓ
+	auto execute = [&](size_t i, uint32_t thread)
+	{
+		TaskGraphNode& node = nodes[i];
+		auto begin = clock::now();
+		exception_ptr nodeError;
+		try
+		{
+			node.run();
+		}
+		catch (...)
+		{
+			nodeError = current_exception();
+		}
+		auto end = clock::now();
+
+		lock_guard<mutex> lock(graphMutex);
+		node.startMs = chrono::duration<double, milli>(begin - start).count();
+		node.durationMs = chrono::duration<double, milli>(end - begin).count();
+		node.thread = thread;
+		running--;
+		finished++;
+		if (nodeError && !error)
+		{
+			error = nodeError;
+		}
+		if (!error)
+		{
+			for (size_t dependent : dependents[i])
+			{
+				if (--remaining[dependent] == 0)
+				{
+					enqueue(dependent);
+				}
+			}
+		}
+		graphChanged.notify_all();
+	};
+
+	vector<thread> workers;
+	for (uint32_t w = 0; w < workerCount; w++)
+	{
+		workers.emplace_back([&, w]()
+		{
+			while (true)
+			{
+				size_t i;
+				{
+					unique_lock<mutex> lock(graphMutex);
+					graphChanged.wait(lock, [&]() { return stopping || (!error && !workerReady.empty()); });
+					if (stopping)
+					{
+						return;
+					}
+					i = workerReady.front();
+					workerReady.pop_front();
+					running++;
+				}
+				execute(i, w + 1);
+			}
+		});
+	}
+
+	// Ă񂾃Xbh͎̃L[sȂASI (sŝ̂I) ܂ő҂
+	while (true)
+	{
+		size_t i;
+		{
+			unique_lock<mutex> lock(graphMutex);
+			graphChanged.wait(lock, [&]()
+			{
+				return error ? running == 0 : (finished == nodes.size() || !mainReady.empty());
+			});
+			if (error || finished == nodes.size())
+			{
+				stopping = true;
+				break;
+			}
+			i = mainReady.front();
+			mainReady.pop_front();
+			running++;
+		}
+		execute(i, 0);
+	}
+	graphChanged.notify_all();
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+	if (error)
+	{
+		rethrow_exception(error);
+	}
+
+	// em[h̏I܂ł̍ŒoH
+	vector<double> pathMs(nodes.size(), 0.0);
+	vector<size_t> previous(nodes.size(), SIZE_MAX);
+	TaskGraphStats stats{};
+	stats.threadCount = workerCount + 1;
+	size_t last = SIZE_MAX;
+	for (size_t i : order)
+	{
+		for (size_t dependency : dependencies[i])
+		{
+			if (pathMs[dependency] > pathMs[i])
+			{
+				pathMs[i] = pathMs[dependency];
+				previous[i] = dependency;
+			}
+		}
+		pathMs[i] += nodes[i].durationMs;
+		stats.workMs += nodes[i].durationMs;
+		stats.wallMs = max(stats.wallMs, nodes[i].startMs + nodes[i].durationMs);
+		if (last == SIZE_MAX || pathMs[i] > pathMs[last])
+		{
+			last = i;
+		}
+	}
+	for (size_t i = last; i != SIZE_MAX; i = previous[i])
+	{
+		stats.criticalPath.insert(stats.criticalPath.begin(), i);
+	}
+	stats.criticalPathMs = last == SIZE_MAX ? 0.0 : pathMs[last];
+	*pStats = stats;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "my_vulkan.hpp"
+
+// ˑ֌Ŵ (̊eiKȂ) AˑÎXbhv[ŕsɎs
+struct TaskGraphNode
+{
+	const char* name;
+	vector<const char*> dependencies; // ɏIĂKv̂m[h̖O
+	bool mainThread; // runTaskGraphĂ񂾃XbhŎs (L[ւ̒oAmہAEBhEȂ)
+	function<void()> run;
+
+	// sɖ܂BrunTaskGraphĂ񂾎ms
+	double startMs = 0.0;
+	double durationMs = 0.0;
+	uint32_t thread = 0; // 0͌Ă񂾃XbhA1烏[J[
+};
+
+struct TaskGraphStats
+{
+	uint32_t threadCount; // Ă񂾃Xbh܂
+	double wallMs; // ĂłŌ̃m[hI܂
+	double workMs; // Sm[h̎Ԃ̍v (Ɏsꍇ̖ڈ)
+	double criticalPathMs; // ˑǂłoHB񉻂ĂwallMs͂ZȂȂ
+	vector<size_t> criticalPath; // m[h̔ԍ (擪珇)
+};
+
+// ˑIm[hsBmainThreadłȂm[hthreadCount - 1̃[J[Ŏs (1ȉȂSĂ񂾃Xbh)
+// mȂˑzΉsruntime_error𓊂
+// m[hO𓊂Vm[h͎n߂Aŝ̂IĂŏ̗O𓊂
+void runTaskGraph(vector<TaskGraphNode>* pNodes, uint32_t threadCount, TaskGraphStats* pStats);